@@ -1,32 +1,102 @@
 # This script generates a test audio signal (WAV file) for testing an ultrasonic 
 # Frequency Shift Keying (FSK) demodulator running on a Daisy Seed microcontroller. 
-# It creates a continuous audio track consisting of a predefined sequence of 
-# binary bits (Mark/Space tones).
+# It creates an audio track of framed packets (preamble, sync word, length,
+# payload, CRC-16) sent as Mark/Space tones, separated by silence.
 import numpy as np
 import scipy.io.wavfile as wav
 
 # Constants matching your Daisy Code
 SAMPLE_RATE = 96000
-BIT_DURATION = 0.5  # 500ms per bit (matches your test speed)
+SYMBOL_DURATION = 0.001  # 1ms per symbol (1000 baud, matches BAUD_RATE)
 MARK_FREQ = 45000    # Logic 1
 SPACE_FREQ = 44000   # Logic 0
 AMPLITUDE = 0.5     # 50% Volume
 
-# This function generates a discrete-time sine wave array 
-# for a given frequency and duration.
-def generate_tone(freq, duration):
-    t = np.linspace(0, duration, int(SAMPLE_RATE * duration), endpoint=False)
-    return AMPLITUDE * np.sin(2 * np.pi * freq * t)
+# Tone table matching TONE_FREQS (2, 4, 8 or 16 tones). Tone k carries the data
+# value whose Gray code is k; two tones is plain binary FSK (SPACE, MARK).
+TONE_FREQS = [SPACE_FREQ, MARK_FREQ]
+BITS_PER_SYMBOL = len(TONE_FREQS).bit_length() - 1
 
-# The message to send: 1, 0, 1, 0, 1, 0...
-bits = [1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0]
+# Framing constants matching library/fsk_packet.h
+PREAMBLE_SYMBOLS = 32
+SYNC_WORD = 0x1ACFFC1D
+CODED = False        # rate-1/2 K=7 convolutional code on length, payload and CRC (matches CODED)
+GAP_DURATION = 0.2   # silence between packets (longer than SILENCE_FLUSH_MS)
+FREQ_OFFSET = 0.0    # shift all tones by this many Hz to exercise the receiver AFC
 
-audio_sequence = []
+# CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), same as FskPacketDecoder::crc16
+def crc16(data, crc=0xFFFF):
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
 
-for bit in bits:
-    freq = MARK_FREQ if bit == 1 else SPACE_FREQ
-    tone = generate_tone(freq, BIT_DURATION)
-    audio_sequence.append(tone)
+# Symbols alternating between 1010... and 0000, the top and bottom tones under
+# the Gray coding (binary: 0xAA, 4-FSK: 0x88, 16-FSK: 0xA0)
+def preamble():
+    bits = [1 if (i // BITS_PER_SYMBOL) % 2 == 0 and (i % BITS_PER_SYMBOL) % 2 == 0 else 0
+            for i in range(PREAMBLE_SYMBOLS * BITS_PER_SYMBOL)]
+    return bits_to_bytes(bits)
+
+# Bytes to bits, most significant bit first
+def to_bits(data):
+    return [(byte >> (7 - i)) & 1 for byte in data for i in range(8)]
+
+# Bits to bytes, most significant bit first, zero padded
+def bits_to_bytes(bits):
+    bits = bits + [0] * (-len(bits) % 8)
+    return bytes(int("".join(map(str, bits[i:i + 8])), 2) for i in range(0, len(bits), 8))
+
+# Rate-1/2, K=7 convolutional code, generators 171 and 133 octal (same as ConvolutionalEncoder):
+# register holds the last six bits plus the new one in bit 0, followed by six zero tail bits
+def convolutional_encode(bits):
+    state = 0
+    out = []
+    for bit in bits + [0] * 6:
+        reg = (state << 1) | bit
+        out.append(bin(reg & 0x4F).count("1") % 2)
+        out.append(bin(reg & 0x6D).count("1") % 2)
+        state = reg & 0x3F
+    return out
+
+# Preamble, sync word, length, payload and CRC as bytes (same as FskPacketDecoder::encodeFrame)
+def encode_frame(payload):
+    body = bytes([len(payload)]) + payload
+    crc = crc16(body)
+    body += bytes([crc >> 8, crc & 0xFF])
+    if CODED:
+        body = bits_to_bytes(convolutional_encode(to_bits(body)))
+    return preamble() + SYNC_WORD.to_bytes(4, "big") + body
+
+# Group bits into symbols (MSB first, zero padded) and map each value to its Gray-coded tone
+def to_tones(bits):
+    bits = bits + [0] * (-len(bits) % BITS_PER_SYMBOL)
+    tones = []
+    for i in range(0, len(bits), BITS_PER_SYMBOL):
+        value = 0
+        for bit in bits[i:i + BITS_PER_SYMBOL]:
+            value = (value << 1) | bit
+        tones.append(TONE_FREQS[value ^ (value >> 1)])
+    return tones
+
+# Continuous-phase FSK: the phase carries over between symbols so there are no clicks
+def modulate(bits):
+    samples_per_symbol = int(SAMPLE_RATE * SYMBOL_DURATION)
+    freqs = np.repeat(to_tones(bits), samples_per_symbol) + FREQ_OFFSET
+    phase = 2 * np.pi * np.cumsum(freqs) / SAMPLE_RATE
+    return AMPLITUDE * np.sin(phase)
+
+# The messages to send
+messages = [b"HELLO", b"ROBOSUB", bytes([0x01, 0x02, 0xFE])]
+
+silence = np.zeros(int(SAMPLE_RATE * GAP_DURATION))
+audio_sequence = [silence]
+
+for message in messages:
+    audio_sequence.append(modulate(to_bits(encode_frame(message))))
+    audio_sequence.append(silence)
 
 # Combine into one seamless audio track
 full_signal = np.concatenate(audio_sequence)
@@ -34,4 +104,4 @@ full_signal = np.concatenate(audio_sequence)
 # Save as WAV file
 wav.write("fsk_test_signal.wav", SAMPLE_RATE, (full_signal * 32767).astype(np.int16))
 
-print(f"Generated 'fsk_test_signal.wav' with {len(bits)} bits.")
\ No newline at end of file
+print(f"Generated 'fsk_test_signal.wav' with {len(messages)} packets.")
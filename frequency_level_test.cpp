@@ -3,6 +3,7 @@
 #include "library/fft_library.h"
 #include <string>
 #include <cmath>
+#include <cstdio>
 #include <vector>
 #include <algorithm>
 
@@ -25,6 +26,10 @@ const float frequencyTolerance = 0.00f;       // Tolerance for frequency detecti
 constexpr int kConsecutiveTriggersNeeded = 2; // Number of consecutive triggers needed to trigger
 const float baseThreshold = 0.1f;             // Base threshold for frequency detection
 
+// Candidate competition pinger frequencies, all read from the same FFT frame
+const float pingerFrequencies[] = {25000.0f, 30000.0f, 35000.0f, 40000.0f};
+constexpr size_t kNumPingers = sizeof(pingerFrequencies) / sizeof(pingerFrequencies[0]);
+
 // Printing
 constexpr int kPrintIntervalMs = 100;         // Print interval
 
@@ -35,6 +40,8 @@ DaisySeed hw;
 
 // FFT 
 static float DSY_SDRAM_BSS fft_input_buffer[kFftSize];
+// The frame owns its transform storage (sized on the first buffer, reused after), so no separate workspace
+static SpectrumFrame spectrumFrame;
 static size_t buffer_write_pos = 0;
 static bool fft_ready_for_processing = false;
 
@@ -48,6 +55,8 @@ float cur_rms_amplitude = 0.0f;
 
 // Frequency detection
 float detectedFrequencyLevel = 0.0f;
+float pingerLevels[kNumPingers] = {0.0f};
+float noiseFloor = 0.0f;
 const float lowerFreq = targetFrequency * (1.0f - frequencyTolerance);
 const float upperFreq = targetFrequency * (1.0f + frequencyTolerance);
 int consecutiveTriggers = 0;
@@ -117,10 +126,14 @@ int main(void)
     hw.SetAudioBlockSize(kBlockSize);
 
     // Initialize the FFT library with the actual sample rate
-    fftLibrary = FFTLibrary(hw.AudioSampleRate());
+    fftLibrary = FFTLibrary(hw.AudioSampleRate(), kFftSize);
 
 	// Start program
     hw.StartLog(true);
+    if (!fftLibrary.isValid())
+    {
+        hw.PrintLine("Error: FFT window tables did not fit in the window cache");
+    }
     hw.StartAudio(MyCallback);
 
 	// Get timestamp
@@ -133,7 +146,11 @@ int main(void)
         // If the buffer is full, process the FFT.
         if (fft_ready_for_processing)
         {
-            detectedFrequencyLevel = fftLibrary.getFrequencyMagnitude(fft_input_buffer, kFftSize, targetFrequency, frequencyTolerance);
+            // One transform per buffer; every level below is read from the same frame
+            fftLibrary.computeFrame(fft_input_buffer, kFftSize, spectrumFrame);
+            detectedFrequencyLevel = spectrumFrame.getFrequencyMagnitude(targetFrequency, frequencyTolerance);
+            spectrumFrame.getFrequencyMagnitudes(pingerFrequencies, kNumPingers, frequencyTolerance, pingerLevels);
+            noiseFloor = spectrumFrame.getNoiseFloor();
             
             // Signal averaging for noise reduction
             frequencyLevelHistory[historyIndex] = detectedFrequencyLevel;
@@ -173,6 +190,16 @@ int main(void)
                          FLT_VAR3(detectedFrequencyLevel), FLT_VAR3(averagedFrequencyLevel), 
                          FLT_VAR3(baseThreshold), isTriggered ? "TRIGGERED!" : "Below");
             
+            // One line for all pingers, labelled from pingerFrequencies so edits to the list stay in step
+            char pingerLine[160];
+            int length = snprintf(pingerLine, sizeof(pingerLine), "Pingers");
+            for (size_t i = 0; i < kNumPingers && length > 0 && length < (int)sizeof(pingerLine); ++i)
+            {
+                length += snprintf(pingerLine + length, sizeof(pingerLine) - length, " %ld Hz: " FLT_FMT3,
+                                   lrintf(pingerFrequencies[i]), FLT_VAR3(pingerLevels[i]));
+            }
+            hw.PrintLine("%s Floor: " FLT_FMT3, pingerLine, FLT_VAR3(noiseFloor));
+
             lastPrintTime = currentTime;
         }
     }
@@ -1,53 +1,109 @@
 /* This program implements a Frequency Shift Keying (FSK) demodulator.
-It captures audio input, performs real-time pitch detection via FFT,
-and decodes the signal into binary data (1s and 0s).
+It runs one matched filter per tone (binary mark/space, or M-ary FSK over a
+tone table) on every audio sample of one or both inputs, combines the two
+hydrophones by their estimated SNR, recovers the symbol timing, frames the
+bits into packets (preamble, sync word, length, payload, CRC-16) and prints
+one line per packet that passes its CRC. Frames can be convolutionally coded,
+in which case the soft bit values go through a Viterbi decoder.
 */
 #include "daisy_seed.h"
-#include "library/fft_library.h"
+#include "library/fsk_modem.h"
+#include "library/fsk_packet.h"
+#include "library/sample_clock.h"
+#include <cmath>
+#include <cstdio>
 
 using namespace daisy;
 
 DaisySeed hw;
-FFTLibrary *fft = nullptr;
 
 // Constants (mark frequency represents 1, space frequency represents 0)
 const float MARK_FREQ = 45000.0f;
 const float SPACE_FREQ = 44000.0f;
-const size_t FFT_SIZE = 1024;
+const float BAUD_RATE = 1000.0f;     // at most the tone spacing for orthogonal tones
+// Tone table: 2, 4, 8 or 16 tones, each symbol carries log2(count) bits.
+// Tone k carries the data value whose Gray code is k (see FskDemodulator).
+// Two tones is binary FSK (tone 0 = SPACE, tone 1 = MARK); for 4-FSK use e.g.
+// {42000.0f, 43000.0f, 44000.0f, 45000.0f}.
+const float TONE_FREQS[] = {SPACE_FREQ, MARK_FREQ};
+const size_t NUM_TONES = sizeof(TONE_FREQS) / sizeof(TONE_FREQS[0]);
+const float SQUELCH_LEVEL = 0.005f;  // tone amplitude below which no bits are reported
+// Automatic frequency control: tracks a common tone offset (Doppler, transmitter
+// clock error) up to this many Hz either way; 0 disables it
+const float AFC_MAX_OFFSET_HZ = 400.0f;
+// Diversity: decode both inputs (one hydrophone each) and combine the tone
+// energies before the bit decision, so a fade on one hydrophone is covered by
+// the other. Use 1 (in[0] only) when only one hydrophone is connected.
+const size_t NUM_CHANNELS = 2;
+const FskDemodulator::Combining COMBINING =
+    FskDemodulator::Combining::MaximalRatio;
 
-// ---- BUFFERING VARIABLES ----
-// We need to collect audio manually because we can't set BlockSize to 1024
-// directly
-// Create a buffer to store 1024 samples
-float g_fft_buffer[FFT_SIZE];
-size_t g_write_index = 0;
-bool g_buffer_ready = false;
+// Rate-1/2 K=7 coded frames: about 2 dB better packet success for binary FSK
+// at the same energy per data bit, at half the data rate (tests/bench_fsk_coded:
+// half the 16-byte packets lost at 8 dB Eb/N0 coded, about 10 dB uncoded)
+const bool CODED = false;
+// Bit errors accepted in the 32-bit sync word (coded frames run at lower SNR)
+const size_t SYNC_ERROR_TOLERANCE = CODED ? 4 : 2;
+const size_t MIN_PREAMBLE_BITS = 8;    // preamble bits required before the sync word
+const uint32_t SILENCE_FLUSH_MS = 100;
+
+// Demodulator runs in the audio callback; the main loop only drains decoded symbols
+SampleClock sampleClock(96000.0f);
+FskDemodulator demod(96000.0f, TONE_FREQS, NUM_TONES, BAUD_RATE,
+                     NUM_CHANNELS);
+FskPacketDecoder packets(FskPacketDecoder::kDefaultSyncWord,
+                         SYNC_ERROR_TOLERANCE, MIN_PREAMBLE_BITS);
+
+// Print a packet as text if it is all printable ASCII, otherwise as hex
+void PrintPacket(const FskPacketDecoder::Packet &packet) {
+  char text[FskPacketDecoder::kMaxPayload * 3 + 1];
+  bool printable = true;
+  for (size_t i = 0; i < packet.length; i++) {
+    if (packet.payload[i] < 0x20 || packet.payload[i] > 0x7E) {
+      printable = false;
+      break;
+    }
+  }
+
+  size_t pos = 0;
+  for (size_t i = 0; i < packet.length; i++) {
+    if (printable) {
+      text[pos++] = (char)packet.payload[i];
+    } else {
+      pos += snprintf(text + pos, sizeof(text) - pos, "%02X ",
+                      packet.payload[i]);
+    }
+  }
+  text[pos] = '\0';
+  hw.PrintLine("packet[%u]: %s", (unsigned)packet.length, text);
+}
+
+// Channel SNR in whole dB for printing (-99 for no signal)
+int SnrDb(float snr) {
+  return snr > 0.0f ? (int)lrintf(10.0f * log10f(snr)) : -99;
+}
 
 /* This function performs two main tasks:
  * 1. Audio Passthrough: Instantly copies input to output so the signal can be
  * heard.
- * 2. FFT Buffering: Collects small blocks of data (48 samples) into a larger
- * buffer (1024 samples) required for the frequency analysis in the main loop.
+ * 2. Demodulation: Feeds every input sample (both inputs in diversity mode) to
+ * the FSK demodulator, so no samples are skipped while the main loop prints.
  */
 void AudioCallback(AudioHandle::InputBuffer in, AudioHandle::OutputBuffer out,
                    size_t size) {
-  // Process the small audio block (size is 48 here)
+  sampleClock.beginBlock(size);
   for (size_t i = 0; i < size; i++) {
+    const SampleClock::Timestamp time = sampleClock.stamp(i);
+
     // 1. PASSTHROUGH
     out[0][i] = in[0][i];
     out[1][i] = in[0][i];
 
-    // 2. COLLECT DATA
-    // Only collect if the main loop is ready for new data
-    if (!g_buffer_ready) {
-      g_fft_buffer[g_write_index] = in[0][i];
-      g_write_index++;
-
-      // Once we have 1024 samples, tell main loop to run FFT
-      if (g_write_index >= FFT_SIZE) {
-        g_buffer_ready = true;
-        g_write_index = 0;
-      }
+    // 2. DEMODULATE
+    if (NUM_CHANNELS > 1) {
+      demod.process(in[0][i], in[1][i], time);
+    } else {
+      demod.process(in[0][i], time);
     }
   }
 }
@@ -59,40 +115,69 @@ int main(void) {
   System::Delay(500);
 
   // B. Setup Audio - USE STANDARD BLOCK SIZE (48)
-  // sample rate = 96Hz
+  // sample rate = 96kHz
   hw.SetAudioSampleRate(SaiHandle::Config::SampleRate::SAI_96KHZ);
   hw.SetAudioBlockSize(48);
 
-  fft = new FFTLibrary(hw.AudioSampleRate());
+  sampleClock = SampleClock(hw.AudioSampleRate());
+  demod = FskDemodulator(hw.AudioSampleRate(), TONE_FREQS, NUM_TONES,
+                         BAUD_RATE, NUM_CHANNELS);
+  demod.setSquelch(SQUELCH_LEVEL);
+  demod.setCombining(COMBINING);
+  demod.setAfc(AFC_MAX_OFFSET_HZ);
+  packets = FskPacketDecoder(FskPacketDecoder::kDefaultSyncWord,
+                             SYNC_ERROR_TOLERANCE, MIN_PREAMBLE_BITS,
+                             demod.getBitsPerSymbol());
+  packets.setCoded(CODED);
 
   hw.PrintLine("FSK Demodulator Initialized.");
   // Simplified print to avoid any float formatting issues during startup
-  hw.PrintLine("Watching 45000Hz vs 44000Hz");
+  hw.PrintLine("Watching %u tones, %u bits/symbol at %u baud%s, %u channel(s)",
+               (unsigned)demod.getNumTones(),
+               (unsigned)demod.getBitsPerSymbol(), (unsigned)BAUD_RATE,
+               CODED ? ", rate 1/2 coded" : "",
+               (unsigned)demod.getNumChannels());
 
   hw.StartAudio(AudioCallback);
 
+  // Silence is timed on the sample clock, the same time base as the symbols
+  uint64_t last_symbol_sample = sampleClock.now();
+  bool silent = false;
+
   while (1) {
-    // 1. Wait for buffer to be full
-    if (g_buffer_ready) {
-      // 2. Run FFT on the collected buffer
-      float freq = fft->detectPitch(g_fft_buffer, FFT_SIZE);
-
-      // 3. Full FSK Logic
-      if (freq > 500.0f) {
-        float mark_diff = fabsf(freq - MARK_FREQ);
-        float space_diff = fabsf(freq - SPACE_FREQ);
-        // determine if frequency is closer to mark or space
-        if (mark_diff < space_diff)
-          hw.PrintLine("1 [MARK]");
-        else
-          hw.PrintLine("0 [SPACE]");
-      } else {
-        hw.PrintLine("Silence");
+    // 1. Drain decoded symbols into the packet framer as soft bits, MSB first
+    FskDemodulator::Symbol symbol;
+    while (demod.popSymbol(symbol)) {
+      last_symbol_sample = symbol.time.sample();
+      silent = false;
+
+      for (size_t b = 0; b < demod.getBitsPerSymbol(); b++) {
+        if (packets.pushSoftBit(symbol.soft[b])) {
+          PrintPacket(packets.getPacket());
+        }
       }
-      // 4. Reset flag to collect next batch
-      g_buffer_ready = false;
     }
-    // Short delay to keep loop sane
-    System::Delay(1);
+
+    // 2. Once the signal stops, drop any partial packet and report counters
+    const int64_t since_symbol =
+        SampleClock::difference(last_symbol_sample, sampleClock.now());
+    if (!silent &&
+        sampleClock.toMicroseconds(since_symbol) >= SILENCE_FLUSH_MS * 1000) {
+      packets.reset();
+      const FskPacketDecoder::Counters &c = packets.getCounters();
+      hw.PrintLine("Silence (sync %lu, ok %lu, crc fail %lu, bad length %lu, "
+                   "dropped bits %lu, dropped symbols %lu, offset %d Hz)",
+                   (unsigned long)c.syncHits, (unsigned long)c.packets,
+                   (unsigned long)c.crcFailures, (unsigned long)c.lengthErrors,
+                   (unsigned long)c.droppedBits,
+                   (unsigned long)demod.getDroppedSymbols(),
+                   (int)demod.getFrequencyOffset());
+      if (demod.getNumChannels() > 1) {
+        hw.PrintLine("Channel SNR %d dB / %d dB",
+                     SnrDb(demod.getChannelSnr(0)),
+                     SnrDb(demod.getChannelSnr(1)));
+      }
+      silent = true;
+    }
   }
-}
\ No newline at end of file
+}
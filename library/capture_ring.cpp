@@ -0,0 +1,142 @@
+#include "capture_ring.h"
+#include <cstring>
+
+CaptureRing::CaptureRing(float *storage, size_t channels, size_t capacity, size_t slots)
+    : m_storage(storage), m_channels(channels), m_capacity(capacity > 0 ? capacity : 1),
+      m_slots(slots < 2 ? 2 : (slots > kMaxSlots ? kMaxSlots : slots)), m_preTrigger(0), m_postTrigger(0),
+      m_writeSlot(0), m_writePos(0), m_fill(0), m_written(0), m_captureTrigger(0), m_requestedTrigger(0),
+      m_triggerPending(false), m_capturing(false)
+{
+    setWindow(m_capacity / 2, m_capacity / 2);
+    for (size_t s = 0; s < kMaxSlots; ++s)
+    {
+        m_state[s] = SlotState::Free;
+        m_snapshots[s] = Snapshot{s, 0, 0, 0};
+        m_endPos[s] = 0;
+    }
+    m_state[0] = SlotState::Writing;
+}
+
+void CaptureRing::setWindow(size_t preTrigger, size_t postTrigger)
+{
+    m_postTrigger = postTrigger > m_capacity ? m_capacity : postTrigger;
+    m_preTrigger = preTrigger > m_capacity - m_postTrigger ? m_capacity - m_postTrigger : preTrigger;
+}
+
+void CaptureRing::push(const float *samples)
+{
+    for (size_t c = 0; c < m_channels; ++c)
+    {
+        slotData(m_writeSlot, c)[m_writePos] = samples[c];
+    }
+    m_writePos = m_writePos + 1 >= m_capacity ? 0 : m_writePos + 1;
+    m_fill = m_fill < m_capacity ? m_fill + 1 : m_capacity;
+    ++m_written;
+
+    if (m_triggerPending && !m_capturing)
+    {
+        m_captureTrigger = m_requestedTrigger;
+        m_capturing = true;
+        m_triggerPending = false;
+    }
+
+    if (m_capturing && m_written >= m_captureTrigger + m_postTrigger)
+    {
+        freeze();
+    }
+}
+
+bool CaptureRing::trigger(uint64_t sample)
+{
+    if (m_triggerPending || m_capturing)
+    {
+        return false;
+    }
+
+    // The capture must be able to freeze into a free slot. Only release() frees slots and only a
+    // freeze takes one, and no capture is running, so a free slot seen here is still free then.
+    bool available = false;
+    for (size_t s = 0; s < m_slots; ++s)
+    {
+        available = available || m_state[s] == SlotState::Free;
+    }
+    if (!available)
+    {
+        return false;
+    }
+    m_requestedTrigger = sample;
+    m_triggerPending = true;
+    return true;
+}
+
+void CaptureRing::freeze()
+{
+    // The window, less whatever has already left the slot (a late trigger) or was never in it
+    const uint64_t oldest = m_written - m_fill;
+    const uint64_t wanted = m_captureTrigger > m_preTrigger ? m_captureTrigger - m_preTrigger : 0;
+    const uint64_t first = wanted > oldest ? wanted : oldest;
+    const uint64_t end = m_captureTrigger + m_postTrigger;
+
+    Snapshot &snapshot = m_snapshots[m_writeSlot];
+    snapshot.slot = m_writeSlot;
+    snapshot.firstSample = first;
+    snapshot.triggerSample = m_captureTrigger;
+    snapshot.length = end > first ? (size_t)(end - first) : 0;
+    m_endPos[m_writeSlot] = snapshot.length > 0 ? (m_writePos + m_capacity - (size_t)(m_written - end)) % m_capacity : 0;
+    m_state[m_writeSlot] = SlotState::Frozen;
+
+    for (size_t s = 0; s < m_slots; ++s)
+    {
+        if (m_state[s] == SlotState::Free)
+        {
+            m_writeSlot = s;
+            break;
+        }
+    }
+    m_state[m_writeSlot] = SlotState::Writing;
+    m_writePos = 0;
+    m_fill = 0;
+    m_capturing = false;
+}
+
+bool CaptureRing::acquire(Snapshot &snapshot) const
+{
+    bool found = false;
+    for (size_t s = 0; s < m_slots; ++s)
+    {
+        if (m_state[s] == SlotState::Frozen && (!found || m_snapshots[s].firstSample < snapshot.firstSample))
+        {
+            snapshot = m_snapshots[s];
+            found = true;
+        }
+    }
+    return found;
+}
+
+void CaptureRing::release(const Snapshot &snapshot)
+{
+    if (snapshot.slot < m_slots && m_state[snapshot.slot] == SlotState::Frozen)
+    {
+        m_state[snapshot.slot] = SlotState::Free;
+    }
+}
+
+size_t CaptureRing::read(const Snapshot &snapshot, size_t channel, size_t offset, float *out, size_t count) const
+{
+    if (channel >= m_channels || offset >= snapshot.length)
+    {
+        return 0;
+    }
+    if (count > snapshot.length - offset)
+    {
+        count = snapshot.length - offset;
+    }
+
+    // Copy out in at most two pieces around the wrap point
+    const float *data = slotData(snapshot.slot, channel);
+    const size_t start = (m_endPos[snapshot.slot] + m_capacity - snapshot.length + offset) % m_capacity;
+    const size_t first = (m_capacity - start) < count ? (m_capacity - start) : count;
+    memcpy(out, data + start, first * sizeof(float));
+    memcpy(out + first, data, (count - first) * sizeof(float));
+    return count;
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Continuous multi-channel capture with pre-trigger history and snapshot-on-trigger.
+// The audio callback pushes every sample into the writing slot, a circular buffer of capacity
+// samples per channel, so the last capacity samples are always held. A trigger marks a sample
+// (which may already be in the past); once postTrigger samples beyond it have been written, the
+// slot is frozen with the window [trigger - preTrigger, trigger + postTrigger) and writing moves
+// on to a free slot. Nothing is copied on the audio path: the main loop reads the frozen slot in
+// place, for as long as it needs, and releases it afterwards. Capture restarts from an empty
+// slot, so a trigger right after a freeze gets less pre-trigger history.
+//
+// The storage is caller-owned (e.g. a DSY_SDRAM_BSS array of storageSize() floats), slot-major
+// and channel-planar. Sample indices count pushed samples; when every callback sample is pushed
+// from the first block on, they are SampleClock sample indices.
+//
+// push() is meant for the audio callback; trigger(), acquire(), read() and release() for the
+// main loop (single producer, single consumer).
+class CaptureRing
+{
+public:
+    struct Snapshot
+    {
+        size_t slot;
+        uint64_t firstSample;     // sample index of the first captured sample
+        uint64_t triggerSample;
+        size_t length;            // samples per channel
+    };
+
+    static constexpr size_t kMaxSlots = 4;
+
+    static constexpr size_t storageSize(size_t channels, size_t capacity, size_t slots)
+    {
+        return channels * capacity * slots;
+    }
+
+    // storage holds storageSize(channels, capacity, slots) floats; slots is clamped to 2 .. kMaxSlots
+    CaptureRing(float* storage, size_t channels, size_t capacity, size_t slots);
+
+    // Samples kept before and after the trigger (together at most the capacity)
+    void setWindow(size_t preTrigger, size_t postTrigger);
+
+    // Push one sample per channel (samples[channel])
+    void push(const float* samples);
+
+    // Request a snapshot around sample. Returns false while another trigger is pending or being
+    // captured (its window covers this one), or when every other slot holds a snapshot that has not
+    // been released; the caller can release and trigger again. Once accepted, the snapshot follows.
+    bool trigger(uint64_t sample);
+
+    // Oldest frozen snapshot; returns false if none. It stays valid until release().
+    bool acquire(Snapshot& snapshot) const;
+    void release(const Snapshot& snapshot);
+
+    // Copy count samples of one channel from position offset of the snapshot into out.
+    // Returns the number copied (fewer at the end of the snapshot).
+    size_t read(const Snapshot& snapshot, size_t channel, size_t offset, float* out, size_t count) const;
+
+    size_t getCapacity() const { return m_capacity; }
+
+private:
+    enum class SlotState : uint8_t
+    {
+        Free,
+        Writing,
+        Frozen,
+    };
+
+    float* slotData(size_t slot, size_t channel) const { return m_storage + (slot * m_channels + channel) * m_capacity; }
+
+    // Freeze the writing slot and continue in a free one (callback only)
+    void freeze();
+
+    float* m_storage;
+    size_t m_channels;
+    size_t m_capacity;
+    size_t m_slots;
+    size_t m_preTrigger;
+    size_t m_postTrigger;
+
+    // Callback side
+    size_t m_writeSlot;
+    size_t m_writePos;
+    size_t m_fill;           // samples held by the writing slot
+    uint64_t m_written;      // total samples pushed
+    uint64_t m_captureTrigger;
+
+    // Handoff between the main loop and the callback
+    volatile uint64_t m_requestedTrigger;
+    volatile bool m_triggerPending;
+    volatile bool m_capturing;
+    volatile SlotState m_state[kMaxSlots];
+    Snapshot m_snapshots[kMaxSlots];   // written before the slot is marked Frozen
+    size_t m_endPos[kMaxSlots];        // write position one past the last snapshot sample
+};
@@ -0,0 +1,223 @@
+#include "cfar_detector.h"
+#include "goertzel_detector.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// Ordered-statistic false-alarm probability for factor alpha, rank k of n cells:
+// Pfa = prod_{i=0}^{k-1} (n - i) / (n - i + alpha)
+static double orderedStatisticPfa(double alpha, size_t k, size_t n)
+{
+    double pfa = 1.0;
+    for (size_t i = 0; i < k; ++i)
+    {
+        pfa *= (double)(n - i) / ((double)(n - i) + alpha);
+    }
+    return pfa;
+}
+
+static size_t orderedStatisticRank(float rank, size_t cells)
+{
+    size_t k = (size_t)ceilf(rank * cells);
+    if (k < 1)
+    {
+        k = 1;
+    }
+    if (k > cells)
+    {
+        k = cells;
+    }
+    return k;
+}
+
+CfarDetector::CfarDetector(Mode mode, float falseAlarmProbability, size_t guardBins, size_t referenceBins,
+                           size_t historyLength)
+    : m_mode(mode), m_falseAlarmProbability(falseAlarmProbability), m_guardBins(guardBins),
+      m_referenceBins(referenceBins), m_historyLength(historyLength), m_rank(0.75f), m_minimumThreshold(0.0f),
+      m_history(historyLength, 0.0f), m_historyPos(0), m_historyCount(0),
+      m_lockoutLimit(historyLength), m_detectionRun(0), m_cells(2 * referenceBins + historyLength),
+      m_noisePower(0.0f), m_thresholdPower(FLT_MAX), m_testPower(0.0f), m_detected(false)
+{
+    setOrderedStatisticRank(m_rank);
+}
+
+void CfarDetector::setOrderedStatisticRank(float rank)
+{
+    m_rank = rank;
+
+    // Factors depend only on the number of cells, which varies while the history fills
+    // and when reference bins are clipped at the spectrum edges
+    const size_t maxCells = m_cells.size();
+    m_factors.assign(maxCells + 1, 0.0f);
+    for (size_t n = 1; n <= maxCells; ++n)
+    {
+        m_factors[n] = thresholdFactor(n);
+    }
+}
+
+float CfarDetector::thresholdFactor(size_t cells) const
+{
+    const double pfa = m_falseAlarmProbability;
+    if (m_mode == Mode::CellAveraging)
+    {
+        // Threshold on the mean of n exponential cells: alpha = n * (Pfa^(-1/n) - 1)
+        return (float)(cells * (pow(pfa, -1.0 / cells) - 1.0));
+    }
+
+    // Ordered statistic: Pfa falls monotonically with alpha, so bisect (in log space)
+    const size_t k = orderedStatisticRank(m_rank, cells);
+    double low = 1e-6;
+    double high = 1e6;
+    for (int iter = 0; iter < 100; ++iter)
+    {
+        const double mid = sqrt(low * high);
+        if (orderedStatisticPfa(mid, k, cells) > pfa)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return (float)high;
+}
+
+template <typename Magnitudes>
+bool CfarDetector::processSpectrum(const Magnitudes &magnitudes, size_t num_bins, size_t lower_bin, size_t upper_bin)
+{
+    if (num_bins == 0 || lower_bin > upper_bin || upper_bin >= num_bins)
+    {
+        return false;
+    }
+
+    float testPower = 0.0f;
+    for (size_t bin = lower_bin; bin <= upper_bin; ++bin)
+    {
+        const float magnitude = magnitudes(bin);
+        testPower += magnitude * magnitude;
+    }
+    testPower /= (float)(upper_bin - lower_bin + 1);
+
+    // Reference bins on both sides, skipping the guard bins and DC
+    size_t count = 0;
+    for (size_t i = 1; i <= m_referenceBins; ++i)
+    {
+        const size_t offset = m_guardBins + i;
+        if (lower_bin > offset)
+        {
+            const float magnitude = magnitudes(lower_bin - offset);
+            m_cells[count++] = magnitude * magnitude;
+        }
+        if (upper_bin + offset < num_bins)
+        {
+            const float magnitude = magnitudes(upper_bin + offset);
+            m_cells[count++] = magnitude * magnitude;
+        }
+    }
+
+    return decide(testPower, count);
+}
+
+bool CfarDetector::process(const float *magnitudes, size_t num_bins, size_t lower_bin, size_t upper_bin)
+{
+    if (magnitudes == nullptr)
+    {
+        return false;
+    }
+    return processSpectrum([magnitudes](size_t bin) { return magnitudes[bin]; }, num_bins, lower_bin, upper_bin);
+}
+
+bool CfarDetector::process(const SpectrumFrame &frame, float target_freq, float tolerance)
+{
+    if (!frame.isValid())
+    {
+        return false;
+    }
+
+    size_t lower_bin = 0;
+    size_t upper_bin = 0;
+    GoertzelDetector::bandBins(frame.getSize(), frame.getSampleRate(), target_freq, tolerance, lower_bin, upper_bin);
+    return processSpectrum([&frame](size_t bin) { return frame.getMagnitude(bin); }, frame.getSize() / 2 + 1,
+                           lower_bin, upper_bin);
+}
+
+bool CfarDetector::process(float level)
+{
+    return decide(level * level, 0);
+}
+
+bool CfarDetector::decide(float testPower, size_t spectralCells)
+{
+    m_testPower = testPower;
+
+    size_t count = spectralCells;
+    for (size_t i = 0; i < m_historyCount; ++i)
+    {
+        m_cells[count++] = m_history[i];
+    }
+
+    if (count < kMinimumCells)
+    {
+        // Not enough reference yet: learn, but never declare
+        m_detected = false;
+    }
+    else
+    {
+        if (m_mode == Mode::CellAveraging)
+        {
+            float sum = 0.0f;
+            for (size_t i = 0; i < count; ++i)
+            {
+                sum += m_cells[i];
+            }
+            m_noisePower = sum / count;
+        }
+        else
+        {
+            const size_t k = orderedStatisticRank(m_rank, count);
+            std::nth_element(m_cells.begin(), m_cells.begin() + (k - 1), m_cells.begin() + count);
+            m_noisePower = m_cells[k - 1];
+        }
+
+        m_thresholdPower = m_factors[count] * m_noisePower;
+        const float minimumPower = m_minimumThreshold * m_minimumThreshold;
+        if (m_thresholdPower < minimumPower)
+        {
+            m_thresholdPower = minimumPower;
+        }
+        m_detected = testPower > m_thresholdPower;
+    }
+
+    // Only noise goes into the history, so a long ping does not raise its own threshold. A detection
+    // that outlasts the lockout is a step in the noise floor, and feeding it lets the threshold follow.
+    // The run counts detections less misses, so the odd noise cell under the old threshold does not restart it.
+    m_detectionRun = m_detected ? m_detectionRun + 1 : (m_detectionRun > 0 ? m_detectionRun - 1 : 0);
+    const bool lockedOut = m_lockoutLimit > 0 && m_detectionRun > m_lockoutLimit;
+    if ((!m_detected || lockedOut) && m_historyLength > 0)
+    {
+        m_history[m_historyPos] = testPower;
+        m_historyPos = (m_historyPos + 1) % m_historyLength;
+        if (m_historyCount < m_historyLength)
+        {
+            ++m_historyCount;
+        }
+    }
+
+    return m_detected;
+}
+
+float CfarDetector::getNoiseLevel() const
+{
+    return std::sqrt(m_noisePower);
+}
+
+float CfarDetector::getThreshold() const
+{
+    return std::sqrt(m_thresholdPower);
+}
+
+float CfarDetector::getLevel() const
+{
+    return std::sqrt(m_testPower);
+}
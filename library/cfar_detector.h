@@ -0,0 +1,95 @@
+#pragma once
+
+#include "spectrum_frame.h"
+#include <cstddef>
+#include <vector>
+
+// Constant-false-alarm-rate detector for a narrow band.
+// The noise level is estimated from reference cells: bins on both sides of the band
+// (outside guardBins, referenceBins per side) and the band's own level in recent frames
+// without a detection (historyLength frames). The threshold is that estimate times a factor
+// derived from the false-alarm probability, so it follows the noise floor from run to run.
+//
+// A level that stays above the threshold for longer than the lockout (one history length by
+// default, counting detections less misses) is taken as a new noise floor: from then on it
+// enters the history while detected, so the threshold climbs to it instead of the detector
+// staying "detected" for good.
+//
+// Cells are powers (|X|^2) and the factor assumes exponentially distributed (square-law)
+// noise cells. The test cell is the mean band power, which is a little better behaved than a
+// single bin, so the realised false-alarm rate is at or below the configured one.
+// Levels reported by the getters are magnitudes (square roots), in the units of the input.
+class CfarDetector
+{
+public:
+    enum class Mode
+    {
+        CellAveraging,     // mean of the reference cells
+        OrderedStatistic,  // k-th smallest reference cell; robust to interferers in the reference set
+    };
+
+    CfarDetector(Mode mode, float falseAlarmProbability, size_t guardBins, size_t referenceBins, size_t historyLength);
+
+    // Rank of the ordered statistic as a fraction of the reference cells (default 0.75)
+    void setOrderedStatisticRank(float rank);
+
+    // Lowest threshold ever applied (input units); keeps digital silence from triggering
+    void setMinimumThreshold(float threshold) { m_minimumThreshold = threshold; }
+
+    // Length of a detection run (detections less misses) after which the test level also enters
+    // the history (0 = never)
+    void setLockoutLimit(size_t tests) { m_lockoutLimit = tests; }
+
+    // Spectral test on bins lower_bin .. upper_bin of a magnitude spectrum with num_bins bins.
+    // Reference bins beyond the guard bins and the history both feed the noise estimate.
+    bool process(const float* magnitudes, size_t num_bins, size_t lower_bin, size_t upper_bin);
+
+    // Spectral test on the bins covering target_freq * (1 +/- tolerance) of a frame
+    bool process(const SpectrumFrame& frame, float target_freq, float tolerance);
+
+    // History-only test on a band magnitude (e.g. a sliding DFT output)
+    bool process(float level);
+
+    bool isDetected() const { return m_detected; }
+
+    // Current noise estimate, threshold and last test level (magnitudes). Until enough
+    // reference cells have been seen the threshold is FLT_MAX, so nothing triggers.
+    float getNoiseLevel() const;
+    float getThreshold() const;
+    float getLevel() const;
+
+private:
+    // Reference cells needed before anything can be declared
+    static constexpr size_t kMinimumCells = 4;
+
+    // Band power and reference bins from any magnitude source, then decide()
+    template <typename Magnitudes>
+    bool processSpectrum(const Magnitudes& magnitudes, size_t num_bins, size_t lower_bin, size_t upper_bin);
+
+    // Shared decision once the spectral reference cells (if any) are in m_cells
+    bool decide(float testPower, size_t spectralCells);
+
+    // Threshold factor for n reference cells at the configured false-alarm probability
+    float thresholdFactor(size_t cells) const;
+
+    Mode m_mode;
+    float m_falseAlarmProbability;
+    size_t m_guardBins;
+    size_t m_referenceBins;
+    size_t m_historyLength;
+    float m_rank;
+    float m_minimumThreshold;
+
+    std::vector<float> m_factors;   // thresholdFactor(n) for n = 0 .. max cells
+    std::vector<float> m_history;   // band powers of frames without a detection (circular)
+    size_t m_historyPos;
+    size_t m_historyCount;
+    size_t m_lockoutLimit;
+    size_t m_detectionRun;          // detections less misses, not below zero
+    std::vector<float> m_cells;     // reference cells of the current test
+
+    float m_noisePower;
+    float m_thresholdPower;
+    float m_testPower;
+    bool m_detected;
+};
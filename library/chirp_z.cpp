@@ -0,0 +1,198 @@
+#include "chirp_z.h"
+#include "window_functions.h"
+#include <cmath>
+
+// Define M_PI if not available in the C++ standard library
+#ifndef M_PI
+#define M_PI 3.14159265358979323846f
+#endif
+
+// e^(i*pi*step*n^2/fs), with the phase reduced in double precision so large n stays exact
+static std::complex<float> chirp(size_t n, double step, double sampleRate)
+{
+    const double cycles = fmod((double)n * (double)n * step / sampleRate, 2.0);
+    return std::complex<float>((float)cos(M_PI * cycles), (float)sin(M_PI * cycles));
+}
+
+ChirpZTransform::ChirpZTransform()
+    : m_sampleRate(0.0f), m_inputSize(0), m_startFreq(0.0f), m_step(0.0f), m_bins(0), m_convolutionSize(0),
+      m_fft(0.0f)
+{
+}
+
+ChirpZTransform::ChirpZTransform(float sampleRate, size_t inputSize, float startFreq, float endFreq, size_t bins)
+    : ChirpZTransform()
+{
+    init(sampleRate, inputSize, startFreq, endFreq, bins);
+}
+
+void ChirpZTransform::init(float sampleRate, size_t inputSize, float startFreq, float endFreq, size_t bins)
+{
+    // Release the old tables before building the new ones, so the two sets are never live together
+    m_preChirp = std::vector<std::complex<float>>();
+    m_filter = std::vector<std::complex<float>>();
+    m_postChirp = std::vector<std::complex<float>>();
+    m_work = std::vector<std::complex<float>>();
+    m_spectrum = std::vector<std::complex<float>>();
+
+    m_sampleRate = sampleRate;
+    m_inputSize = inputSize;
+    m_startFreq = startFreq;
+    m_step = bins > 1 ? (endFreq - startFreq) / (bins - 1) : 0.0f;
+    m_bins = bins;
+    m_convolutionSize = 1;
+    while (m_convolutionSize < inputSize + bins - 1)
+    {
+        m_convolutionSize <<= 1;
+    }
+
+    // Only the transform is used: its tables are built by the first fft() below, and no window table
+    m_fft = FFTLibrary(sampleRate);
+
+    m_preChirp.resize(inputSize);
+    for (size_t n = 0; n < inputSize; ++n)
+    {
+        const double shift = -2.0 * M_PI * fmod((double)startFreq * n / sampleRate, 1.0);
+        const std::complex<float> mix((float)cos(shift), (float)sin(shift));
+        m_preChirp[n] = WindowCache::value(WindowType::Hann, n, inputSize, 0.0f) * mix * std::conj(chirp(n, m_step, sampleRate));
+    }
+
+    // Chirp filter at lags -(inputSize - 1) .. bins - 1, laid out circularly
+    m_filter.assign(m_convolutionSize, std::complex<float>(0.0f, 0.0f));
+    for (size_t m = 0; m < bins; ++m)
+    {
+        m_filter[m] = chirp(m, m_step, sampleRate);
+    }
+    for (size_t n = 1; n < inputSize; ++n)
+    {
+        m_filter[m_convolutionSize - n] = chirp(n, m_step, sampleRate);
+    }
+    m_fft.fft(m_filter);
+    const float scale = 1.0f / m_convolutionSize;
+    for (size_t i = 0; i < m_convolutionSize; ++i)
+    {
+        m_filter[i] *= scale;
+    }
+
+    m_postChirp.resize(bins);
+    for (size_t k = 0; k < bins; ++k)
+    {
+        m_postChirp[k] = std::conj(chirp(k, m_step, sampleRate));
+    }
+
+    m_work.resize(m_convolutionSize);
+    m_spectrum.resize(bins);
+}
+
+bool ChirpZTransform::transform(const float *buffer, size_t buffer_size)
+{
+    if (buffer == nullptr || m_bins == 0 || buffer_size < m_inputSize)
+    {
+        return false;
+    }
+    const float *input = buffer + (buffer_size - m_inputSize);
+
+    for (size_t n = 0; n < m_inputSize; ++n)
+    {
+        m_work[n] = input[n] * m_preChirp[n];
+    }
+    for (size_t n = m_inputSize; n < m_convolutionSize; ++n)
+    {
+        m_work[n] = std::complex<float>(0.0f, 0.0f);
+    }
+
+    // Circular convolution with the chirp; the inverse FFT is a forward FFT of the conjugate
+    m_fft.fft(m_work);
+    for (size_t i = 0; i < m_convolutionSize; ++i)
+    {
+        m_work[i] = std::conj(m_work[i] * m_filter[i]);
+    }
+    m_fft.fft(m_work);
+
+    for (size_t k = 0; k < m_bins; ++k)
+    {
+        m_spectrum[k] = std::conj(m_work[k]) * m_postChirp[k];
+    }
+    return true;
+}
+
+float ChirpZTransform::detectPitch(float *magnitude) const
+{
+    float max_mag = 0.0f;
+    size_t max_index = 0;
+    for (size_t k = 0; k < m_bins; ++k)
+    {
+        const float mag = std::abs(m_spectrum[k]);
+        if (mag > max_mag)
+        {
+            max_mag = mag;
+            max_index = k;
+        }
+    }
+
+    if (magnitude != nullptr)
+    {
+        *magnitude = max_mag;
+    }
+
+    // Parabolic interpolation, as in FFTLibrary::findInterpolatedFrequency; on a fine grid
+    // the Hann main lobe is close to parabolic, so the residual bias is small
+    if (max_index < 1 || max_index + 1 >= m_bins)
+    {
+        return getBinFrequency(max_index);
+    }
+    const float mag0 = std::abs(m_spectrum[max_index - 1]);
+    const float mag2 = std::abs(m_spectrum[max_index + 1]);
+    const float peak_shift = 0.5f * (mag0 - mag2) / (mag0 - 2.0f * max_mag + mag2);
+    if (std::isnan(peak_shift))
+    {
+        return getBinFrequency(max_index);
+    }
+    return m_startFreq + ((float)max_index + peak_shift) * m_step;
+}
+
+float ChirpZTransform::getFrequencyMagnitude(float target_freq, float tolerance) const
+{
+    if (m_bins == 0 || m_step <= 0.0f)
+    {
+        return 0.0f;
+    }
+
+    const float lower_freq = target_freq * (1.0f - tolerance);
+    const float upper_freq = target_freq * (1.0f + tolerance);
+    long lower = (long)ceilf((lower_freq - m_startFreq) / m_step);
+    long upper = (long)floorf((upper_freq - m_startFreq) / m_step);
+    if (lower > upper)
+    {
+        lower = upper = lroundf((target_freq - m_startFreq) / m_step);
+    }
+    lower = lower < 0 ? 0 : lower;
+    upper = upper > (long)m_bins - 1 ? (long)m_bins - 1 : upper;
+
+    float total = 0.0f;
+    for (long k = lower; k <= upper; ++k)
+    {
+        total += std::abs(m_spectrum[k]);
+    }
+
+    // Each FFT bin spans (sampleRate / inputSize) / step grid points
+    return total * m_step * m_inputSize / m_sampleRate;
+}
+
+float ChirpZTransform::detectPitch(const float *buffer, size_t buffer_size)
+{
+    if (!transform(buffer, buffer_size))
+    {
+        return 0.0f;
+    }
+    return detectPitch();
+}
+
+float ChirpZTransform::getFrequencyMagnitude(const float *buffer, size_t buffer_size, float target_freq, float tolerance)
+{
+    if (!transform(buffer, buffer_size))
+    {
+        return 0.0f;
+    }
+    return getFrequencyMagnitude(target_freq, tolerance);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "fft_library.h"
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// Chirp-Z transform (Bluestein): M bins evenly spaced over [startFreq, endFreq] from the
+// last inputSize samples, Hann windowed like FFTLibrary. The sum over n of x[n] * W^(nk) is
+// rewritten as a convolution with a chirp and evaluated with two power-of-two FFTs of
+// length >= inputSize + M - 1, so the step can be far finer than sampleRate / inputSize
+// without evaluating the rest of the band.
+//
+// The pre-chirp (with the window folded in), the chirp filter's spectrum and the post-chirp
+// are built by the constructor or init(); transform() does no heap allocation. A default-
+// constructed transform holds no storage (transform() fails) until init(), so a global can wait
+// for the real sample rate without a second set of buffers.
+class ChirpZTransform
+{
+public:
+    ChirpZTransform();
+    ChirpZTransform(float sampleRate, size_t inputSize, float startFreq, float endFreq, size_t bins);
+
+    // (Re)build the tables; earlier storage is released first
+    void init(float sampleRate, size_t inputSize, float startFreq, float endFreq, size_t bins);
+
+    size_t getInputSize() const { return m_inputSize; }
+    size_t getBinCount() const { return m_bins; }
+    float getBinStep() const { return m_step; }
+    float getBinFrequency(size_t k) const { return m_startFreq + k * m_step; }
+
+    // Transform the last getInputSize() samples of buffer; returns false if the buffer is too short
+    bool transform(const float* buffer, size_t buffer_size);
+
+    // Bins from the last transform(); same scale as FFTLibrary's bins at the same frequencies
+    const std::vector<std::complex<float>>& getSpectrum() const { return m_spectrum; }
+
+    // Peak frequency from the last transform() (parabolic refinement on the fine grid); optionally its magnitude
+    float detectPitch(float* magnitude = nullptr) const;
+
+    // Band magnitude over target_freq * (1 +/- tolerance) from the last transform(), normalised to
+    // FFT bin spacing so it matches FFTLibrary::getFrequencyMagnitude; nearest bin if the band is narrower
+    float getFrequencyMagnitude(float target_freq, float tolerance) const;
+
+    // transform() followed by the query; return 0 if the buffer is too short
+    float detectPitch(const float* buffer, size_t buffer_size);
+    float getFrequencyMagnitude(const float* buffer, size_t buffer_size, float target_freq, float tolerance = 0.05f);
+
+private:
+    float m_sampleRate;
+    size_t m_inputSize;
+    float m_startFreq;
+    float m_step;
+    size_t m_bins;
+    size_t m_convolutionSize;
+
+    std::vector<std::complex<float>> m_preChirp;   // window[n] * e^(-2*pi*i*startFreq*n/fs) * W^(n^2/2)
+    std::vector<std::complex<float>> m_filter;     // FFT of W^(-m^2/2), scaled by 1/convolutionSize
+    std::vector<std::complex<float>> m_postChirp;  // W^(k^2/2)
+    std::vector<std::complex<float>> m_work;
+    std::vector<std::complex<float>> m_spectrum;
+    FFTLibrary m_fft;
+};
@@ -0,0 +1,118 @@
+#include "convolutional_code.h"
+
+// Generators 171 and 133 (octal), bit-reversed for a register with the newest bit in bit 0
+static const uint8_t kPolynomialA = 0x4F;
+static const uint8_t kPolynomialB = 0x6D;
+
+static uint8_t parity(uint8_t value)
+{
+    value ^= value >> 4;
+    value ^= value >> 2;
+    value ^= value >> 1;
+    return value & 1;
+}
+
+uint8_t ConvolutionalEncoder::output(uint8_t state, uint8_t bit)
+{
+    const uint8_t reg = (uint8_t)((state << 1) | (bit & 1));
+    return (uint8_t)((parity(reg & kPolynomialA) << 1) | parity(reg & kPolynomialB));
+}
+
+uint8_t ConvolutionalEncoder::encode(uint8_t bit)
+{
+    const uint8_t pair = output(m_state, bit);
+    m_state = (uint8_t)(((m_state << 1) | (bit & 1)) & (kStates - 1));
+    return pair;
+}
+
+ViterbiDecoder::ViterbiDecoder(size_t maxSteps) : m_decisions(maxSteps, 0), m_steps(0)
+{
+    for (size_t state = 0; state < kStates; ++state)
+    {
+        m_outputs[state][0] = ConvolutionalEncoder::output((uint8_t)state, 0);
+        m_outputs[state][1] = ConvolutionalEncoder::output((uint8_t)state, 1);
+    }
+    reset();
+}
+
+void ViterbiDecoder::reset()
+{
+    // Known start in state 0
+    for (size_t state = 0; state < kStates; ++state)
+    {
+        m_metrics[state] = -1.0e30f;
+    }
+    m_metrics[0] = 0.0f;
+    m_steps = 0;
+}
+
+bool ViterbiDecoder::push(float soft0, float soft1)
+{
+    if (m_steps >= m_decisions.size())
+    {
+        return false;
+    }
+
+    // Correlation metric for each of the four possible output pairs
+    const float branch[4] = {-soft0 - soft1, -soft0 + soft1, soft0 - soft1, soft0 + soft1};
+
+    // New state n = (old << 1 | bit) & 63 has predecessors n >> 1 and (n >> 1) | 32
+    uint64_t decisions = 0;
+    float best = -1.0e30f;
+    for (size_t next = 0; next < kStates; ++next)
+    {
+        const size_t bit = next & 1;
+        const size_t low = next >> 1;
+        const size_t high = low | (kStates >> 1);
+        const float fromLow = m_metrics[low] + branch[m_outputs[low][bit]];
+        const float fromHigh = m_metrics[high] + branch[m_outputs[high][bit]];
+
+        if (fromHigh > fromLow)
+        {
+            m_nextMetrics[next] = fromHigh;
+            decisions |= (uint64_t)1 << next;
+        }
+        else
+        {
+            m_nextMetrics[next] = fromLow;
+        }
+        best = m_nextMetrics[next] > best ? m_nextMetrics[next] : best;
+    }
+
+    // Keep the best metric at 0 so the float metrics never grow
+    for (size_t state = 0; state < kStates; ++state)
+    {
+        m_metrics[state] = m_nextMetrics[state] - best;
+    }
+    m_decisions[m_steps++] = decisions;
+    return true;
+}
+
+size_t ViterbiDecoder::traceback(uint8_t *bits, size_t count, bool terminated) const
+{
+    if (count > m_steps)
+    {
+        count = m_steps;
+    }
+
+    size_t state = 0;
+    if (!terminated)
+    {
+        for (size_t s = 1; s < kStates; ++s)
+        {
+            state = m_metrics[s] > m_metrics[state] ? s : state;
+        }
+    }
+
+    // Walk back from the last step; the input bit of each step is the low bit of its state
+    for (size_t step = m_steps; step-- > 0;)
+    {
+        if (step < count)
+        {
+            bits[step] = (uint8_t)(state & 1);
+        }
+        const size_t fromHigh = (size_t)((m_decisions[step] >> state) & 1);
+        state = (state >> 1) | (fromHigh << (ConvolutionalEncoder::kConstraintLength - 2));
+    }
+    return count;
+}
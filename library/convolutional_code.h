@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Rate-1/2, constraint length 7 convolutional code with generators 171 and 133 (octal), the
+// NASA/CCSDS pair (free distance 10, about 5 dB coding gain with soft decisions).
+// The state is the last six input bits, newest bit in the least significant position. A frame
+// starts in state 0 and ends there after kTailBits zero tail bits.
+class ConvolutionalEncoder
+{
+public:
+    static constexpr size_t kConstraintLength = 7;
+    static constexpr size_t kStates = 1 << (kConstraintLength - 1);
+    static constexpr size_t kTailBits = kConstraintLength - 1;
+
+    ConvolutionalEncoder() : m_state(0) {}
+
+    void reset() { m_state = 0; }
+
+    // Encode one input bit; returns the two output bits, first output in bit 1
+    uint8_t encode(uint8_t bit);
+
+    // Output pair for input 'bit' leaving 'state', first output in bit 1
+    static uint8_t output(uint8_t state, uint8_t bit);
+
+private:
+    uint8_t m_state;
+};
+
+// Soft-decision Viterbi decoder for ConvolutionalEncoder, for frames of up to maxSteps input
+// bits. Branch outputs come from a table built in the constructor; each step does 64
+// add-compare-selects on four branch metrics and stores one 64-bit word of decisions
+// (8 bytes per step), so a whole frame can be traced back once it is complete.
+class ViterbiDecoder
+{
+public:
+    explicit ViterbiDecoder(size_t maxSteps);
+
+    // Start a new frame in state 0
+    void reset();
+
+    // One trellis step from the two soft values of a code pair (positive favours 1, size is
+    // confidence; hard decisions can be passed as +/-1). Returns false if the frame is full.
+    bool push(float soft0, float soft1);
+
+    size_t getSteps() const { return m_steps; }
+    size_t getMaxSteps() const { return m_decisions.size(); }
+
+    // Decode the first 'count' input bits of the frame so far into bits[] (one bit per byte).
+    // terminated: the encoder was flushed with kTailBits zeros, so trace back from state 0;
+    // otherwise trace back from the best state (a provisional decision).
+    // Returns the number of bits written.
+    size_t traceback(uint8_t* bits, size_t count, bool terminated) const;
+
+private:
+    static constexpr size_t kStates = ConvolutionalEncoder::kStates;
+
+    uint8_t m_outputs[kStates][2];      // output pair for each state and input bit
+    float m_metrics[kStates];           // path metrics (higher is better), max kept at 0
+    float m_nextMetrics[kStates];
+    std::vector<uint64_t> m_decisions;  // bit s: state s came from the predecessor with the top bit set
+    size_t m_steps;
+};
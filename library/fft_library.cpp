@@ -1,18 +1,168 @@
 #include "fft_library.h"
 #include <cmath>
 #include <complex>
+#include <utility>
 
 // Define M_PI if not available in the C++ standard library
 #ifndef M_PI
 #define M_PI 3.14159265358979323846f
 #endif
 
-FFTLibrary::FFTLibrary(float sampleRate) : m_sampleRate(sampleRate) {}
+// Complex multiply without the library's NaN/Inf recovery path
+static inline std::complex<float> multiply(const std::complex<float> &a, const std::complex<float> &b)
+{
+    return std::complex<float>(a.real() * b.real() - a.imag() * b.imag(),
+                               a.real() * b.imag() + a.imag() * b.real());
+}
+
+// Number of bits needed to index a power-of-two size
+static size_t log2Size(size_t size)
+{
+    size_t bits = 0;
+    while (((size_t)1 << bits) < size)
+    {
+        ++bits;
+    }
+    return bits;
+}
+
+// Combine sub-transforms of length span / 2 into length span for log2(N) stages,
+// applying each twiddle to Channels frames spaced channelStride apart
+template <size_t Channels>
+static void butterflyStages(std::complex<float> *data, size_t size, size_t channelStride,
+                            const std::complex<float> *twiddles, size_t tableStride)
+{
+    for (size_t span = 2; span <= size; span <<= 1)
+    {
+        const size_t half = span / 2;
+        const size_t stride = tableStride * (size / span);
+        for (size_t start = 0; start < size; start += span)
+        {
+            std::complex<float> *even = data + start;
+            std::complex<float> *odd = data + start + half;
+            for (size_t k = 0; k < half; ++k)
+            {
+                const std::complex<float> w = twiddles[k * stride];
+                for (size_t c = 0; c < Channels; ++c)
+                {
+                    const std::complex<float> t = multiply(w, odd[c * channelStride + k]);
+                    odd[c * channelStride + k] = even[c * channelStride + k] - t;
+                    even[c * channelStride + k] = even[c * channelStride + k] + t;
+                }
+            }
+        }
+    }
+}
+
+FFTLibrary::FFTLibrary(float sampleRate, size_t fftSize)
+    : m_sampleRate(sampleRate), m_transformMode(TransformMode::Real), m_magnitudeBackend(MagnitudeBackend::FFT),
+      m_goertzel(sampleRate), m_windowType(WindowType::Hann), m_kaiserBeta(8.6f), m_amplitudeCalibration(false),
+      m_windowError(false), m_tableSize(0), m_tableBits(0)
+{
+    if (fftSize > 1)
+    {
+        prepareTables(fftSize);
+        getWindowTable(fftSize);
+    }
+}
+
+// Build the twiddle and bit-reversal tables once per transform size.
+// Tables built for N also serve every smaller power-of-two size (by striding).
+void FFTLibrary::prepareTables(size_t size)
+{
+    if (size <= m_tableSize && m_tableSize % size == 0)
+    {
+        return;
+    }
+    m_tableSize = size;
+    m_tableBits = log2Size(size);
+
+    // Twiddles use the same argument expression as the old recursive FFT so results stay bit-identical
+    m_twiddles.resize(size / 2);
+    for (size_t k = 0; k < size / 2; ++k)
+    {
+        m_twiddles[k] = std::polar(1.0f, (float)(-2.0 * M_PI * k / size));
+    }
+
+    m_bitReverse.resize(size);
+    for (size_t i = 0; i < size; ++i)
+    {
+        size_t reversed = 0;
+        for (size_t b = 0; b < m_tableBits; ++b)
+        {
+            reversed |= ((i >> b) & 1) << (m_tableBits - 1 - b);
+        }
+        m_bitReverse[i] = reversed;
+    }
+}
+
+void FFTLibrary::setMagnitudeBackend(MagnitudeBackend backend)
+{
+    m_magnitudeBackend = backend;
+
+    // Build the Goertzel window now so the detection calls don't allocate
+    if (backend == MagnitudeBackend::Goertzel && m_tableSize > 1 && !m_goertzel.prepare(m_tableSize))
+    {
+        m_windowError = true;
+    }
+}
+
+void FFTLibrary::setWindow(WindowType type, float kaiserBeta)
+{
+    m_windowType = type;
+    m_kaiserBeta = kaiserBeta;
+    m_goertzel.setWindow(type, kaiserBeta);
+
+    // Build the tables now so the detection calls don't allocate
+    if (m_tableSize > 1)
+    {
+        getWindowTable(m_tableSize);
+        if (m_magnitudeBackend == MagnitudeBackend::Goertzel && !m_goertzel.prepare(m_tableSize))
+        {
+            m_windowError = true;
+        }
+    }
+}
+
+const WindowTable *FFTLibrary::getWindowTable(size_t N)
+{
+    const WindowTable *table = WindowCache::shared().get(m_windowType, N, m_kaiserBeta);
+    if (table == nullptr)
+    {
+        m_windowError = true;
+    }
+    return table;
+}
+
+// No window: 0, like the failed transform, rather than a level on another scale
+float FFTLibrary::magnitudeScale(size_t N)
+{
+    const WindowTable *window = getWindowTable(N);
+    if (window == nullptr)
+    {
+        return 0.0f;
+    }
+    if (m_amplitudeCalibration)
+    {
+        return 2.0f / window->sum;
+    }
+    if (m_windowType == WindowType::Hann)
+    {
+        return 1.0f;
+    }
+    // A symmetric N-point Hann window sums to (N - 1) / 2
+    return 0.5f * (float)(N - 1) / window->sum;
+}
 
 // Helper function for parabolic interpolation
 float FFTLibrary::findInterpolatedFrequency(const std::vector<std::complex<float>> &fft_data, float sample_rate)
 {
-    const size_t N = fft_data.size();
+    return findInterpolatedFrequency(fft_data.data(), fft_data.size(), sample_rate);
+}
+
+// Parabolic interpolation over the first N/2 bins of an N-point spectrum
+float FFTLibrary::findInterpolatedFrequency(const std::complex<float> *fft_data, size_t N, float sample_rate)
+{
     float max_mag = 0.0f;
     size_t max_index = 0;
 
@@ -61,99 +211,280 @@ void FFTLibrary::applyHanningWindow(std::vector<std::complex<float>> &signal)
     const size_t N = signal.size();
     for (size_t i = 0; i < N; ++i)
     {
-        float window_value = 0.5f * (1.0f - cosf((float)(2.0 * M_PI * i / (N - 1))));
-        signal[i] *= window_value;
+        signal[i] *= WindowCache::value(WindowType::Hann, i, N, 0.0f);
     }
 }
 
-// Recursive Cooley-Tukey Radix-2 FFT implementation.
+// Iterative Cooley-Tukey Radix-2 FFT implementation.
 void FFTLibrary::fft(std::vector<std::complex<float>> &signal)
 {
-    const size_t N = signal.size();
-    if (N <= 1)
+    fftInPlace(signal.data(), signal.size());
+}
+
+// In-place decimation-in-time FFT: bit-reversal permutation followed by log2(N) butterfly stages.
+// Runs the same transform on channels frames spaced channelStride apart, loading each
+// twiddle and permutation index once for all of them.
+void FFTLibrary::fftInPlace(std::complex<float> *data, size_t size, size_t channels, size_t channelStride)
+{
+    if (size <= 1)
         return;
 
-    // Split into even and odd parts
-    std::vector<std::complex<float>> even(N / 2);
-    std::vector<std::complex<float>> odd(N / 2);
-    for (size_t i = 0; i < N / 2; ++i)
+    prepareTables(size);
+    const size_t tableStride = m_tableSize / size;
+    const size_t reverseShift = m_tableBits - log2Size(size);
+
+    // Reorder input into bit-reversed order
+    for (size_t i = 0; i < size; ++i)
+    {
+        size_t j = m_bitReverse[i] >> reverseShift;
+        if (i < j)
+        {
+            for (size_t c = 0; c < channels; ++c)
+            {
+                std::swap(data[c * channelStride + i], data[c * channelStride + j]);
+            }
+        }
+    }
+
+    // Channel count is a template parameter so the per-twiddle channel loop unrolls
+    for (size_t first = 0; first < channels; first += kMaxBatchChannels)
     {
-        even[i] = signal[2 * i];
-        odd[i] = signal[2 * i + 1];
+        std::complex<float> *group = data + first * channelStride;
+        switch (channels - first)
+        {
+        case 1:
+            butterflyStages<1>(group, size, channelStride, m_twiddles.data(), tableStride);
+            break;
+        case 2:
+            butterflyStages<2>(group, size, channelStride, m_twiddles.data(), tableStride);
+            break;
+        case 3:
+            butterflyStages<3>(group, size, channelStride, m_twiddles.data(), tableStride);
+            break;
+        default:
+            butterflyStages<4>(group, size, channelStride, m_twiddles.data(), tableStride);
+            break;
+        }
     }
+}
+
+// Real-input FFT. On entry data[n] holds (x[2n], x[2n+1]) for n < size / 2; on return
+// data[0..size / 2] holds bins 0..size / 2 of the size-point spectrum of x.
+// Like fftInPlace, processes channels frames spaced channelStride apart.
+void FFTLibrary::realFFTInPlace(std::complex<float> *data, size_t size, size_t channels, size_t channelStride)
+{
+    const size_t half = size / 2;
 
-    // Recurse
-    fft(even);
-    fft(odd);
+    // Tables for the full size also cover the half-size complex transform
+    prepareTables(size);
+    fftInPlace(data, half, channels, channelStride);
 
-    // Combine
-    for (size_t k = 0; k < N / 2; ++k)
+    const size_t tableStride = m_tableSize / size;
+
+    // DC and Nyquist are purely real
+    for (size_t c = 0; c < channels; ++c)
     {
-        std::complex<float> t = std::polar(1.0f, (float)(-2.0 * M_PI * k / N)) * odd[k];
-        signal[k] = even[k] + t;
-        signal[k + N / 2] = even[k] - t;
+        std::complex<float> *channel = data + c * channelStride;
+        const std::complex<float> z0 = channel[0];
+        channel[0] = std::complex<float>(z0.real() + z0.imag(), 0.0f);
+        channel[half] = std::complex<float>(z0.real() - z0.imag(), 0.0f);
+    }
+
+    // Split the packed spectrum: X[k] = E[k] + W^k * O[k], processing bins k and half - k together
+    for (size_t k = 1; k <= half / 2; ++k)
+    {
+        const size_t m = half - k;
+        const std::complex<float> wk = m_twiddles[k * tableStride];
+        const std::complex<float> wm = m_twiddles[m * tableStride];
+
+        for (size_t c = 0; c < channels; ++c)
+        {
+            std::complex<float> *channel = data + c * channelStride;
+            const std::complex<float> zk = channel[k];
+            const std::complex<float> zm = channel[m];
+
+            const std::complex<float> evenK = 0.5f * (zk + std::conj(zm));
+            const std::complex<float> oddK = std::complex<float>(0.0f, -0.5f) * (zk - std::conj(zm));
+            const std::complex<float> evenM = std::conj(evenK);
+            const std::complex<float> oddM = std::complex<float>(0.0f, -0.5f) * (zm - std::conj(zk));
+
+            channel[k] = evenK + multiply(wk, oddK);
+            channel[m] = evenM + multiply(wm, oddM);
+        }
     }
 }
 
-// Pitch detection function
-float FFTLibrary::detectPitch(const float *audio_buffer, size_t buffer_size)
+// Window num_channels inputs and transform them together with the selected mode. Channel c's
+// spectrum starts at workspace[c * workspaceSize(N, mode)]; bins 0..N/2 are valid.
+// Returns false if the workspace is too small or the window cache is full.
+bool FFTLibrary::computeSpectra(const float *const *audio_buffers, size_t num_channels, size_t buffer_size,
+                                std::complex<float> *workspace, size_t workspace_size)
 {
-    // Create a complex vector for the FFT
-    std::vector<std::complex<float>> fftSignal(buffer_size, {0.0f, 0.0f});
+    const size_t channelStride = workspaceSize(buffer_size, m_transformMode);
+    if (workspace == nullptr || workspace_size < num_channels * channelStride)
+    {
+        return false;
+    }
 
-    // Copy the audio data from our input buffer into the complex vector
+    const WindowTable *table = getWindowTable(buffer_size);
+    if (table == nullptr)
+    {
+        return false;
+    }
+    const float *window = table->coefficients.data();
+
+    if (m_transformMode == TransformMode::Real && buffer_size >= 4)
+    {
+        // Pack even/odd samples into the real/imaginary parts of an N/2-point complex signal
+        for (size_t n = 0; n < buffer_size / 2; ++n)
+        {
+            const float w0 = window[2 * n];
+            const float w1 = window[2 * n + 1];
+            for (size_t c = 0; c < num_channels; ++c)
+            {
+                workspace[c * channelStride + n] = std::complex<float>(audio_buffers[c][2 * n] * w0,
+                                                                       audio_buffers[c][2 * n + 1] * w1);
+            }
+        }
+        realFFTInPlace(workspace, buffer_size, num_channels, channelStride);
+        return true;
+    }
+
+    // Copy the windowed audio data from our input buffers into the complex workspace
     for (size_t i = 0; i < buffer_size; ++i)
     {
-        fftSignal[i] = std::complex<float>(audio_buffer[i], 0.0f);
+        for (size_t c = 0; c < num_channels; ++c)
+        {
+            workspace[c * channelStride + i] = std::complex<float>(audio_buffers[c][i] * window[i], 0.0f);
+        }
     }
 
-    applyHanningWindow(fftSignal);
-    fft(fftSignal);
+    fftInPlace(workspace, buffer_size, num_channels, channelStride);
+    return true;
+}
+
+// Pitch detection function
+float FFTLibrary::detectPitch(const float *audio_buffer, size_t buffer_size)
+{
+    std::vector<std::complex<float>> fftSignal(workspaceSize(buffer_size, m_transformMode));
+    return detectPitch(audio_buffer, buffer_size, fftSignal.data(), fftSignal.size());
+}
+
+float FFTLibrary::detectPitch(const float *audio_buffer, size_t buffer_size, std::complex<float> *workspace,
+                              size_t workspace_size)
+{
+    if (!computeSpectra(&audio_buffer, 1, buffer_size, workspace, workspace_size))
+    {
+        return 0.0f;
+    }
 
     // Find the fundamental frequency using interpolation
-    return findInterpolatedFrequency(fftSignal, m_sampleRate);
+    return findInterpolatedFrequency(workspace, buffer_size, m_sampleRate);
 }
 
 // Level detection function - get magnitude at specific frequency with tolerance
 float FFTLibrary::getFrequencyMagnitude(const float *audio_buffer, size_t buffer_size, float target_freq, float tolerance)
 {
-    // Create a complex vector for the FFT
-    std::vector<std::complex<float>> fftSignal(buffer_size, {0.0f, 0.0f});
+    if (m_magnitudeBackend == MagnitudeBackend::Goertzel)
+    {
+        return getFrequencyMagnitude(audio_buffer, buffer_size, target_freq, tolerance, nullptr, 0);
+    }
 
-    // Copy the audio data from our input buffer into the complex vector
-    for (size_t i = 0; i < buffer_size; ++i)
+    std::vector<std::complex<float>> fftSignal(workspaceSize(buffer_size, m_transformMode));
+    return getFrequencyMagnitude(audio_buffer, buffer_size, target_freq, tolerance, fftSignal.data(), fftSignal.size());
+}
+
+float FFTLibrary::getFrequencyMagnitude(const float *audio_buffer, size_t buffer_size, float target_freq, float tolerance,
+                                        std::complex<float> *workspace, size_t workspace_size)
+{
+    if (m_magnitudeBackend == MagnitudeBackend::Goertzel)
     {
-        fftSignal[i] = std::complex<float>(audio_buffer[i], 0.0f);
+        return m_goertzel.getFrequencyMagnitude(audio_buffer, buffer_size, target_freq, tolerance) * magnitudeScale(buffer_size);
     }
 
-    applyHanningWindow(fftSignal);
-    fft(fftSignal);
+    if (!computeSpectra(&audio_buffer, 1, buffer_size, workspace, workspace_size))
+    {
+        return 0.0f;
+    }
 
-    // Calculate frequency bounds with tolerance
-    float lower_freq = target_freq * (1.0f - tolerance);
-    float upper_freq = target_freq * (1.0f + tolerance);
+    return sumBandMagnitude(workspace, buffer_size, m_sampleRate, target_freq, tolerance) * magnitudeScale(buffer_size);
+}
 
-    // Calculate bin indices for the frequency range
-    size_t lower_bin = (size_t)(lower_freq * buffer_size / m_sampleRate);
-    size_t upper_bin = (size_t)(upper_freq * buffer_size / m_sampleRate);
+// Batched level detection - band magnitude for each of num_channels equal-length buffers
+void FFTLibrary::getFrequencyMagnitudes(const float *const *audio_buffers, size_t num_channels, size_t buffer_size,
+                                        float target_freq, float tolerance, float *magnitudes)
+{
+    if (m_magnitudeBackend == MagnitudeBackend::Goertzel)
+    {
+        getFrequencyMagnitudes(audio_buffers, num_channels, buffer_size, target_freq, tolerance, magnitudes, nullptr, 0);
+        return;
+    }
 
-    // Ensure we're within valid range (first half of FFT)
-    if (lower_bin >= buffer_size / 2)
+    std::vector<std::complex<float>> fftSignals(num_channels * workspaceSize(buffer_size, m_transformMode));
+    getFrequencyMagnitudes(audio_buffers, num_channels, buffer_size, target_freq, tolerance, magnitudes,
+                           fftSignals.data(), fftSignals.size());
+}
+
+void FFTLibrary::getFrequencyMagnitudes(const float *const *audio_buffers, size_t num_channels, size_t buffer_size,
+                                        float target_freq, float tolerance, float *magnitudes,
+                                        std::complex<float> *workspace, size_t workspace_size)
+{
+    const float scale = magnitudeScale(buffer_size);
+
+    if (m_magnitudeBackend == MagnitudeBackend::Goertzel)
     {
-        lower_bin = buffer_size / 2 - 1;
+        m_goertzel.getFrequencyMagnitudes(audio_buffers, num_channels, buffer_size, target_freq, tolerance, magnitudes);
+        for (size_t c = 0; c < num_channels; ++c)
+        {
+            magnitudes[c] *= scale;
+        }
+        return;
+    }
+
+    if (!computeSpectra(audio_buffers, num_channels, buffer_size, workspace, workspace_size))
+    {
+        for (size_t c = 0; c < num_channels; ++c)
+        {
+            magnitudes[c] = 0.0f;
+        }
+        return;
+    }
+
+    const size_t channelStride = workspaceSize(buffer_size, m_transformMode);
+    for (size_t c = 0; c < num_channels; ++c)
+    {
+        magnitudes[c] = sumBandMagnitude(workspace + c * channelStride, buffer_size, m_sampleRate, target_freq, tolerance) * scale;
     }
-    if (upper_bin >= buffer_size / 2)
+}
+
+// Single transform shared by any number of queries on the frame
+bool FFTLibrary::computeFrame(const float *audio_buffer, size_t buffer_size, SpectrumFrame &frame)
+{
+    const size_t slots = workspaceSize(buffer_size, m_transformMode);
+    std::complex<float> *workspace = frame.prepare(buffer_size, m_sampleRate, slots);
+    if (!computeSpectra(&audio_buffer, 1, buffer_size, workspace, slots))
     {
-        upper_bin = buffer_size / 2 - 1;
+        return false;
     }
+    frame.finish(magnitudeScale(buffer_size));
+    return true;
+}
+
+// Sum bin magnitudes of an N-point spectrum within target_freq * (1 +/- tolerance)
+float FFTLibrary::sumBandMagnitude(const std::complex<float> *spectrum, size_t buffer_size, float sample_rate,
+                                   float target_freq, float tolerance)
+{
+    size_t lower_bin = 0;
+    size_t upper_bin = 0;
+    GoertzelDetector::bandBins(buffer_size, sample_rate, target_freq, tolerance, lower_bin, upper_bin);
 
     // Sum the magnitudes within the frequency range
     float total_magnitude = 0.0f;
     for (size_t bin = lower_bin; bin <= upper_bin; ++bin)
     {
-        float magnitude = std::sqrt(std::norm(fftSignal[bin]));
+        float magnitude = std::sqrt(std::norm(spectrum[bin]));
         total_magnitude += magnitude;
     }
 
     return total_magnitude;
-}
\ No newline at end of file
+}
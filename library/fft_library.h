@@ -1,14 +1,32 @@
 #pragma once
 
+#include "goertzel_detector.h"
+#include "spectrum_frame.h"
+#include "window_functions.h"
 #include <complex>
 #include <vector>
 
 class FFTLibrary
 {
 public:
-    FFTLibrary(float sampleRate);
+    // How detectPitch / getFrequencyMagnitude transform their (real) input
+    enum class TransformMode
+    {
+        Real,    // N/2-point complex FFT of packed samples plus a split pass (default)
+        Complex, // N-point complex FFT with zero imaginary parts
+    };
+
+    // How getFrequencyMagnitude evaluates the band
+    enum class MagnitudeBackend
+    {
+        FFT,      // full spectrum, then sum the band bins (default)
+        Goertzel, // evaluate only the band bins; cheaper when the band is a few bins wide
+    };
+
+    // fftSize (optional) pre-builds the twiddle, bit-reversal and window tables for that size
+    FFTLibrary(float sampleRate, size_t fftSize = 0);
     
-    // Main FFT function
+    // Main FFT function (iterative, in-place radix-2; size must be a power of two)
     void fft(std::vector<std::complex<float>>& signal);
     
     // Pitch detection function
@@ -16,12 +34,104 @@ public:
     
     // Level detection function - get magnitude at specific frequency with tolerance
     float getFrequencyMagnitude(const float* audio_buffer, size_t buffer_size, float target_freq, float tolerance = 0.05f);
+
+    // Zero-allocation variants: the transform runs in a caller-owned workspace of at least
+    // workspaceSize(buffer_size, getTransformMode()) elements (place it in DTCM, SDRAM, ...).
+    // Return 0 if the workspace is too small. Tables must already cover buffer_size (pass
+    // fftSize to the constructor), otherwise the first call builds them.
+    float detectPitch(const float* audio_buffer, size_t buffer_size, std::complex<float>* workspace, size_t workspace_size);
+    float getFrequencyMagnitude(const float* audio_buffer, size_t buffer_size, float target_freq, float tolerance,
+                                std::complex<float>* workspace, size_t workspace_size);
+
+    // Batched level detection: band magnitudes of num_channels equal-length buffers in one call.
+    // The transforms run together so each twiddle and window value is loaded once for all channels.
+    // magnitudes receives num_channels values; the workspace needs num_channels * workspaceSize(N) elements.
+    void getFrequencyMagnitudes(const float* const* audio_buffers, size_t num_channels, size_t buffer_size,
+                                float target_freq, float tolerance, float* magnitudes);
+    void getFrequencyMagnitudes(const float* const* audio_buffers, size_t num_channels, size_t buffer_size,
+                                float target_freq, float tolerance, float* magnitudes,
+                                std::complex<float>* workspace, size_t workspace_size);
+
+    // Transform once and keep the spectrum in frame for repeated queries (several band targets,
+    // pitch, peaks, noise floor). Always uses the FFT, whatever the magnitude backend; the frame's
+    // storage is reused, so there is no allocation once it has seen this buffer size.
+    bool computeFrame(const float* audio_buffer, size_t buffer_size, SpectrumFrame& frame);
+
+    // Workspace elements needed for an N-point frame (per channel)
+    static constexpr size_t workspaceSize(size_t N, TransformMode mode = TransformMode::Real)
+    {
+        return (mode == TransformMode::Real && N >= 4) ? N / 2 + 1 : N;
+    }
+
+    // Select the transform used by the detection functions
+    void setTransformMode(TransformMode mode) { m_transformMode = mode; }
+    TransformMode getTransformMode() const { return m_transformMode; }
+
+    // Select the backend used by getFrequencyMagnitude
+    void setMagnitudeBackend(MagnitudeBackend backend);
+    MagnitudeBackend getMagnitudeBackend() const { return m_magnitudeBackend; }
+
+    // Select the analysis window (Hann by default). Tables are built once per size and cached.
+    void setWindow(WindowType type, float kaiserBeta = 8.6f);
+    WindowType getWindowType() const { return m_windowType; }
+
+    // Coefficients, coherent gain and ENBW of the selected window for an N-point frame
+    // (nullptr once WindowCache::kMaxTables other windows have been built)
+    const WindowTable* getWindowTable(size_t N);
+
+    // False once a window table could not be built because the shared WindowCache is full. The
+    // tables for fftSize are built by the constructor and setWindow(), so check this after setup:
+    // the detection calls return 0 for a size without a window.
+    bool isValid() const { return !m_windowError; }
+
+    // getFrequencyMagnitude scaling. Off (default): every window is scaled to the level the Hann
+    // window gives, so existing thresholds keep working. On: the result is the amplitude of an
+    // on-bin sine (sum of |X[k]| * 2 / sum(w)).
+    void setAmplitudeCalibration(bool enabled) { m_amplitudeCalibration = enabled; }
     
     // Utility functions
     static void applyHanningWindow(std::vector<std::complex<float>>& signal);
     static float findInterpolatedFrequency(const std::vector<std::complex<float>>& fft_data, 
                                          float sample_rate);
 
+    // Raw-pointer variants; only the first N/2 + 1 bins of an N-point spectrum are read
+    static float findInterpolatedFrequency(const std::complex<float>* fft_data, size_t N, float sample_rate);
+    static float sumBandMagnitude(const std::complex<float>* spectrum, size_t N, float sample_rate,
+                                  float target_freq, float tolerance);
+
 private:
+    // Build twiddle and bit-reversal tables (no-op if the current tables already cover this size)
+    void prepareTables(size_t size);
+
+    // In-place transform on raw storage using the precomputed tables
+    // (channels frames, channelStride elements apart, transformed together)
+    void fftInPlace(std::complex<float>* data, size_t size, size_t channels = 1, size_t channelStride = 0);
+
+    // Real-input transform of size points packed as size / 2 complex values (needs size / 2 + 1 slots)
+    void realFFTInPlace(std::complex<float>* data, size_t size, size_t channels = 1, size_t channelStride = 0);
+
+    // Windowed spectra of real buffers using the selected transform mode, one per workspaceSize() slot
+    bool computeSpectra(const float* const* audio_buffers, size_t num_channels, size_t buffer_size,
+                        std::complex<float>* workspace, size_t workspace_size);
+
+    // Channels transformed together per pass in the batched paths
+    static constexpr size_t kMaxBatchChannels = 4;
+
+    // Window-dependent factor applied to getFrequencyMagnitude results
+    float magnitudeScale(size_t N);
+
     float m_sampleRate;
-}; 
\ No newline at end of file
+    TransformMode m_transformMode;
+    MagnitudeBackend m_magnitudeBackend;
+    GoertzelDetector m_goertzel;
+    WindowType m_windowType;
+    float m_kaiserBeta;
+    bool m_amplitudeCalibration;
+    bool m_windowError;
+
+    // Precomputed tables for m_tableSize points
+    size_t m_tableSize;
+    size_t m_tableBits;
+    std::vector<std::complex<float>> m_twiddles;  // e^(-2*pi*i*k/N), k < N/2
+    std::vector<size_t> m_bitReverse;             // bit-reversed index permutation
+}; 
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "fft_library.h"
+#include <array>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+// Compile-time helpers for FixedFFT (C++14 constexpr, no <cmath> at compile time)
+namespace fixed_fft_detail
+{
+constexpr double kPi = 3.14159265358979323846;
+
+// Wrap an angle into [-pi, pi]
+constexpr double wrapAngle(double x)
+{
+    while (x > kPi)
+    {
+        x -= 2.0 * kPi;
+    }
+    while (x < -kPi)
+    {
+        x += 2.0 * kPi;
+    }
+    return x;
+}
+
+// Taylor series, accurate to double precision on [-pi, pi]
+constexpr double sinValue(double x)
+{
+    x = wrapAngle(x);
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 16; ++n)
+    {
+        term *= -x * x / ((2.0 * n) * (2.0 * n + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double cosValue(double x)
+{
+    x = wrapAngle(x);
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 16; ++n)
+    {
+        term *= -x * x / ((2.0 * n - 1.0) * (2.0 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr size_t log2Size(size_t size)
+{
+    size_t bits = 0;
+    while (((size_t)1 << bits) < size)
+    {
+        ++bits;
+    }
+    return bits;
+}
+
+// Twiddles, bit-reversal permutation and Hann window for an N-point real FFT,
+// which runs as an N/2-point complex FFT followed by a split pass
+template <size_t N>
+struct Tables
+{
+    float twiddleRe[N / 2];        // cos(-2*pi*k/N), k < N/2
+    float twiddleIm[N / 2];        // sin(-2*pi*k/N), k < N/2
+    uint16_t bitReverse[N / 2];    // permutation for the N/2-point inner transform
+    float window[N];               // Hann, same definition as FFTLibrary::applyHanningWindow
+
+    constexpr Tables() : twiddleRe(), twiddleIm(), bitReverse(), window()
+    {
+        for (size_t k = 0; k < N / 2; ++k)
+        {
+            twiddleRe[k] = (float)cosValue(-2.0 * kPi * k / N);
+            twiddleIm[k] = (float)sinValue(-2.0 * kPi * k / N);
+        }
+
+        const size_t bits = log2Size(N / 2);
+        for (size_t i = 0; i < N / 2; ++i)
+        {
+            size_t reversed = 0;
+            for (size_t b = 0; b < bits; ++b)
+            {
+                reversed |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            bitReverse[i] = (uint16_t)reversed;
+        }
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            window[i] = (float)(0.5 * (1.0 - cosValue(2.0 * kPi * i / (N - 1))));
+        }
+    }
+};
+} // namespace fixed_fft_detail
+
+// FFT of a fixed, power-of-two size N known at compile time.
+// All tables are constexpr (placed in flash), the work buffer is a member array,
+// and the per-call path does no heap allocation or table building.
+template <size_t N>
+class FixedFFT
+{
+    static_assert(N >= 4 && (N & (N - 1)) == 0, "FixedFFT size must be a power of two >= 4");
+    static_assert(N / 2 <= 65536, "FixedFFT bit-reversal table is 16-bit");
+
+public:
+    static constexpr size_t kSize = N;
+    static constexpr size_t kBins = N / 2 + 1;
+
+    explicit FixedFFT(float sampleRate) : m_sampleRate(sampleRate) {}
+
+    void setSampleRate(float sampleRate) { m_sampleRate = sampleRate; }
+
+    // Pitch detection function (reads N samples)
+    float detectPitch(const float* audio_buffer)
+    {
+        transform(audio_buffer);
+        return FFTLibrary::findInterpolatedFrequency(m_work.data(), N, m_sampleRate);
+    }
+
+    // Level detection function - get magnitude at specific frequency with tolerance (reads N samples)
+    float getFrequencyMagnitude(const float* audio_buffer, float target_freq, float tolerance = 0.05f)
+    {
+        transform(audio_buffer);
+        return FFTLibrary::sumBandMagnitude(m_work.data(), N, m_sampleRate, target_freq, tolerance);
+    }
+
+    // Hann-windowed real FFT of N samples; returns bins 0..N/2
+    const std::array<std::complex<float>, kBins>& transform(const float* audio_buffer)
+    {
+        // Pack even/odd samples into the real/imaginary parts of an N/2-point complex signal
+        for (size_t n = 0; n < kHalf; ++n)
+        {
+            m_work[n] = std::complex<float>(audio_buffer[2 * n] * kTables.window[2 * n],
+                                            audio_buffer[2 * n + 1] * kTables.window[2 * n + 1]);
+        }
+
+        // Reorder into bit-reversed order
+        for (size_t i = 0; i < kHalf; ++i)
+        {
+            const size_t j = kTables.bitReverse[i];
+            if (i < j)
+            {
+                std::swap(m_work[i], m_work[j]);
+            }
+        }
+
+        runStages<2>(std::integral_constant<bool, (2 > kHalf)>());
+        split();
+        return m_work;
+    }
+
+private:
+    static constexpr size_t kHalf = N / 2;
+    static constexpr fixed_fft_detail::Tables<N> kTables = fixed_fft_detail::Tables<N>();
+
+    static std::complex<float> twiddle(size_t k)
+    {
+        return std::complex<float>(kTables.twiddleRe[k], kTables.twiddleIm[k]);
+    }
+
+    // Complex multiply without the library's NaN/Inf recovery path
+    static std::complex<float> multiply(const std::complex<float>& a, const std::complex<float>& b)
+    {
+        return std::complex<float>(a.real() * b.real() - a.imag() * b.imag(),
+                                   a.real() * b.imag() + a.imag() * b.real());
+    }
+
+    // One radix-2 stage per instantiation; the recursion unrolls all log2(N/2) stages at compile time
+    template <size_t Span>
+    void runStages(std::true_type)
+    {
+    }
+
+    template <size_t Span>
+    void runStages(std::false_type)
+    {
+        constexpr size_t half = Span / 2;
+        constexpr size_t stride = N / Span; // inner transform is N/2 points on an N-point table
+        for (size_t start = 0; start < kHalf; start += Span)
+        {
+            std::complex<float>* even = m_work.data() + start;
+            std::complex<float>* odd = even + half;
+            for (size_t k = 0; k < half; ++k)
+            {
+                const std::complex<float> t = multiply(twiddle(k * stride), odd[k]);
+                odd[k] = even[k] - t;
+                even[k] = even[k] + t;
+            }
+        }
+        runStages<Span * 2>(std::integral_constant<bool, (Span * 2 > kHalf)>());
+    }
+
+    // Recover bins 0..N/2 of the real signal from the packed N/2-point spectrum
+    void split()
+    {
+        const std::complex<float> z0 = m_work[0];
+        m_work[0] = std::complex<float>(z0.real() + z0.imag(), 0.0f);
+        m_work[kHalf] = std::complex<float>(z0.real() - z0.imag(), 0.0f);
+
+        for (size_t k = 1; k <= kHalf / 2; ++k)
+        {
+            const size_t m = kHalf - k;
+            const std::complex<float> zk = m_work[k];
+            const std::complex<float> zm = m_work[m];
+
+            const std::complex<float> evenK = 0.5f * (zk + std::conj(zm));
+            const std::complex<float> oddK = std::complex<float>(0.0f, -0.5f) * (zk - std::conj(zm));
+            const std::complex<float> evenM = std::conj(evenK);
+            const std::complex<float> oddM = std::complex<float>(0.0f, -0.5f) * (zm - std::conj(zk));
+
+            m_work[k] = evenK + multiply(twiddle(k), oddK);
+            m_work[m] = evenM + multiply(twiddle(m), oddM);
+        }
+    }
+
+    float m_sampleRate;
+    std::array<std::complex<float>, kBins> m_work;
+};
+
+template <size_t N>
+constexpr fixed_fft_detail::Tables<N> FixedFFT<N>::kTables;
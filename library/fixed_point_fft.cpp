@@ -0,0 +1,229 @@
+#include "fixed_point_fft.h"
+#include "goertzel_detector.h"
+#include "window_functions.h"
+#include <cmath>
+
+// Define M_PI if not available in the C++ standard library
+#ifndef M_PI
+#define M_PI 3.14159265358979323846f
+#endif
+
+// Per-format arithmetic: full scale, wide accumulator and fractional bits
+template <typename T>
+struct FixedPointTraits;
+
+template <>
+struct FixedPointTraits<int16_t>
+{
+    typedef int32_t Wide;
+    static constexpr int kFractionBits = 15;
+    static constexpr int32_t kMax = 32767;
+};
+
+template <>
+struct FixedPointTraits<int32_t>
+{
+    typedef int64_t Wide;
+    static constexpr int kFractionBits = 31;
+    static constexpr int64_t kMax = 2147483647;
+};
+
+// Absolute value in the wide type, so the most negative sample does not overflow
+template <typename Wide, typename T>
+static inline Wide absWide(T value)
+{
+    return value < 0 ? -(Wide)value : (Wide)value;
+}
+
+// Integer square root (floor) of a 64-bit value
+static uint64_t isqrt64(uint64_t value)
+{
+    uint64_t result = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > value)
+    {
+        bit >>= 2;
+    }
+    while (bit != 0)
+    {
+        if (value >= result + bit)
+        {
+            value -= result + bit;
+            result = (result >> 1) + bit;
+        }
+        else
+        {
+            result >>= 1;
+        }
+        bit >>= 2;
+    }
+    return result;
+}
+
+template <typename T>
+T FixedPointFFT<T>::fromFloat(float sample)
+{
+    typedef FixedPointTraits<T> Traits;
+    const double scaled = (double)sample * ((double)Traits::kMax + 1.0);
+    if (scaled >= (double)Traits::kMax)
+    {
+        return (T)Traits::kMax;
+    }
+    if (scaled <= -(double)Traits::kMax - 1.0)
+    {
+        return (T)(-Traits::kMax - 1);
+    }
+    return (T)lrint(scaled);
+}
+
+template <typename T>
+T FixedPointFFT<T>::multiplyQ(T a, T b)
+{
+    typedef FixedPointTraits<T> Traits;
+    const typename Traits::Wide product = (typename Traits::Wide)a * b;
+    return (T)((product + ((typename Traits::Wide)1 << (Traits::kFractionBits - 1))) >> Traits::kFractionBits);
+}
+
+template <typename T>
+FixedPointFFT<T>::FixedPointFFT(float sampleRate, size_t fftSize)
+    : m_sampleRate(sampleRate), m_size(fftSize), m_window(fftSize), m_twiddleRe(fftSize / 2), m_twiddleIm(fftSize / 2),
+      m_bitReverse(fftSize), m_re(fftSize), m_im(fftSize)
+{
+    for (size_t i = 0; i < fftSize; ++i)
+    {
+        m_window[i] = fromFloat(WindowCache::value(WindowType::Hann, i, fftSize, 0.0f));
+    }
+
+    for (size_t k = 0; k < fftSize / 2; ++k)
+    {
+        const double angle = -2.0 * M_PI * k / fftSize;
+        m_twiddleRe[k] = fromFloat((float)cos(angle));
+        m_twiddleIm[k] = fromFloat((float)sin(angle));
+    }
+
+    size_t bits = 0;
+    while (((size_t)1 << bits) < fftSize)
+    {
+        ++bits;
+    }
+    for (size_t i = 0; i < fftSize; ++i)
+    {
+        size_t reversed = 0;
+        for (size_t b = 0; b < bits; ++b)
+        {
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        m_bitReverse[i] = (uint16_t)reversed;
+    }
+}
+
+template <typename T>
+int FixedPointFFT<T>::transform(const T *samples, size_t stride)
+{
+    typedef FixedPointTraits<T> Traits;
+    typedef typename Traits::Wide Wide;
+    const size_t N = m_size;
+
+    // Window and store in bit-reversed order, tracking the block peak
+    Wide peak = 0;
+    for (size_t i = 0; i < N; ++i)
+    {
+        const T value = multiplyQ(samples[i * stride], m_window[i]);
+        m_re[m_bitReverse[i]] = value;
+        m_im[m_bitReverse[i]] = 0;
+        peak = absWide<Wide>(value) > peak ? absWide<Wide>(value) : peak;
+    }
+
+    // A butterfly output component is at most (1 + sqrt(2)) times the input peak,
+    // so keep the peak below 3/8 of full scale before each stage
+    const Wide headroom = (Wide)((Traits::kMax >> 2) + (Traits::kMax >> 3));
+    const Wide round = (Wide)1 << (Traits::kFractionBits - 1);
+    int exponent = 0;
+
+    for (size_t span = 2; span <= N; span <<= 1)
+    {
+        // Block-floating-point step: the shift is folded into this stage's butterflies
+        const int shift = peak > headroom ? 1 : 0;
+        exponent += shift;
+        peak = 0;
+
+        const size_t half = span / 2;
+        const size_t stride_tw = N / span;
+        for (size_t start = 0; start < N; start += span)
+        {
+            for (size_t k = 0; k < half; ++k)
+            {
+                const size_t even = start + k;
+                const size_t odd = even + half;
+                const T wr = m_twiddleRe[k * stride_tw];
+                const T wi = m_twiddleIm[k * stride_tw];
+                const T er = (T)(m_re[even] >> shift);
+                const T ei = (T)(m_im[even] >> shift);
+                const T orr = (T)(m_re[odd] >> shift);
+                const T oi = (T)(m_im[odd] >> shift);
+
+                // t = w * odd, rounded back to Q format
+                const T tr = (T)(((Wide)wr * orr - (Wide)wi * oi + round) >> Traits::kFractionBits);
+                const T ti = (T)(((Wide)wr * oi + (Wide)wi * orr + round) >> Traits::kFractionBits);
+
+                m_re[odd] = (T)(er - tr);
+                m_im[odd] = (T)(ei - ti);
+                m_re[even] = (T)(er + tr);
+                m_im[even] = (T)(ei + ti);
+
+                Wide stagePeak = absWide<Wide>(m_re[odd]);
+                stagePeak = absWide<Wide>(m_im[odd]) > stagePeak ? absWide<Wide>(m_im[odd]) : stagePeak;
+                stagePeak = absWide<Wide>(m_re[even]) > stagePeak ? absWide<Wide>(m_re[even]) : stagePeak;
+                stagePeak = absWide<Wide>(m_im[even]) > stagePeak ? absWide<Wide>(m_im[even]) : stagePeak;
+                peak = stagePeak > peak ? stagePeak : peak;
+            }
+        }
+    }
+
+    return exponent;
+}
+
+template <typename T>
+uint64_t FixedPointFFT<T>::getBandEnergy(const T *samples, size_t stride, float target_freq, float tolerance, int &exponent)
+{
+    exponent = transform(samples, stride);
+
+    size_t lower_bin = 0;
+    size_t upper_bin = 0;
+    GoertzelDetector::bandBins(m_size, m_sampleRate, target_freq, tolerance, lower_bin, upper_bin);
+
+    uint64_t energy = 0;
+    for (size_t bin = lower_bin; bin <= upper_bin; ++bin)
+    {
+        const int64_t re = m_re[bin];
+        const int64_t im = m_im[bin];
+        energy += (uint64_t)(re * re) + (uint64_t)(im * im);
+    }
+    return energy;
+}
+
+template <typename T>
+float FixedPointFFT<T>::getFrequencyMagnitude(const T *samples, size_t stride, float target_freq, float tolerance)
+{
+    typedef FixedPointTraits<T> Traits;
+    const int exponent = transform(samples, stride);
+
+    size_t lower_bin = 0;
+    size_t upper_bin = 0;
+    GoertzelDetector::bandBins(m_size, m_sampleRate, target_freq, tolerance, lower_bin, upper_bin);
+
+    // Integer per-bin magnitudes; convert to float once for the whole band
+    uint64_t total = 0;
+    for (size_t bin = lower_bin; bin <= upper_bin; ++bin)
+    {
+        const int64_t re = m_re[bin];
+        const int64_t im = m_im[bin];
+        total += isqrt64((uint64_t)(re * re) + (uint64_t)(im * im));
+    }
+
+    // Undo the Q scaling and the window/sample product's Q scaling, then the block exponent
+    return ldexpf((float)total, exponent - Traits::kFractionBits);
+}
+
+template class FixedPointFFT<int16_t>;
+template class FixedPointFFT<int32_t>;
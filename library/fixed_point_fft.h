@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed-point (Q15 / Q31) FFT and band detection with block-floating-point scaling.
+// Samples are signed fractions (Q15: int16_t, Q31: int32_t). Each radix-2 stage checks the
+// block peak and shifts the whole block right by one bit only when the next stage could
+// overflow; the number of shifts is returned as the block exponent.
+//
+// Input is read with a stride, so one channel of an interleaved buffer (as delivered to an
+// InterleavingAudioCallback, converted with fromFloat) can be analysed in place.
+template <typename T>
+class FixedPointFFT
+{
+public:
+    FixedPointFFT(float sampleRate, size_t fftSize);
+
+    // Saturating conversion from a float sample in [-1, 1)
+    static T fromFloat(float sample);
+
+    // Integer band energy: sum of |X[k]|^2 over the bins covering target_freq * (1 +/- tolerance),
+    // Hann windowed, in squared Q units. The true energy is the result * 4^exponent.
+    uint64_t getBandEnergy(const T* samples, size_t stride, float target_freq, float tolerance, int& exponent);
+
+    // Band magnitude (sum of |X[k]|) on the same scale as FFTLibrary::getFrequencyMagnitude
+    // for the equivalent float input (sample / full scale)
+    float getFrequencyMagnitude(const T* samples, size_t stride, float target_freq, float tolerance = 0.05f);
+
+    size_t getSize() const { return m_size; }
+
+private:
+    // Window, transform in place into m_data; returns the block exponent
+    int transform(const T* samples, size_t stride);
+
+    // Multiply two Q values with rounding
+    static T multiplyQ(T a, T b);
+
+    float m_sampleRate;
+    size_t m_size;
+    std::vector<T> m_window;         // Hann, Q format
+    std::vector<T> m_twiddleRe;      // cos(-2*pi*k/N), k < N/2, Q format
+    std::vector<T> m_twiddleIm;      // sin(-2*pi*k/N)
+    std::vector<uint16_t> m_bitReverse;
+    std::vector<T> m_re;             // work buffers
+    std::vector<T> m_im;
+};
+
+using FixedPointFFTQ15 = FixedPointFFT<int16_t>;
+using FixedPointFFTQ31 = FixedPointFFT<int32_t>;
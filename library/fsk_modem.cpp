@@ -0,0 +1,438 @@
+#include "fsk_modem.h"
+#include <cmath>
+
+// Define M_PI if not available in the C++ standard library
+#ifndef M_PI
+#define M_PI 3.14159265358979323846f
+#endif
+
+static void initCorrelator(std::complex<float> &rotation, std::complex<float> &leaving, float freq, float sampleRate,
+                           size_t windowSize, float damping)
+{
+    const double w = 2.0 * M_PI * freq / sampleRate;
+    rotation = std::complex<float>((float)cos(w), (float)-sin(w));
+    const double phase = fmod(w * windowSize, 2.0 * M_PI);
+    const float decay = powf(damping, (float)windowSize);
+    leaving = std::complex<float>(decay * (float)cos(phase), decay * (float)sin(phase));
+}
+
+FskDemodulator::FskDemodulator(float sampleRate, float markFreq, float spaceFreq, float baudRate)
+    : m_squelch(0.0f), m_proportionalGain(0.0f), m_integralGain(0.0f), m_historyPos(0), m_bitsPerSymbol(1),
+      m_rateCorrection(0.0f), m_phase(0.0f), m_metric(0.0f), m_symbolWrite(0), m_symbolRead(0),
+      m_droppedSymbols(0)
+{
+    const float tones[2] = {spaceFreq, markFreq};
+    init(sampleRate, tones, 2, baudRate, 1);
+}
+
+FskDemodulator::FskDemodulator(float sampleRate, const float *toneFreqs, size_t numTones, float baudRate,
+                               size_t numChannels)
+    : m_squelch(0.0f), m_proportionalGain(0.0f), m_integralGain(0.0f), m_historyPos(0), m_bitsPerSymbol(1),
+      m_rateCorrection(0.0f), m_phase(0.0f), m_metric(0.0f), m_symbolWrite(0), m_symbolRead(0),
+      m_droppedSymbols(0)
+{
+    init(sampleRate, toneFreqs, numTones, baudRate, numChannels);
+}
+
+void FskDemodulator::init(float sampleRate, const float *toneFreqs, size_t numTones, float baudRate,
+                          size_t numChannels)
+{
+    const float samplesPerSymbol = sampleRate / (baudRate > 0.0f ? baudRate : 1.0f);
+    m_windowSize = (size_t)lrintf(samplesPerSymbol);
+    if (m_windowSize < 2)
+    {
+        m_windowSize = 2;
+    }
+    m_numChannels = numChannels < 1 ? 1 : (numChannels > kMaxChannels ? kMaxChannels : numChannels);
+    m_history.assign(m_windowSize * m_numChannels, std::complex<float>(0.0f, 0.0f));
+    m_amplitudeScale = 2.0f / m_windowSize;
+    m_peakAverage = 0.0f;
+
+    // Equal weights until the channel SNRs are known
+    m_combining = Combining::MaximalRatio;
+    m_noiseRatio = 0.0f;
+    for (size_t c = 0; c < kMaxChannels; ++c)
+    {
+        m_weights[c] = c < m_numChannels ? 1.0f / m_numChannels : 0.0f;
+        m_signalAverage[c] = 0.0f;
+        m_noiseAverage[c] = 0.0f;
+    }
+
+    m_radiansToHz = sampleRate / (2.0f * (float)M_PI);
+    m_afcGain = 0.0f;
+    m_afcLimit = 0.0f;
+    m_afcOffset = 0.0f;
+    m_shift = std::complex<float>(1.0f, 0.0f);
+    m_shiftStep = std::complex<float>(1.0f, 0.0f);
+    m_nominalStep = 1.0f / samplesPerSymbol;
+
+    // Round the tone count down to a power of two in [2, kMaxTones]
+    size_t tones = 2;
+    m_bitsPerSymbol = 1;
+    while (tones * 2 <= numTones && tones * 2 <= kMaxTones)
+    {
+        tones *= 2;
+        ++m_bitsPerSymbol;
+    }
+
+    m_tones.resize(tones);
+    for (size_t i = 0; i < tones; ++i)
+    {
+        Correlator &tone = m_tones[i];
+        initCorrelator(tone.rotation, tone.leaving, toneFreqs[i], sampleRate, m_windowSize, kDamping);
+        tone.oscillator = std::complex<float>(1.0f, 0.0f);
+        for (size_t c = 0; c < kMaxChannels; ++c)
+        {
+            tone.sum[c] = std::complex<float>(0.0f, 0.0f);
+        }
+        m_toneValues[i] = grayDecode((uint8_t)i);
+    }
+
+    // Strongest over mean of the other tone energies for noise alone: the strongest of M
+    // exponential energies averages H(M) = 1 + 1/2 + ... + 1/M times the mean
+    float harmonic = 0.0f;
+    for (size_t i = 1; i <= tones; ++i)
+    {
+        harmonic += 1.0f / (float)i;
+    }
+    m_noiseRatio = harmonic * (float)(tones - 1) / ((float)tones - harmonic);
+
+    m_channelEnergy.assign(tones * m_numChannels, 0.0f);
+    m_energy.assign(tones, 0.0f);
+    m_share.assign(tones, 0.0f);
+    m_previousShare.assign(tones, 0.0f);
+    m_midShare.assign(tones, 0.0f);
+    m_symbolShare.assign(tones, 0.0f);
+    m_lastSymbolShare.assign(tones, 0.0f);
+
+    // Moderate loop bandwidth: locks within a few tens of symbols, small jitter at high SNR
+    setTimingGains(0.05f, 0.002f);
+}
+
+uint8_t FskDemodulator::grayDecode(uint8_t code)
+{
+    uint8_t value = code;
+    while (code >>= 1)
+    {
+        value ^= code;
+    }
+    return value;
+}
+
+void FskDemodulator::setTimingGains(float proportional, float integral)
+{
+    m_proportionalGain = proportional;
+    m_integralGain = integral * m_nominalStep;
+}
+
+void FskDemodulator::setAfc(float maxOffsetHz, float gain)
+{
+    m_afcLimit = maxOffsetHz > 0.0f ? maxOffsetHz / m_radiansToHz : 0.0f;
+    m_afcGain = m_afcLimit > 0.0f ? gain : 0.0f;
+    m_afcOffset = 0.0f;
+    m_shiftStep = std::complex<float>(1.0f, 0.0f);
+}
+
+float FskDemodulator::getChannelSnr(size_t channel) const
+{
+    if (channel >= m_numChannels || m_noiseAverage[channel] <= 0.0f)
+    {
+        return 0.0f;
+    }
+    const float snr = m_signalAverage[channel] / m_noiseAverage[channel] - m_noiseRatio;
+    return snr > 0.0f ? snr : 0.0f;
+}
+
+// Residual offset of a tone in radians per sample: phase step between the correlations of the
+// two halves of the window, whose centres are half a window apart (channels combined by weight)
+float FskDemodulator::measureOffset(size_t tone) const
+{
+    const std::complex<float> &rotation = m_tones[tone].rotation;
+    const size_t half = m_windowSize / 2;
+    std::complex<float> step(0.0f, 0.0f);
+
+    for (size_t c = 0; c < m_numChannels; ++c)
+    {
+        const std::complex<float> *history = &m_history[c * m_windowSize];
+        std::complex<float> oscillator(1.0f, 0.0f);
+        std::complex<float> first(0.0f, 0.0f);
+        std::complex<float> second(0.0f, 0.0f);
+
+        size_t pos = m_historyPos; // oldest sample
+        for (size_t k = 0; k < m_windowSize; ++k)
+        {
+            (k < half ? first : second) += history[pos] * oscillator;
+            oscillator *= rotation;
+            pos = (pos + 1 == m_windowSize) ? 0 : pos + 1;
+        }
+        step += m_weights[c] * (second * std::conj(first));
+    }
+    return std::arg(step) / (0.5f * m_windowSize);
+}
+
+// Update the channel SNR averages from the energies at a strobe, then the combining weights
+void FskDemodulator::updateDiversity()
+{
+    if (m_numChannels < 2)
+    {
+        return;
+    }
+
+    const size_t numTones = m_tones.size();
+    float snr[kMaxChannels];
+    float ratio[kMaxChannels];
+    float total = 0.0f;
+    size_t best = 0;
+    for (size_t c = 0; c < m_numChannels; ++c)
+    {
+        const float *energy = &m_channelEnergy[c * numTones];
+        size_t strongest = 0;
+        float others = 0.0f;
+        for (size_t i = 0; i < numTones; ++i)
+        {
+            strongest = energy[i] > energy[strongest] ? i : strongest;
+            others += energy[i];
+        }
+        others = (others - energy[strongest]) / (float)(numTones - 1);
+
+        m_signalAverage[c] += kSnrAveraging * (energy[strongest] - m_signalAverage[c]);
+        m_noiseAverage[c] += kNoiseAveraging * (others - m_noiseAverage[c]);
+        snr[c] = getChannelSnr(c);
+        if (snr[c] > snr[best])
+        {
+            best = c;
+        }
+
+        // Maximal ratio: noise-normalise, then scale by SNR
+        ratio[c] = m_noiseAverage[c] > 0.0f ? snr[c] / m_noiseAverage[c] : 0.0f;
+        total += ratio[c];
+    }
+
+    for (size_t c = 0; c < m_numChannels; ++c)
+    {
+        if (m_combining == Combining::Selection)
+        {
+            m_weights[c] = c == best ? 1.0f : 0.0f;
+        }
+        else
+        {
+            m_weights[c] = total > 0.0f ? ratio[c] / total : 1.0f / m_numChannels;
+        }
+    }
+}
+
+bool FskDemodulator::process(float sample, const SampleClock::Timestamp &time)
+{
+    const float samples[kMaxChannels] = {sample, sample};
+    return processChannels(samples, time);
+}
+
+bool FskDemodulator::process(float channel0, float channel1, const SampleClock::Timestamp &time)
+{
+    const float samples[kMaxChannels] = {channel0, channel1};
+    return processChannels(samples, time);
+}
+
+bool FskDemodulator::processChannels(const float *samples, const SampleClock::Timestamp &time)
+{
+    // Shift by the AFC offset (the image of the real input stays twice a tone frequency away)
+    std::complex<float> shifted[kMaxChannels];
+    std::complex<float> leaving_sample[kMaxChannels];
+    for (size_t c = 0; c < m_numChannels; ++c)
+    {
+        std::complex<float> &slot = m_history[c * m_windowSize + m_historyPos];
+        shifted[c] = samples[c] * m_shift;
+        leaving_sample[c] = slot;
+        slot = shifted[c];
+    }
+    m_shift *= m_shiftStep;
+    m_shift *= 1.5f - 0.5f * std::norm(m_shift);
+    m_historyPos = (m_historyPos + 1 == m_windowSize) ? 0 : m_historyPos + 1;
+
+    // Slide every correlator by one sample; the channels share each tone's oscillator
+    const size_t numTones = m_tones.size();
+    float total = 0.0f;
+    for (size_t i = 0; i < numTones; ++i)
+    {
+        Correlator &tone = m_tones[i];
+        const std::complex<float> leaving = tone.oscillator * tone.leaving;
+        float energy = 0.0f;
+        for (size_t c = 0; c < m_numChannels; ++c)
+        {
+            std::complex<float> &sum = tone.sum[c];
+            sum = kDamping * sum + shifted[c] * tone.oscillator - leaving_sample[c] * leaving;
+            m_channelEnergy[c * numTones + i] = std::norm(sum);
+            energy += m_weights[c] * m_channelEnergy[c * numTones + i];
+        }
+        tone.oscillator *= tone.rotation;
+
+        // Keep |oscillator| at 1 (first-order correction, cheap enough for every sample)
+        tone.oscillator *= 1.5f - 0.5f * std::norm(tone.oscillator);
+        m_energy[i] = energy;
+        total += energy;
+    }
+
+    m_previousShare.swap(m_share);
+    const float inverseTotal = total > 0.0f ? 1.0f / total : 0.0f;
+    for (size_t i = 0; i < numTones; ++i)
+    {
+        m_share[i] = m_energy[i] * inverseTotal;
+    }
+
+    // Advance the symbol clock; strobes fall between samples, so interpolate the shares
+    const float step = m_nominalStep + m_rateCorrection;
+    const float previousPhase = m_phase;
+    m_phase += step;
+
+    if (previousPhase < 0.5f && m_phase >= 0.5f)
+    {
+        const float fraction = (0.5f - previousPhase) / step;
+        for (size_t i = 0; i < numTones; ++i)
+        {
+            m_midShare[i] = m_previousShare[i] + fraction * (m_share[i] - m_previousShare[i]);
+        }
+    }
+
+    if (m_phase < 1.0f)
+    {
+        return false;
+    }
+
+    const float fraction = (1.0f - previousPhase) / step;
+    m_phase -= 1.0f;
+
+    float peakEnergy = 0.0f;
+    for (size_t i = 0; i < numTones; ++i)
+    {
+        peakEnergy = m_energy[i] > peakEnergy ? m_energy[i] : peakEnergy;
+    }
+
+    // Amplitude (and squelch) from the strongest channel, independent of the combining weights
+    float channelPeak = 0.0f;
+    for (size_t i = 0; i < m_channelEnergy.size(); ++i)
+    {
+        channelPeak = m_channelEnergy[i] > channelPeak ? m_channelEnergy[i] : channelPeak;
+    }
+    const float amplitude = sqrtf(channelPeak) * m_amplitudeScale;
+    const bool squelched = amplitude < m_squelch;
+
+    // Gardner on the tone shares: each mid-symbol share sits on the transition; its sign
+    // against the change across the symbol says whether the strobe is early or late.
+    // For two tones this is the usual m_mid * (m_last - m_now) on the metric Em - Es.
+    float error = 0.0f;
+    size_t best = 0;
+    for (size_t i = 0; i < numTones; ++i)
+    {
+        m_symbolShare[i] = m_previousShare[i] + fraction * (m_share[i] - m_previousShare[i]);
+        error += m_midShare[i] * (m_lastSymbolShare[i] - m_symbolShare[i]);
+        if (m_symbolShare[i] > m_symbolShare[best])
+        {
+            best = i;
+        }
+    }
+
+    // Hold the clock while squelched, so it does not wander on noise between transmissions
+    if (!squelched)
+    {
+        error *= 2.0f;
+        m_phase -= m_proportionalGain * error;
+        m_rateCorrection -= m_integralGain * error;
+
+        // Bound the rate correction to +/-2% of the nominal baud rate
+        const float limit = 0.02f * m_nominalStep;
+        m_rateCorrection =
+            m_rateCorrection > limit ? limit : (m_rateCorrection < -limit ? -limit : m_rateCorrection);
+    }
+
+    // Decision: strongest tone; the metric is its margin over the runner-up
+    if (numTones == 2)
+    {
+        m_metric = m_symbolShare[1] - m_symbolShare[0];
+    }
+    else
+    {
+        float second = 0.0f;
+        for (size_t i = 0; i < numTones; ++i)
+        {
+            if (i != best && m_symbolShare[i] > second)
+            {
+                second = m_symbolShare[i];
+            }
+        }
+        m_metric = m_symbolShare[best] - second;
+    }
+
+    if (squelched)
+    {
+        m_lastSymbolShare.swap(m_symbolShare);
+        return false;
+    }
+
+    updateDiversity();
+
+    // AFC: move the shift by a fraction of the residual offset, weighted by how clearly the
+    // tone was decided (a straddled or noisy window measures poorly)
+    if (m_afcGain > 0.0f)
+    {
+        m_afcOffset += m_afcGain * m_symbolShare[best] * measureOffset(best);
+        m_afcOffset = m_afcOffset > m_afcLimit ? m_afcLimit : (m_afcOffset < -m_afcLimit ? -m_afcLimit : m_afcOffset);
+        m_shiftStep = std::complex<float>(cosf(m_afcOffset), -sinf(m_afcOffset));
+    }
+
+    Symbol symbol;
+
+    // Max-log soft value per bit: best energy with the bit set minus best energy with it clear,
+    // over the running peak energy
+    m_peakAverage = m_peakAverage > 0.0f ? m_peakAverage + kSoftAveraging * (peakEnergy - m_peakAverage)
+                                         : peakEnergy;
+    const float softScale = m_peakAverage > 0.0f ? 1.0f / m_peakAverage : 0.0f;
+    for (size_t b = 0; b < m_bitsPerSymbol; ++b)
+    {
+        const uint8_t mask = (uint8_t)(1 << (m_bitsPerSymbol - 1 - b));
+        float one = 0.0f;
+        float zero = 0.0f;
+        for (size_t i = 0; i < numTones; ++i)
+        {
+            float &side = (m_toneValues[i] & mask) ? one : zero;
+            side = m_energy[i] > side ? m_energy[i] : side;
+        }
+        symbol.soft[b] = (one - zero) * softScale;
+    }
+    for (size_t b = m_bitsPerSymbol; b < kMaxBitsPerSymbol; ++b)
+    {
+        symbol.soft[b] = 0.0f;
+    }
+    m_lastSymbolShare.swap(m_symbolShare);
+
+    symbol.tone = (uint8_t)best;
+    symbol.value = m_toneValues[best];
+    symbol.bit = (uint8_t)((symbol.value >> (m_bitsPerSymbol - 1)) & 1);
+    symbol.metric = m_metric;
+    symbol.amplitude = amplitude;
+    symbol.time = time;
+    emit(symbol);
+    return true;
+}
+
+void FskDemodulator::emit(const Symbol &symbol)
+{
+    const size_t next = (m_symbolWrite + 1) % kSymbolCapacity;
+    if (next == m_symbolRead)
+    {
+        ++m_droppedSymbols;
+        return;
+    }
+    m_symbols[m_symbolWrite] = symbol;
+    m_symbolWrite = next;
+}
+
+bool FskDemodulator::popSymbol(Symbol &symbol)
+{
+    if (m_symbolRead == m_symbolWrite)
+    {
+        return false;
+    }
+    symbol = m_symbols[m_symbolRead];
+    m_symbolRead = (m_symbolRead + 1) % kSymbolCapacity;
+    return true;
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "sample_clock.h"
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Streaming non-coherent FSK demodulator (binary or M-ary) with symbol timing recovery.
+// One matched filter per tone (a bank of sliding one-symbol correlators) is updated on every
+// sample; each tone's share of the total energy is strobed by a fractional symbol clock at
+// each symbol end, and the strongest tone decides the symbol. A Gardner timing error on the
+// tone shares, taken half a symbol earlier, steers the clock phase and rate.
+//
+// M-ary: tone index k carries the data value whose Gray code is k, so tones next to each
+// other differ in one bit and the likely one-tone mistakes cost a single bit error. Each
+// symbol carries log2(M) bits, so throughput scales with log2(M) at the same symbol rate.
+// Binary mode is the M = 2 case with tone 0 = space and tone 1 = mark.
+//
+// Each symbol also carries a soft value per bit for a soft-decision decoder: the strongest
+// tone energy with that bit set minus the strongest with it clear (max-log), divided by a
+// running average of the strongest tone energy. For binary this is (Em - Es) / E_avg: the
+// sign is the hard decision, and symbols in a fade or near noise get a small confidence.
+//
+// Automatic frequency control (setAfc) follows a common offset of all tones (Doppler,
+// transmitter clock error). The input is shifted by a complex oscillator before the correlator
+// bank, so the correlators and their constants never change. At each unsquelched strobe the
+// decided tone's phase step between the first and second half of the window gives the
+// residual offset, which moves the shift, bounded to +/- the configured pull-in range.
+//
+// Diversity: with two channels (two hydrophones) each channel runs its own correlator bank and
+// the per-tone energies are combined before the timing and the decision. Each channel's SNR is
+// estimated at every unsquelched strobe from its own strongest tone against the mean of its
+// other tones (running averages), less the ratio noise alone gives. Being independent of the
+// combined decision, a faded channel does not drag the other's estimate down, and a dead input
+// reads about 0. Maximal-ratio combining weights each channel's energies by SNR / noise energy
+// (noise-normalised, then scaled by SNR), so a faded channel contributes little; selection
+// combining uses only the channel with the best SNR. The reported amplitude and the squelch use
+// the strongest channel, so they do not depend on the weights.
+//
+// process() is meant for the audio callback; popSymbol() for the main loop (single producer,
+// single consumer). For orthogonal tones the baud rate should not exceed the tone spacing.
+class FskDemodulator
+{
+public:
+    static constexpr size_t kMaxTones = 16;
+    static constexpr size_t kMaxBitsPerSymbol = 4;
+    static constexpr size_t kMaxChannels = 2;
+
+    enum class Combining
+    {
+        MaximalRatio,  // energies weighted by SNR / noise energy per channel (default)
+        Selection,     // energies of the channel with the highest SNR only
+    };
+
+    struct Symbol
+    {
+        uint8_t bit;          // binary: 1 = mark, 0 = space; M-ary: most significant bit of value
+        uint8_t value;        // log2(M) data bits (Gray-decoded tone index), sent MSB first
+        uint8_t tone;         // index of the strongest tone in the tone table
+        float metric;         // binary: (Em - Es) / (Em + Es), sign gives the bit, size the confidence;
+                              // M-ary: (E_best - E_second) / E_total in [0, 1]
+        float soft[kMaxBitsPerSymbol]; // soft value per bit of value, MSB first; > 0 favours 1,
+                                       // about +/-1 at full strength
+        float amplitude;      // estimated tone amplitude at the strobe (strongest channel)
+        SampleClock::Timestamp time; // sample at which the symbol was strobed
+    };
+
+    FskDemodulator(float sampleRate, float markFreq, float spaceFreq, float baudRate);
+
+    // M-ary FSK over a tone table (2, 4, 8 or 16 tones; other counts are rounded down to a
+    // power of two, and at least two tones must be given) on 1 or kMaxChannels input channels
+    FskDemodulator(float sampleRate, const float* toneFreqs, size_t numTones, float baudRate,
+                   size_t numChannels = 1);
+
+    // Tone amplitude (input units) below which strobes produce no symbols (0 = always emit)
+    void setSquelch(float amplitude) { m_squelch = amplitude; }
+
+    // Timing loop gains: phase correction and rate integrator per unit Gardner error
+    void setTimingGains(float proportional, float integral);
+
+    // Track tone offsets up to +/- maxOffsetHz (0 = off, the default); gain is the fraction of
+    // each symbol's measured offset applied
+    void setAfc(float maxOffsetHz, float gain = 0.1f);
+
+    // Current AFC estimate of the tone offset in Hz (positive: tones above the table)
+    float getFrequencyOffset() const { return m_afcOffset * m_radiansToHz; }
+
+    // How the channels are combined (only matters with two channels)
+    void setCombining(Combining mode) { m_combining = mode; }
+
+    // Push one sample taken at time. Returns true if this sample completed a symbol.
+    bool process(float sample, const SampleClock::Timestamp& time);
+
+    // Push one sample per channel (two-channel demodulator)
+    bool process(float channel0, float channel1, const SampleClock::Timestamp& time);
+
+    // Oldest pending symbol; returns false if none
+    bool popSymbol(Symbol& symbol);
+
+    static uint8_t grayEncode(uint8_t value) { return value ^ (value >> 1); }
+    static uint8_t grayDecode(uint8_t code);
+
+    // Metric of the last strobed symbol (including squelched ones)
+    float getMetric() const { return m_metric; }
+    size_t getNumTones() const { return m_tones.size(); }
+    size_t getNumChannels() const { return m_numChannels; }
+    size_t getBitsPerSymbol() const { return m_bitsPerSymbol; }
+    float getSamplesPerSymbol() const { return 1.0f / (m_nominalStep + m_rateCorrection); }
+    uint32_t getDroppedSymbols() const { return m_droppedSymbols; }
+
+    // Estimated SNR of a channel: tone energy over noise energy per tone (linear). The noise-only
+    // correction makes it read about 2 low (3 for 16 tones), which only matters near 0 dB.
+    float getChannelSnr(size_t channel) const;
+
+private:
+    // Damping keeps float round-off from accumulating in the sliding correlators
+    static constexpr float kDamping = 0.9999f;
+    static constexpr size_t kSymbolCapacity = 64;
+    // Per-symbol weight of the running peak energy that scales the soft values (~32 symbols)
+    static constexpr float kSoftAveraging = 1.0f / 32.0f;
+    // Per-symbol weight of the channel signal averages (~4 symbols, so the weights follow fades;
+    // slower averaging costs selection combining more than it gains) and noise averages (~32
+    // symbols, the noise floor changes slowly)
+    static constexpr float kSnrAveraging = 1.0f / 4.0f;
+    static constexpr float kNoiseAveraging = 1.0f / 32.0f;
+
+    struct Correlator
+    {
+        std::complex<float> rotation;    // e^(-i*w) per sample
+        std::complex<float> oscillator;  // e^(-i*w*n)
+        std::complex<float> leaving;     // kDamping^L * e^(+i*w*L): oscillator of the sample leaving the window
+        std::complex<float> sum[kMaxChannels];
+    };
+
+    void init(float sampleRate, const float* toneFreqs, size_t numTones, float baudRate,
+              size_t numChannels);
+    bool processChannels(const float* samples, const SampleClock::Timestamp& time);
+    void updateDiversity();
+    float measureOffset(size_t tone) const;
+    void emit(const Symbol& symbol);
+
+    float m_squelch;
+    float m_proportionalGain;
+    float m_integralGain;
+
+    size_t m_windowSize;                // samples per matched filter (one nominal symbol)
+    std::vector<std::complex<float>> m_history; // last m_windowSize shifted samples per channel
+    size_t m_historyPos;
+    std::vector<Correlator> m_tones;
+    size_t m_bitsPerSymbol;
+    uint8_t m_toneValues[kMaxTones];    // Gray-decoded data value of each tone
+    float m_amplitudeScale;             // 2 / window size: correlator magnitude to tone amplitude
+    float m_peakAverage;                // running strongest-tone energy at unsquelched strobes
+
+    // Diversity: per-channel weights on the tone energies, and running strongest-tone (signal)
+    // and other-tone (noise) energies
+    size_t m_numChannels;
+    Combining m_combining;
+    float m_weights[kMaxChannels];
+    float m_signalAverage[kMaxChannels];
+    float m_noiseAverage[kMaxChannels];
+    float m_noiseRatio;                 // signal / noise average that noise alone produces
+
+    // AFC: the input is multiplied by e^(-i*offset*n) before the correlators
+    float m_radiansToHz;
+    float m_afcGain;
+    float m_afcLimit;                   // radians per sample
+    float m_afcOffset;                  // radians per sample
+    std::complex<float> m_shift;        // e^(-i*offset*n)
+    std::complex<float> m_shiftStep;    // e^(-i*offset)
+
+    // Per-channel tone energies (channel-major) of the current sample
+    std::vector<float> m_channelEnergy;
+
+    // Per-tone combined energy and share of the total energy (this and the previous sample), and
+    // the shares interpolated at the last mid-symbol point and the last strobe
+    std::vector<float> m_energy;
+    std::vector<float> m_share;
+    std::vector<float> m_previousShare;
+    std::vector<float> m_midShare;
+    std::vector<float> m_symbolShare;
+    std::vector<float> m_lastSymbolShare;
+
+    // Symbol clock: phase in symbols, strobe at 1.0, mid-symbol sample at 0.5
+    float m_nominalStep;
+    float m_rateCorrection;
+    float m_phase;
+    float m_metric;
+
+    Symbol m_symbols[kSymbolCapacity];
+    volatile size_t m_symbolWrite;
+    volatile size_t m_symbolRead;
+    uint32_t m_droppedSymbols;
+};
@@ -0,0 +1,317 @@
+#include "fsk_packet.h"
+
+// Number of set bits in a 32-bit word
+static size_t popCount(uint32_t value)
+{
+    size_t count = 0;
+    while (value != 0)
+    {
+        value &= value - 1;
+        ++count;
+    }
+    return count;
+}
+
+FskPacketDecoder::FskPacketDecoder(uint32_t syncWord, size_t syncErrorTolerance, size_t minPreambleBits,
+                                   size_t bitsPerSymbol)
+    : m_syncWord(syncWord), m_syncErrorTolerance(syncErrorTolerance), m_minPreambleBits(minPreambleBits),
+      m_bitsPerSymbol(bitsPerSymbol < 1 ? 1 : (bitsPerSymbol > 4 ? 4 : bitsPerSymbol)),
+      m_state(State::Hunting), m_shift(0), m_preambleRun(0), m_bitsSincePreamble(0), m_armed(false),
+      m_huntBits(0), m_byte(0), m_bitCount(0), m_byteCount(0), m_length(0), m_receivedCrc(0), m_coded(false),
+      m_viterbi(kMaxCodedSteps), m_pendingSoft(0.0f), m_hasPending(false), m_codedSteps(0), m_frameBits(),
+      m_packet(), m_counters()
+{
+    startHunting();
+}
+
+void FskPacketDecoder::startHunting()
+{
+    m_state = State::Hunting;
+    m_preambleRun = 0;
+    m_bitsSincePreamble = 0;
+    m_armed = m_minPreambleBits == 0;
+    m_huntBits = 0;
+}
+
+void FskPacketDecoder::reset()
+{
+    if (m_state == State::Hunting)
+    {
+        m_counters.droppedBits += m_huntBits;
+    }
+    m_shift = 0;
+    startHunting();
+}
+
+uint16_t FskPacketDecoder::crc16(const uint8_t *data, size_t length, uint16_t crc)
+{
+    for (size_t i = 0; i < length; ++i)
+    {
+        crc ^= (uint16_t)(data[i] << 8);
+        for (int b = 0; b < 8; ++b)
+        {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+// Set bit 'index' of a byte array, MSB first
+static void putBit(uint8_t *bytes, size_t index, uint8_t bit)
+{
+    const uint8_t mask = (uint8_t)(0x80 >> (index % 8));
+    bytes[index / 8] = bit ? (uint8_t)(bytes[index / 8] | mask) : (uint8_t)(bytes[index / 8] & ~mask);
+}
+
+size_t FskPacketDecoder::encodeFrame(const uint8_t *payload, size_t length, uint8_t *frame, size_t frame_size,
+                                     uint32_t syncWord, size_t bitsPerSymbol, bool coded)
+{
+    bitsPerSymbol = bitsPerSymbol < 1 ? 1 : (bitsPerSymbol > 4 ? 4 : bitsPerSymbol);
+    const size_t preambleBytes = kPreambleSymbols * bitsPerSymbol / 8;
+    const size_t bodyBytes = 1 + length + 2;
+    const size_t codedBits = 2 * (8 * bodyBytes + ConvolutionalEncoder::kTailBits);
+    const size_t total = preambleBytes + 4 + (coded ? (codedBits + 7) / 8 : bodyBytes);
+    if (length > kMaxPayload || frame == nullptr || frame_size < total)
+    {
+        return 0;
+    }
+
+    // Preamble: symbols 1010..., 0000, 1010..., ... (odd bits of even symbols are set)
+    size_t pos = 0;
+    for (size_t i = 0; i < preambleBytes; ++i)
+    {
+        uint8_t byte = 0;
+        for (size_t b = 0; b < 8; ++b)
+        {
+            const size_t bit = i * 8 + b;
+            const bool set = ((bit / bitsPerSymbol) & 1) == 0 && ((bit % bitsPerSymbol) & 1) == 0;
+            byte = (uint8_t)((byte << 1) | (set ? 1 : 0));
+        }
+        frame[pos++] = byte;
+    }
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        frame[pos++] = (uint8_t)(syncWord >> shift);
+    }
+    frame[pos++] = (uint8_t)length;
+    for (size_t i = 0; i < length; ++i)
+    {
+        frame[pos++] = payload[i];
+    }
+
+    // CRC over the length byte and the payload
+    const uint16_t crc = crc16(frame + preambleBytes + 4, 1 + length);
+    frame[pos++] = (uint8_t)(crc >> 8);
+    frame[pos++] = (uint8_t)crc;
+    if (!coded)
+    {
+        return pos;
+    }
+
+    // The code pairs overwrite the body, so encode from a copy
+    uint8_t body[1 + kMaxPayload + 2];
+    const size_t start = preambleBytes + 4;
+    for (size_t i = 0; i < bodyBytes; ++i)
+    {
+        body[i] = frame[start + i];
+    }
+
+    ConvolutionalEncoder encoder;
+    size_t out = start * 8;
+    for (size_t i = 0; i < 8 * bodyBytes + ConvolutionalEncoder::kTailBits; ++i)
+    {
+        const uint8_t bit = i < 8 * bodyBytes ? (uint8_t)((body[i / 8] >> (7 - i % 8)) & 1) : 0;
+        const uint8_t pair = encoder.encode(bit);
+        putBit(frame, out++, (uint8_t)(pair >> 1));
+        putBit(frame, out++, (uint8_t)(pair & 1));
+    }
+    while (out % 8 != 0)
+    {
+        putBit(frame, out++, 0);
+    }
+    return total;
+}
+
+bool FskPacketDecoder::pushSoftBit(float soft)
+{
+    if (m_state != State::Hunting)
+    {
+        return m_coded ? pushCodedBit(soft) : pushFrameBit(soft > 0.0f ? 1 : 0);
+    }
+
+    const uint8_t bit = soft > 0.0f ? 1 : 0;
+    ++m_huntBits;
+    const uint8_t periodBit = (uint8_t)((m_shift >> (2 * m_bitsPerSymbol - 1)) & 1);
+    m_shift = (m_shift << 1) | bit;
+
+    // Preamble: track the current run of bits that repeat the bit two symbols earlier
+    if (m_huntBits > 2 * m_bitsPerSymbol && bit == periodBit)
+    {
+        ++m_preambleRun;
+    }
+    else
+    {
+        m_preambleRun = 0;
+    }
+
+    if (m_minPreambleBits > 0)
+    {
+        // A constant tone also repeats; the preamble's two symbols must differ
+        const uint32_t symbolMask = ((uint32_t)1 << m_bitsPerSymbol) - 1;
+        const bool alternating = ((m_shift ^ (m_shift >> m_bitsPerSymbol)) & symbolMask) != 0;
+        if (m_preambleRun >= m_minPreambleBits && alternating)
+        {
+            m_armed = true;
+            m_bitsSincePreamble = 0;
+        }
+        else if (m_armed && ++m_bitsSincePreamble > kSyncWindowBits)
+        {
+            // Preamble went by without a sync word
+            m_armed = false;
+        }
+    }
+
+    if (m_armed && m_huntBits >= 32 && popCount(m_shift ^ m_syncWord) <= m_syncErrorTolerance)
+    {
+        // The sync word itself is part of the frame, not dropped
+        m_counters.droppedBits += m_huntBits - 32;
+        ++m_counters.syncHits;
+        m_state = State::Length;
+        m_byte = 0;
+        m_bitCount = 0;
+        m_byteCount = 0;
+        m_viterbi.reset();
+        m_hasPending = false;
+        m_codedSteps = 0;
+    }
+    else if (m_huntBits > 1024)
+    {
+        // Keep the counter exact without letting m_huntBits grow without bound
+        m_counters.droppedBits += m_huntBits - 32;
+        m_huntBits = 32;
+    }
+    return false;
+}
+
+bool FskPacketDecoder::pushCodedBit(float soft)
+{
+    if (!m_hasPending)
+    {
+        m_pendingSoft = soft;
+        m_hasPending = true;
+        return false;
+    }
+    m_hasPending = false;
+    m_viterbi.push(m_pendingSoft, soft);
+    const size_t steps = m_viterbi.getSteps();
+
+    // The shortest frame has arrived: read the length from the best path so far
+    if (m_codedSteps == 0 && steps == kMinCodedSteps)
+    {
+        m_viterbi.traceback(m_frameBits, 8, false);
+        size_t length = 0;
+        for (size_t i = 0; i < 8; ++i)
+        {
+            length = (length << 1) | m_frameBits[i];
+        }
+        if (length > kMaxPayload)
+        {
+            ++m_counters.lengthErrors;
+            reset();
+            return false;
+        }
+        m_codedSteps = 8 * (3 + length) + ConvolutionalEncoder::kTailBits;
+    }
+    if (m_codedSteps == 0 || steps < m_codedSteps)
+    {
+        return false;
+    }
+
+    // Frame complete: decode it from the terminated trellis and frame the bits as uncoded
+    const size_t infoBits = steps - ConvolutionalEncoder::kTailBits;
+    m_viterbi.traceback(m_frameBits, infoBits, true);
+    for (size_t i = 0; i < infoBits; ++i)
+    {
+        if (pushFrameBit(m_frameBits[i]))
+        {
+            return true;
+        }
+        if (m_state == State::Hunting)
+        {
+            return false;
+        }
+    }
+
+    // The final length disagreed with the provisional one and left the packet short
+    ++m_counters.crcFailures;
+    m_shift = 0;
+    startHunting();
+    return false;
+}
+
+bool FskPacketDecoder::pushFrameBit(uint8_t bit)
+{
+    // Assemble bytes MSB first
+    m_byte = (uint8_t)((m_byte << 1) | bit);
+    if (++m_bitCount < 8)
+    {
+        return false;
+    }
+    const uint8_t value = m_byte;
+    m_byte = 0;
+    m_bitCount = 0;
+
+    switch (m_state)
+    {
+    case State::Length:
+        if (value > kMaxPayload)
+        {
+            ++m_counters.lengthErrors;
+            reset();
+            return false;
+        }
+        m_length = value;
+        m_byteCount = 0;
+        m_state = value > 0 ? State::Payload : State::Crc;
+        return false;
+
+    case State::Payload:
+        m_packet.payload[m_byteCount++] = value;
+        if (m_byteCount == m_length)
+        {
+            m_byteCount = 0;
+            m_state = State::Crc;
+        }
+        return false;
+
+    case State::Crc:
+    default:
+        if (m_byteCount == 0)
+        {
+            m_receivedCrc = (uint16_t)(value << 8);
+            m_byteCount = 1;
+            return false;
+        }
+        m_receivedCrc |= value;
+        break;
+    }
+
+    // Complete frame: check the CRC over length and payload
+    const uint8_t lengthByte = m_length;
+    uint16_t crc = crc16(&lengthByte, 1);
+    crc = crc16(m_packet.payload, m_length, crc);
+
+    const bool valid = crc == m_receivedCrc;
+    if (valid)
+    {
+        m_packet.length = m_length;
+        ++m_counters.packets;
+    }
+    else
+    {
+        ++m_counters.crcFailures;
+    }
+    m_shift = 0;
+    startHunting();
+    return valid;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "convolutional_code.h"
+#include <cstddef>
+#include <cstdint>
+
+// Packet framing on top of FSK bit decisions (bits MSB first):
+//   preamble   kPreambleSymbols symbols alternating between 1010... and 0000, the top and
+//              bottom tones under FskDemodulator's Gray coding, so the symbol clock sees the
+//              widest tone step (binary: 0xAA, 4-FSK: 0x88, 16-FSK: 0xA0; 4 bytes per bit
+//              per symbol, so the clock gets the same number of symbols to lock at any M)
+//   sync word  32 bits, accepted within a Hamming-distance tolerance
+//   length     1 byte, payload bytes (at most kMaxPayload)
+//   payload
+//   CRC-16     CCITT-FALSE (poly 0x1021, init 0xFFFF) over length and payload, MSB first
+//
+// Coded frames (setCoded) send length, payload and CRC plus six zero tail bits through the
+// rate-1/2 K=7 ConvolutionalEncoder; preamble and sync word stay uncoded. The receiver runs a
+// soft-decision Viterbi decoder over the frame, reading the length from a provisional
+// traceback once the shortest frame has arrived and decoding the rest once the frame ends.
+//
+// FskPacketDecoder consumes one bit (or soft bit) at a time and reports only packets whose CRC
+// checks, with counters for sync hits, CRC failures, bad lengths and bits dropped while hunting.
+class FskPacketDecoder
+{
+public:
+    static constexpr size_t kMaxPayload = 64;
+    static constexpr size_t kPreambleSymbols = 32;
+    static constexpr uint32_t kDefaultSyncWord = 0x1ACFFC1D;
+
+    struct Packet
+    {
+        uint8_t length;
+        uint8_t payload[kMaxPayload];
+    };
+
+    struct Counters
+    {
+        uint32_t syncHits;      // sync words accepted
+        uint32_t packets;       // packets with a valid CRC
+        uint32_t crcFailures;   // complete packets rejected by the CRC
+        uint32_t lengthErrors;  // length field above kMaxPayload
+        uint32_t droppedBits;   // bits discarded while hunting for preamble and sync
+    };
+
+    // minPreambleBits preamble bits (repeating every two symbols, with the two symbols different)
+    // must precede the sync word (0 = sync word alone); bitsPerSymbol matches the modulation (1 to 4)
+    explicit FskPacketDecoder(uint32_t syncWord = kDefaultSyncWord, size_t syncErrorTolerance = 2,
+                              size_t minPreambleBits = 8, size_t bitsPerSymbol = 1);
+
+    // Expect convolutionally coded frames (default uncoded)
+    void setCoded(bool coded) { m_coded = coded; }
+
+    // Push one bit. Returns true if it completed a valid packet (see getPacket()).
+    bool pushBit(uint8_t bit) { return pushSoftBit(bit ? 1.0f : -1.0f); }
+
+    // Push one soft bit (> 0 favours 1, size is confidence, e.g. FskDemodulator::Symbol::soft).
+    // Uncoded frames use only the sign. Returns true if it completed a valid packet.
+    bool pushSoftBit(float soft);
+
+    // Drop any partial packet and hunt for a new preamble (e.g. when the signal disappears)
+    void reset();
+
+    const Packet& getPacket() const { return m_packet; }
+    const Counters& getCounters() const { return m_counters; }
+
+    static uint16_t crc16(const uint8_t* data, size_t length, uint16_t crc = 0xFFFF);
+
+    // Build a complete frame (preamble, sync, length, payload, CRC) as bytes to send MSB first.
+    // Returns the frame size, or 0 if the payload is too long or frame is too small.
+    static size_t encodeFrame(const uint8_t* payload, size_t length, uint8_t* frame, size_t frame_size,
+                              uint32_t syncWord = kDefaultSyncWord, size_t bitsPerSymbol = 1,
+                              bool coded = false);
+
+private:
+    enum class State
+    {
+        Hunting,  // looking for preamble, then the sync word
+        Length,
+        Payload,
+        Crc,
+    };
+
+    // Bits after the end of the preamble in which the sync word must appear
+    static constexpr size_t kSyncWindowBits = 48;
+
+    // Coded frame sizes in trellis steps (input bits including the tail)
+    static constexpr size_t kMinCodedSteps = 8 * 3 + ConvolutionalEncoder::kTailBits;
+    static constexpr size_t kMaxCodedSteps = 8 * (3 + kMaxPayload) + ConvolutionalEncoder::kTailBits;
+
+    void startHunting();
+    bool pushFrameBit(uint8_t bit);
+    bool pushCodedBit(float soft);
+
+    uint32_t m_syncWord;
+    size_t m_syncErrorTolerance;
+    size_t m_minPreambleBits;
+    size_t m_bitsPerSymbol;
+
+    State m_state;
+    uint32_t m_shift;            // last 32 bits received
+    size_t m_preambleRun;        // length of the current run of preamble-like bits
+    size_t m_bitsSincePreamble;  // bits since a qualifying preamble run ended
+    bool m_armed;                // a qualifying preamble has been seen
+    size_t m_huntBits;           // bits consumed by the current hunt
+
+    uint8_t m_byte;
+    size_t m_bitCount;           // bits in m_byte
+    size_t m_byteCount;          // bytes of the current field
+    uint8_t m_length;
+    uint16_t m_receivedCrc;
+
+    bool m_coded;
+    ViterbiDecoder m_viterbi;
+    float m_pendingSoft;         // first soft bit of the current code pair
+    bool m_hasPending;
+    size_t m_codedSteps;         // trellis steps in the current frame once its length is known
+    uint8_t m_frameBits[kMaxCodedSteps];
+
+    Packet m_packet;
+    Counters m_counters;
+};
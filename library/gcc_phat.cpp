@@ -0,0 +1,203 @@
+#include "gcc_phat.h"
+#include <cmath>
+
+// Define M_PI if not available in the C++ standard library
+#ifndef M_PI
+#define M_PI 3.14159265358979323846f
+#endif
+
+GccPhat::GccPhat(float sampleRate, size_t frameSize, float maxDelay)
+    : m_sampleRate(sampleRate), m_frameSize(frameSize), m_maxLag(1), m_lowBin(1), m_highBin(1),
+      m_refinement(Refinement::Parabolic), m_beta(1.0f), m_peakLag(0), m_delay(0.0f), m_peak(0.0f), m_scale(0.0f), m_fft(sampleRate, frameSize)
+{
+    // Lags beyond half the frame wrap around in the circular correlation
+    const float lag = ceilf(maxDelay * sampleRate);
+    m_maxLag = lag < 1.0f ? 1 : (size_t)lag;
+    if (frameSize >= 4 && m_maxLag > frameSize / 2 - 1)
+    {
+        m_maxLag = frameSize / 2 - 1;
+    }
+
+    m_whitened.assign(frameSize / 2 + 1, std::complex<float>(0.0f, 0.0f));
+    m_work.assign(frameSize, std::complex<float>(0.0f, 0.0f));
+    setBand(0.0f, sampleRate);
+}
+
+void GccPhat::setBand(float lowFreq, float highFreq)
+{
+    // Same bin rule as SpectrumFrame: bins inside the band, DC and Nyquist excluded
+    const float spacing = m_sampleRate / m_frameSize;
+    const float lower = ceilf(lowFreq / spacing);
+    const float upper = floorf(highFreq / spacing);
+    const size_t top = m_frameSize >= 4 ? m_frameSize / 2 - 1 : 1;
+    m_lowBin = lower < 1.0f ? 1 : (size_t)lower;
+    m_highBin = upper > (float)top ? top : (upper < 1.0f ? 0 : (size_t)upper);
+}
+
+bool GccPhat::estimate(const float *buffer0, const float *buffer1, size_t buffer_size)
+{
+    if (buffer_size != m_frameSize || !m_fft.computeFrame(buffer0, buffer_size, m_frames[0]) ||
+        !m_fft.computeFrame(buffer1, buffer_size, m_frames[1]))
+    {
+        return false;
+    }
+    return estimate(m_frames[0], m_frames[1]);
+}
+
+bool GccPhat::estimate(const float *buffer0, const float *buffer1, size_t buffer_size, float expectedDelay,
+                       float halfWidth)
+{
+    if (buffer_size != m_frameSize || !m_fft.computeFrame(buffer0, buffer_size, m_frames[0]) ||
+        !m_fft.computeFrame(buffer1, buffer_size, m_frames[1]))
+    {
+        return false;
+    }
+    return estimate(m_frames[0], m_frames[1], expectedDelay, halfWidth);
+}
+
+bool GccPhat::estimate(const SpectrumFrame &frame0, const SpectrumFrame &frame1)
+{
+    return correlate(frame0, frame1, -(long)m_maxLag, (long)m_maxLag);
+}
+
+bool GccPhat::estimate(const SpectrumFrame &frame0, const SpectrumFrame &frame1, float expectedDelay, float halfWidth)
+{
+    const long maxLag = (long)m_maxLag;
+    long firstLag = (long)ceilf(expectedDelay - halfWidth);
+    long lastLag = (long)floorf(expectedDelay + halfWidth);
+    firstLag = firstLag < -maxLag ? -maxLag : firstLag;
+    lastLag = lastLag > maxLag ? maxLag : lastLag;
+    if (halfWidth < 0.0f || firstLag > lastLag || !correlate(frame0, frame1, firstLag, lastLag))
+    {
+        return false;
+    }
+
+    // The window must hold a peak, not just the rising edge of one outside it
+    const size_t N = m_frameSize;
+    const float value = m_work[(size_t)(m_peakLag < 0 ? m_peakLag + (long)N : m_peakLag)].real();
+    const float before = m_work[(size_t)(m_peakLag - 1 < 0 ? m_peakLag - 1 + (long)N : m_peakLag - 1)].real();
+    const float after = m_work[(size_t)(m_peakLag + 1 < 0 ? m_peakLag + 1 + (long)N : m_peakLag + 1)].real();
+    return value >= before && value >= after;
+}
+
+bool GccPhat::correlate(const SpectrumFrame &frame0, const SpectrumFrame &frame1, long firstLag, long lastLag)
+{
+    const size_t N = m_frameSize;
+    if (N < 4 || frame0.getSize() != N || frame1.getSize() != N || m_lowBin > m_highBin)
+    {
+        return false;
+    }
+
+    // Whitened cross-spectrum X1 * conj(X0): a delay D of channel 1 shows as phase -w*D
+    const std::complex<float> *bins0 = frame0.getBins();
+    const std::complex<float> *bins1 = frame1.getBins();
+    float total = 0.0f;
+    for (size_t k = 0; k <= N / 2; ++k)
+    {
+        std::complex<float> cross(0.0f, 0.0f);
+        if (k >= m_lowBin && k <= m_highBin)
+        {
+            cross = bins1[k] * std::conj(bins0[k]);
+            const float magnitude = std::abs(cross);
+            if (magnitude > 1e-20f)
+            {
+                const float weight = m_beta == 1.0f ? 1.0f / magnitude : powf(magnitude, -m_beta);
+                cross *= weight;
+                total += magnitude * weight;
+            }
+            else
+            {
+                cross = std::complex<float>(0.0f, 0.0f);
+            }
+        }
+        m_whitened[k] = cross;
+    }
+    if (total <= 0.0f)
+    {
+        return false;
+    }
+    m_scale = 1.0f / (2.0f * total);
+
+    // Correlation r[n] = sum over the full spectrum of W[k] * e^(+2*pi*i*k*n/N), real because W
+    // is Hermitian; as a forward FFT of conj(W) it is the real part of the result
+    m_work[0] = std::complex<float>(0.0f, 0.0f);
+    m_work[N / 2] = std::complex<float>(0.0f, 0.0f);
+    for (size_t k = 1; k < N / 2; ++k)
+    {
+        m_work[k] = std::conj(m_whitened[k]);
+        m_work[N - k] = m_whitened[k];
+    }
+    m_fft.fft(m_work);
+
+    // Peak over the physically possible (or the requested) lags only
+    long best = firstLag;
+    float bestValue = m_work[(size_t)(firstLag < 0 ? firstLag + (long)N : firstLag)].real();
+    for (long lag = firstLag; lag <= lastLag; ++lag)
+    {
+        const float value = m_work[(size_t)(lag < 0 ? lag + (long)N : lag)].real();
+        if (value > bestValue)
+        {
+            bestValue = value;
+            best = lag;
+        }
+    }
+
+    // Parabola through the peak and its neighbours (they may lie just outside the search range)
+    const float before = m_work[(size_t)(best - 1 < 0 ? best - 1 + (long)N : best - 1)].real();
+    const float after = m_work[(size_t)(best + 1 < 0 ? best + 1 + (long)N : best + 1)].real();
+    const float denominator = before - 2.0f * bestValue + after;
+    float shift = denominator < 0.0f ? 0.5f * (before - after) / denominator : 0.0f;
+    shift = shift > 0.5f ? 0.5f : (shift < -0.5f ? -0.5f : shift);
+    m_peakLag = best;
+    m_delay = (float)best + shift;
+    m_peak = bestValue * m_scale;
+
+    // Band-limited refinement: Newton steps on the slope of the exact interpolant, kept
+    // between the neighbouring lags
+    if (m_refinement == Refinement::Sinc)
+    {
+        for (size_t step = 0; step < kNewtonSteps; ++step)
+        {
+            float slope = 0.0f;
+            float curvature = 0.0f;
+            correlationAt(m_delay, slope, curvature);
+            if (curvature >= 0.0f)
+            {
+                break;
+            }
+            const float next = m_delay - slope / curvature;
+            m_delay = next > best + 1.0f ? best + 1.0f : (next < best - 1.0f ? best - 1.0f : next);
+        }
+        float slope = 0.0f;
+        float curvature = 0.0f;
+        m_peak = correlationAt(m_delay, slope, curvature);
+    }
+    return true;
+}
+
+// r(t) = 2 * sum over the band of Re(W[k] * e^(i*w_k*t)), scaled; the rotation e^(i*w_k*t) is
+// advanced by one complex multiply per bin
+float GccPhat::correlationAt(float lag, float &slope, float &curvature) const
+{
+    const double binStep = 2.0 * M_PI / m_frameSize;
+    const double first = binStep * m_lowBin * lag;
+    std::complex<float> rotation((float)cos(first), (float)sin(first));
+    const std::complex<float> advance((float)cos(binStep * lag), (float)sin(binStep * lag));
+
+    float value = 0.0f;
+    float firstDerivative = 0.0f;
+    float secondDerivative = 0.0f;
+    for (size_t k = m_lowBin; k <= m_highBin; ++k)
+    {
+        const std::complex<float> term = m_whitened[k] * rotation;
+        const float w = (float)(binStep * k);
+        value += term.real();
+        firstDerivative -= w * term.imag();
+        secondDerivative -= w * w * term.real();
+        rotation *= advance;
+    }
+
+    slope = 2.0f * m_scale * firstDerivative;
+    curvature = 2.0f * m_scale * secondDerivative;
+    return 2.0f * m_scale * value;
+}
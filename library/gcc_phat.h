@@ -0,0 +1,106 @@
+#pragma once
+
+#include "fft_library.h"
+#include "spectrum_frame.h"
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// Time difference of arrival between two hydrophones by generalized cross-correlation with the
+// phase transform (GCC-PHAT). The cross-spectrum of the two frames is whitened (each bin in the
+// band keeps only its phase), so its inverse transform is a sharp peak at the delay even for
+// coloured or reverberant signals. The peak is searched only over the lags the hydrophone
+// spacing allows and then refined below one sample, either by a parabola through the peak and
+// its neighbours or by maximising the band-limited (sinc) interpolant of the correlation, which
+// is evaluated exactly from the whitened spectrum with a few Newton steps.
+//
+// setWeighting() gives the PHAT-beta variant: each bin is divided by |cross-spectrum|^beta, so
+// beta below 1 keeps some of the magnitude and noise-only bins count for less (about 0.7 is a
+// common choice for low SNR); beta = 1 is the pure phase transform.
+//
+// A steady tone fixes the delay only modulo its period; the lag limit resolves that when the
+// spacing is under half a wavelength. Otherwise give estimate() a coarse delay from another
+// measurement (e.g. matched-filter arrival times): the search is then limited to the lags within
+// half a period of it, so the peak nearest the coarse delay is chosen, and the estimate fails if
+// that window holds no peak. Onsets, chirps and FSK bursts give a unique peak.
+//
+// estimate() takes the two SpectrumFrames already computed for the level detection (same size
+// and window), or two sample buffers that it transforms itself. Storage is sized in the
+// constructor (the buffer variant's frames on its first call); estimate() does not allocate.
+class GccPhat
+{
+public:
+    enum class Refinement
+    {
+        Parabolic,  // parabola through the peak lag and its neighbours (default)
+        Sinc,       // maximum of the band-limited correlation between the neighbouring lags
+    };
+
+    // Nominal speed of sound in water (m/s)
+    static constexpr float kSoundSpeedWater = 1482.0f;
+
+    // maxDelay (seconds) bounds the lag search, see maxDelayForSpacing()
+    GccPhat(float sampleRate, size_t frameSize, float maxDelay);
+
+    // Largest physical delay between hydrophones spacing metres apart
+    static float maxDelayForSpacing(float spacing, float soundSpeed = kSoundSpeedWater)
+    {
+        return soundSpeed > 0.0f ? spacing / soundSpeed : 0.0f;
+    }
+
+    // Whiten and correlate only the bins within [lowFreq, highFreq] (default: the whole band)
+    void setBand(float lowFreq, float highFreq);
+    void setRefinement(Refinement refinement) { m_refinement = refinement; }
+
+    // Whitening exponent beta in [0, 1] (1 = PHAT, the default; 0 = plain cross-correlation)
+    void setWeighting(float beta) { m_beta = beta < 0.0f ? 0.0f : (beta > 1.0f ? 1.0f : beta); }
+
+    // Estimate the delay from two frames of getFrameSize() samples. Returns false if the sizes do
+    // not match or the band holds no signal.
+    bool estimate(const SpectrumFrame& frame0, const SpectrumFrame& frame1);
+    bool estimate(const float* buffer0, const float* buffer1, size_t buffer_size);
+
+    // Same, searching only the lags within halfWidth samples of expectedDelay (samples, same sign
+    // as getDelaySamples()). Returns false if no correlation peak lies inside that window.
+    bool estimate(const SpectrumFrame& frame0, const SpectrumFrame& frame1, float expectedDelay, float halfWidth);
+    bool estimate(const float* buffer0, const float* buffer1, size_t buffer_size, float expectedDelay,
+                  float halfWidth);
+
+    // Delay of channel 1 behind channel 0 from the last estimate() (positive: channel 1 later)
+    float getDelay() const { return m_delay / m_sampleRate; }
+    float getDelaySamples() const { return m_delay; }
+
+    // Height of the whitened correlation at the delay: 1 for a pure delay, near 0 for unrelated
+    // inputs (a confidence for the estimate)
+    float getPeak() const { return m_peak; }
+
+    size_t getFrameSize() const { return m_frameSize; }
+    size_t getMaxLag() const { return m_maxLag; }
+
+private:
+    static constexpr size_t kNewtonSteps = 3;
+
+    // Whiten, correlate and pick the peak over lags firstLag .. lastLag (within +/- m_maxLag)
+    bool correlate(const SpectrumFrame& frame0, const SpectrumFrame& frame1, long firstLag, long lastLag);
+
+    // Band-limited correlation at a fractional lag, with its first and second derivatives
+    float correlationAt(float lag, float& slope, float& curvature) const;
+
+    float m_sampleRate;
+    size_t m_frameSize;
+    size_t m_maxLag;
+    size_t m_lowBin;
+    size_t m_highBin;
+    Refinement m_refinement;
+    float m_beta;
+
+    long m_peakLag;  // whole-sample lag of the correlation maximum
+    float m_delay;   // samples
+    float m_peak;
+    float m_scale;   // 1 / (2 * sum of weighted bin magnitudes): correlation of a pure delay is 1
+
+    std::vector<std::complex<float>> m_whitened;  // bins 0 .. N/2 of the whitened cross-spectrum
+    std::vector<std::complex<float>> m_work;      // N-point inverse transform
+    SpectrumFrame m_frames[2];                    // transforms for the buffer variant
+    FFTLibrary m_fft;
+};
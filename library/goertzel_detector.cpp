@@ -0,0 +1,123 @@
+#include "goertzel_detector.h"
+#include <cmath>
+
+// Define M_PI if not available in the C++ standard library
+#ifndef M_PI
+#define M_PI 3.14159265358979323846f
+#endif
+
+GoertzelDetector::GoertzelDetector(float sampleRate)
+    : m_sampleRate(sampleRate), m_windowType(WindowType::Hann), m_kaiserBeta(8.6f)
+{
+}
+
+void GoertzelDetector::setWindow(WindowType type, float kaiserBeta)
+{
+    m_windowType = type;
+    m_kaiserBeta = kaiserBeta;
+}
+
+bool GoertzelDetector::prepare(size_t buffer_size)
+{
+    return WindowCache::shared().get(m_windowType, buffer_size, m_kaiserBeta) != nullptr;
+}
+
+// Bin range used by both the FFT and Goertzel band queries
+void GoertzelDetector::bandBins(size_t buffer_size, float sample_rate, float target_freq, float tolerance,
+                                size_t &lower_bin, size_t &upper_bin)
+{
+    // Calculate frequency bounds with tolerance
+    float lower_freq = target_freq * (1.0f - tolerance);
+    float upper_freq = target_freq * (1.0f + tolerance);
+
+    // Calculate bin indices for the frequency range
+    lower_bin = (size_t)(lower_freq * buffer_size / sample_rate);
+    upper_bin = (size_t)(upper_freq * buffer_size / sample_rate);
+
+    // Ensure we're within valid range (first half of FFT)
+    if (lower_bin >= buffer_size / 2)
+    {
+        lower_bin = buffer_size / 2 - 1;
+    }
+    if (upper_bin >= buffer_size / 2)
+    {
+        upper_bin = buffer_size / 2 - 1;
+    }
+}
+
+// Level detection function - get magnitude at specific frequency with tolerance
+float GoertzelDetector::getFrequencyMagnitude(const float *audio_buffer, size_t buffer_size, float target_freq, float tolerance)
+{
+    float total_magnitude = 0.0f;
+    getFrequencyMagnitudes(&audio_buffer, 1, buffer_size, target_freq, tolerance, &total_magnitude);
+    return total_magnitude;
+}
+
+// Multi-channel variant: window values and coefficients are loaded once per sample for all channels
+void GoertzelDetector::getFrequencyMagnitudes(const float *const *audio_buffers, size_t num_channels, size_t buffer_size,
+                                              float target_freq, float tolerance, float *magnitudes)
+{
+    size_t lower_bin = 0;
+    size_t upper_bin = 0;
+    bandBins(buffer_size, m_sampleRate, target_freq, tolerance, lower_bin, upper_bin);
+    const size_t num_bins = upper_bin - lower_bin + 1;
+
+    for (size_t c = 0; c < num_channels; ++c)
+    {
+        magnitudes[c] = 0.0f;
+    }
+
+    // No window once the cache is full: report silence rather than an unwindowed level
+    const WindowTable *table = WindowCache::shared().get(m_windowType, buffer_size, m_kaiserBeta);
+    if (table == nullptr)
+    {
+        return;
+    }
+    const float *window = table->coefficients.data();
+
+    for (size_t first_channel = 0; first_channel < num_channels; first_channel += kMaxChannelsPerPass)
+    {
+        const size_t channels = (num_channels - first_channel < kMaxChannelsPerPass) ? num_channels - first_channel
+                                                                                      : kMaxChannelsPerPass;
+        const float *const *buffers = audio_buffers + first_channel;
+
+        // Evaluate up to kMaxBinsPerPass bins per pass so each sample is loaded once per pass
+        for (size_t first = 0; first < num_bins; first += kMaxBinsPerPass)
+        {
+            const size_t count = (num_bins - first < kMaxBinsPerPass) ? num_bins - first : kMaxBinsPerPass;
+            float coeff[kMaxBinsPerPass];
+            for (size_t b = 0; b < count; ++b)
+            {
+                coeff[b] = 2.0f * cosf((float)(2.0 * M_PI * (lower_bin + first + b) / buffer_size));
+            }
+
+            float s1[kMaxChannelsPerPass][kMaxBinsPerPass] = {{0.0f}};
+            float s2[kMaxChannelsPerPass][kMaxBinsPerPass] = {{0.0f}};
+
+            for (size_t i = 0; i < buffer_size; ++i)
+            {
+                const float w = window[i];
+                for (size_t c = 0; c < channels; ++c)
+                {
+                    const float x = buffers[c][i] * w;
+                    for (size_t b = 0; b < count; ++b)
+                    {
+                        const float s0 = x + coeff[b] * s1[c][b] - s2[c][b];
+                        s2[c][b] = s1[c][b];
+                        s1[c][b] = s0;
+                    }
+                }
+            }
+
+            // |X[k]|^2 = s1^2 + s2^2 - coeff * s1 * s2
+            for (size_t c = 0; c < channels; ++c)
+            {
+                for (size_t b = 0; b < count; ++b)
+                {
+                    float power = s1[c][b] * s1[c][b] + s2[c][b] * s2[c][b] - coeff[b] * s1[c][b] * s2[c][b];
+                    magnitudes[first_channel + c] += std::sqrt(power > 0.0f ? power : 0.0f);
+                }
+            }
+        }
+    }
+}
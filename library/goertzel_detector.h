@@ -0,0 +1,43 @@
+#pragma once
+
+#include "window_functions.h"
+#include <cstddef>
+
+// Single-bin DFT evaluation (Goertzel algorithm) for band-energy queries.
+// Produces the same windowed bin magnitudes as an N-point FFT, but only for
+// the bins covering the requested band: O(N * bins) time, O(1) state per bin.
+class GoertzelDetector
+{
+public:
+    GoertzelDetector(float sampleRate);
+
+    void setSampleRate(float sampleRate) { m_sampleRate = sampleRate; }
+
+    // Analysis window (Hann by default); should match the FFT path it replaces
+    void setWindow(WindowType type, float kaiserBeta = 8.6f);
+
+    // Build the window table for N-point frames ahead of time (otherwise the first call does).
+    // Returns false if the shared window cache is full; the magnitudes then read 0.
+    bool prepare(size_t buffer_size);
+
+    // Sum of bin magnitudes within target_freq * (1 +/- tolerance); same bins and scale as
+    // FFTLibrary::getFrequencyMagnitude. No allocation once the window for buffer_size exists.
+    float getFrequencyMagnitude(const float* audio_buffer, size_t buffer_size, float target_freq, float tolerance = 0.05f);
+
+    // Same for num_channels equal-length buffers in one pass; magnitudes receives num_channels values
+    void getFrequencyMagnitudes(const float* const* audio_buffers, size_t num_channels, size_t buffer_size,
+                                float target_freq, float tolerance, float* magnitudes);
+
+    // Bins of an N-point spectrum covering target_freq * (1 +/- tolerance), clamped to [0, N/2 - 1]
+    static void bandBins(size_t buffer_size, float sample_rate, float target_freq, float tolerance,
+                         size_t& lower_bin, size_t& upper_bin);
+
+private:
+    // Bins evaluated together in one pass over the buffer
+    static constexpr size_t kMaxBinsPerPass = 8;
+    static constexpr size_t kMaxChannelsPerPass = 4;
+
+    float m_sampleRate;
+    WindowType m_windowType;
+    float m_kaiserBeta;
+};
@@ -0,0 +1,183 @@
+#include "matched_filter.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Define M_PI if not available in the C++ standard library
+#ifndef M_PI
+#define M_PI 3.14159265358979323846f
+#endif
+
+MatchedFilter::MatchedFilter(float sampleRate, size_t frameSize, size_t channels, float frequency, float duration,
+                             WindowType window, float kaiserBeta)
+    : m_frameSize(frameSize), m_channels(channels < 1 ? 1 : (channels > kMaxChannels ? kMaxChannels : channels)),
+      m_templateLength(1), m_hopSize(frameSize), m_lowBin(0), m_highBin(0), m_numPeaks(0),
+      m_fft(sampleRate, frameSize)
+{
+    const float length = roundf(duration * sampleRate);
+    m_templateLength = length < 1.0f ? 1 : (size_t)length;
+    if (frameSize >= 2 && m_templateLength > frameSize / 2)
+    {
+        m_templateLength = frameSize / 2;
+    }
+    m_hopSize = frameSize - m_templateLength + 1;
+
+    // Analytic template w[m] * e^(i*w0*m), zero-padded to the frame size
+    std::vector<std::complex<float>> spectrum(frameSize, std::complex<float>(0.0f, 0.0f));
+    const double step = 2.0 * M_PI * frequency / sampleRate;
+    float windowSum = 0.0f;
+    for (size_t m = 0; m < m_templateLength; ++m)
+    {
+        const float w = WindowCache::value(window, m, m_templateLength, kaiserBeta);
+        spectrum[m] = std::complex<float>(w * (float)cos(step * m), w * (float)sin(step * m));
+        windowSum += w;
+    }
+    m_fft.fft(spectrum);
+
+    // Keep the bins that matter; a burst of amplitude A correlates to A * sum(w) / 2, and the
+    // inverse transform is run as a forward one, so 1 / N is folded in as well
+    float largest = 0.0f;
+    for (size_t k = 0; k < frameSize; ++k)
+    {
+        largest = std::max(largest, std::abs(spectrum[k]));
+    }
+    m_lowBin = frameSize;
+    for (size_t k = 0; k < frameSize; ++k)
+    {
+        if (std::abs(spectrum[k]) >= kTemplateFloor * largest)
+        {
+            m_lowBin = std::min(m_lowBin, k);
+            m_highBin = k;
+        }
+    }
+    if (m_lowBin > m_highBin)
+    {
+        m_lowBin = 0;
+        m_highBin = 0;
+    }
+    const float scale = windowSum > 0.0f ? 2.0f / (windowSum * frameSize) : 0.0f;
+    m_template.assign(spectrum.begin() + m_lowBin, spectrum.begin() + m_highBin + 1);
+    for (std::complex<float>& bin : m_template)
+    {
+        bin *= scale;
+    }
+
+    m_packed.assign(frameSize, std::complex<float>(0.0f, 0.0f));
+    m_spectrum.assign(frameSize, std::complex<float>(0.0f, 0.0f));
+    m_work.assign(frameSize, std::complex<float>(0.0f, 0.0f));
+    m_envelope.assign(m_channels * m_hopSize, 0.0f);
+    for (size_t c = 0; c < kMaxChannels; ++c)
+    {
+        m_frameMaximum[c] = 0.0f;
+        m_trackers[c] = Tracker{std::numeric_limits<float>::max(), false, 0, 0.0f, 0.0f, 0.0f, false, 0.0f};
+    }
+}
+
+void MatchedFilter::setThreshold(size_t channel, float threshold)
+{
+    if (channel < m_channels)
+    {
+        m_trackers[channel].threshold = threshold;
+    }
+}
+
+size_t MatchedFilter::process(const float *const *frames, uint64_t frameStart)
+{
+    const size_t N = m_frameSize;
+    m_numPeaks = 0;
+
+    for (size_t c = 0; c < m_channels; c += 2)
+    {
+        // Two real channels as one complex signal; their spectra are separated by symmetry
+        const bool pair = c + 1 < m_channels;
+        for (size_t n = 0; n < N; ++n)
+        {
+            m_packed[n] = std::complex<float>(frames[c][n], pair ? frames[c + 1][n] : 0.0f);
+        }
+        m_fft.fft(m_packed);
+
+        for (size_t k = m_lowBin; k <= m_highBin; ++k)
+        {
+            const std::complex<float> z = m_packed[k];
+            const std::complex<float> mirror = std::conj(m_packed[(N - k) & (N - 1)]);
+            m_spectrum[k] = 0.5f * (z + mirror);
+        }
+        correlate(m_spectrum.data(), c);
+        track(c, frameStart);
+
+        if (pair)
+        {
+            for (size_t k = m_lowBin; k <= m_highBin; ++k)
+            {
+                const std::complex<float> z = m_packed[k];
+                const std::complex<float> mirror = std::conj(m_packed[(N - k) & (N - 1)]);
+                m_spectrum[k] = std::complex<float>(0.0f, -0.5f) * (z - mirror);
+            }
+            correlate(m_spectrum.data(), c + 1);
+            track(c + 1, frameStart);
+        }
+    }
+    return m_numPeaks;
+}
+
+// Circular correlation with the template, keeping the hop outputs that do not wrap:
+// |r[n]| = |FFT(conj(X) * T)[n]| / N, with 1 / N already in the template
+void MatchedFilter::correlate(const std::complex<float> *spectrum, size_t channel)
+{
+    std::fill(m_work.begin(), m_work.end(), std::complex<float>(0.0f, 0.0f));
+    for (size_t k = m_lowBin; k <= m_highBin; ++k)
+    {
+        m_work[k] = std::conj(spectrum[k]) * m_template[k - m_lowBin];
+    }
+    m_fft.fft(m_work);
+
+    float *envelope = m_envelope.data() + channel * m_hopSize;
+    float maximum = 0.0f;
+    for (size_t n = 0; n < m_hopSize; ++n)
+    {
+        envelope[n] = std::abs(m_work[n]);
+        maximum = std::max(maximum, envelope[n]);
+    }
+    m_frameMaximum[channel] = maximum;
+}
+
+void MatchedFilter::track(size_t channel, uint64_t frameStart)
+{
+    Tracker &tracker = m_trackers[channel];
+    const float *envelope = m_envelope.data() + channel * m_hopSize;
+    for (size_t n = 0; n < m_hopSize; ++n)
+    {
+        const float value = envelope[n];
+        const uint64_t sample = frameStart + n;
+        if (tracker.inPeak && !tracker.hasAfter && sample == tracker.sample + 1)
+        {
+            tracker.after = value;
+            tracker.hasAfter = true;
+        }
+
+        if (value >= tracker.threshold)
+        {
+            if (!tracker.inPeak || value > tracker.level)
+            {
+                tracker.inPeak = true;
+                tracker.sample = sample;
+                tracker.level = value;
+                tracker.before = tracker.last;
+                tracker.hasAfter = false;
+            }
+        }
+        else if (tracker.inPeak)
+        {
+            // Parabola through the peak and its neighbours
+            const float denominator = tracker.before - 2.0f * tracker.level + tracker.after;
+            float offset = denominator < 0.0f ? 0.5f * (tracker.before - tracker.after) / denominator : 0.0f;
+            offset = offset > 0.5f ? 0.5f : (offset < -0.5f ? -0.5f : offset);
+            if (m_numPeaks < kMaxPeaks)
+            {
+                m_peaks[m_numPeaks++] = Peak{channel, tracker.sample, offset, tracker.level};
+            }
+            tracker.inPeak = false;
+        }
+        tracker.last = value;
+    }
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "fft_library.h"
+#include "window_functions.h"
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Matched filter for a known ping: each channel is correlated with a windowed tone burst
+// (frequency, duration, window) by FFT overlap-save. The template is complex (analytic), so the
+// magnitude of the correlation is its envelope directly, without a separate demodulation step.
+// The envelope is scaled so that a steady tone covering the whole template reads its amplitude
+// (input units). Compared with the band energy of a short window, the whole burst is integrated
+// coherently: white noise is reduced in proportion to the burst length. The default rectangular
+// template is the matched filter for a gated pinger burst; a tapered one trades some of that gain
+// for lower sidelobes against tones nearby in frequency.
+//
+// A long narrowband burst has a broad correlation peak, so the peak time places the onset only to
+// within a fraction of the burst that shrinks with SNR. Delays between hydrophones are better
+// measured by GccPhat on frames around the peak.
+//
+// Frames are frameSize samples and consecutive frames overlap by the template length minus one,
+// so a StreamingSTFT(channels, frameSize, getHopSize()) feeds it directly. Each frame yields
+// getHopSize() envelope values: value i belongs to a burst starting at sample frameStart + i.
+// Two channels share one forward transform (packed as real and imaginary parts); each channel
+// then needs one inverse transform. Storage is allocated in the constructor.
+//
+// Peaks are the maxima of the envelope while it stays at or above the channel's threshold, with a
+// parabolic sub-sample correction. A peak is reported once the envelope falls back below the
+// threshold, which can be in a later frame.
+class MatchedFilter
+{
+public:
+    struct Peak
+    {
+        size_t channel;
+        uint64_t sample;   // start of the matching burst (frameStart-based sample index)
+        float offset;      // sub-sample correction in [-0.5, 0.5]
+        float level;       // envelope at the peak (burst amplitude)
+    };
+
+    static constexpr size_t kMaxChannels = 4;
+    static constexpr size_t kMaxPeaks = 8;    // per process() call; later ones are dropped
+
+    // frameSize must be a power of two; the template is clamped to frameSize / 2 samples
+    MatchedFilter(float sampleRate, size_t frameSize, size_t channels, float frequency, float duration,
+                  WindowType window = WindowType::Rectangular, float kaiserBeta = 8.6f);
+
+    // Envelope level at or above which peaks are reported (input amplitude units)
+    void setThreshold(size_t channel, float threshold);
+
+    // Correlate one frame per channel (frames[channel][0 .. frameSize)), whose first sample has
+    // index frameStart. Returns the number of peaks completed in this frame.
+    size_t process(const float* const* frames, uint64_t frameStart);
+
+    // getHopSize() envelope values of the last frame
+    const float* getEnvelope(size_t channel) const { return m_envelope.data() + channel * m_hopSize; }
+
+    // Largest envelope value of the last frame (e.g. for a noise estimate)
+    float getFrameMaximum(size_t channel) const { return channel < m_channels ? m_frameMaximum[channel] : 0.0f; }
+
+    size_t getNumPeaks() const { return m_numPeaks; }
+    const Peak& getPeak(size_t index) const { return m_peaks[index]; }
+
+    size_t getFrameSize() const { return m_frameSize; }
+    size_t getHopSize() const { return m_hopSize; }
+    size_t getTemplateLength() const { return m_templateLength; }
+    size_t getNumChannels() const { return m_channels; }
+
+private:
+    // Template spectrum magnitudes below this fraction of the largest are left out of the product
+    static constexpr float kTemplateFloor = 1e-3f;
+
+    // Peak tracking for one channel
+    struct Tracker
+    {
+        float threshold;
+        bool inPeak;
+        uint64_t sample;
+        float before;     // envelope one sample before the peak
+        float level;
+        float after;      // envelope one sample after the peak (once known)
+        bool hasAfter;
+        float last;       // previous envelope value
+    };
+
+    void correlate(const std::complex<float>* spectrum, size_t channel);
+    void track(size_t channel, uint64_t frameStart);
+
+    size_t m_frameSize;
+    size_t m_channels;
+    size_t m_templateLength;
+    size_t m_hopSize;
+
+    // Template spectrum T (not conjugated; correlate() forms conj(X) * T) times the amplitude scale
+    // and 1 / frameSize, over bins m_lowBin .. m_highBin
+    std::vector<std::complex<float>> m_template;
+    size_t m_lowBin;
+    size_t m_highBin;
+
+    std::vector<std::complex<float>> m_packed;     // transform of two packed channels
+    std::vector<std::complex<float>> m_spectrum;   // one channel's spectrum
+    std::vector<std::complex<float>> m_work;       // inverse transform
+    std::vector<float> m_envelope;                 // m_hopSize values per channel
+    float m_frameMaximum[kMaxChannels];
+    Tracker m_trackers[kMaxChannels];
+
+    Peak m_peaks[kMaxPeaks];
+    size_t m_numPeaks;
+
+    FFTLibrary m_fft;
+};
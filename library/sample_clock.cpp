@@ -0,0 +1,67 @@
+#include "sample_clock.h"
+#include <cstdio>
+
+SampleClock::SampleClock(float sampleRate)
+    : m_sampleRate(sampleRate > 0.0f ? sampleRate : 1.0f), m_blockStart(0), m_nowLow(0), m_nowHigh(0)
+{
+}
+
+uint64_t SampleClock::beginBlock(size_t size)
+{
+    m_blockStart = ((uint64_t)m_nowHigh << 32) | m_nowLow;
+    const uint64_t end = m_blockStart + size;
+
+    // Low half first: a reader that sees the old high half re-reads it and notices the carry
+    m_nowLow = (uint32_t)end;
+    m_nowHigh = (uint32_t)(end >> 32);
+    return m_blockStart;
+}
+
+uint64_t SampleClock::now() const
+{
+    uint32_t high = m_nowHigh;
+    uint32_t low = m_nowLow;
+    uint32_t check = m_nowHigh;
+    while (check != high)
+    {
+        high = check;
+        low = m_nowLow;
+        check = m_nowHigh;
+    }
+    return ((uint64_t)high << 32) | low;
+}
+
+int64_t SampleClock::toMicroseconds(int64_t samples) const
+{
+    // Whole seconds and the remainder separately, so long counts keep microsecond resolution
+    const int64_t rate = (int64_t)(m_sampleRate + 0.5f);
+    if ((float)rate == m_sampleRate)
+    {
+        const int64_t seconds = samples / rate;
+        const int64_t remainder = samples % rate;
+        return seconds * 1000000 + (remainder * 1000000 + (remainder >= 0 ? rate / 2 : -rate / 2)) / rate;
+    }
+    const double us = (double)samples * 1e6 / m_sampleRate;
+    return (int64_t)(us < 0.0 ? us - 0.5 : us + 0.5);
+}
+
+const char* SampleClock::formatMicroseconds(int64_t us, char* text, size_t size)
+{
+    if (size == 0)
+    {
+        return text;
+    }
+
+    // Split into two parts that each fit an unsigned long
+    const bool negative = us < 0;
+    const uint64_t magnitude = negative ? (uint64_t)0 - (uint64_t)us : (uint64_t)us;
+    const unsigned long high = (unsigned long)(magnitude / 1000000000u);
+    const unsigned long low = (unsigned long)(magnitude % 1000000000u);
+    const int written = high > 0 ? snprintf(text, size, "%s%lu%09lu", negative ? "-" : "", high, low)
+                                 : snprintf(text, size, "%s%lu", negative ? "-" : "", low);
+    if (written < 0 || (size_t)written >= size)
+    {
+        text[0] = '\0';
+    }
+    return text;
+}
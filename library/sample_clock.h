@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Monotonic sample-index time base, advanced by the audio callback.
+// Detection times are counted in input samples rather than read from System::GetUs() in the
+// main loop: the count is 64-bit, so it does not wrap (the 32-bit microsecond timer wraps after
+// about 71 minutes), and an event is tagged with the sample that caused it, so the delay between
+// the callback and the loop polling it does not enter. The difference between two timestamps is
+// an exact number of samples; conversion to time is left to the point of printing.
+//
+// beginBlock() and stamp() are meant for the audio callback; now() can be read from the main loop
+// (single writer). The main loop sees the count advance once per block.
+class SampleClock
+{
+public:
+    // Sample position as (first sample of the audio block, offset within the block)
+    struct Timestamp
+    {
+        uint64_t frame;
+        uint32_t offset;
+
+        uint64_t sample() const { return frame + offset; }
+    };
+
+    explicit SampleClock(float sampleRate);
+
+    // Start of an audio block of size samples; returns the index of its first sample
+    uint64_t beginBlock(size_t size);
+
+    // Timestamp of sample offset in the current block
+    Timestamp stamp(size_t offset) const { return Timestamp{m_blockStart, (uint32_t)offset}; }
+
+    // Samples counted so far (one past the last sample of the latest block); safe from the main loop
+    uint64_t now() const;
+
+    // Signed distance from a to b in samples (positive: b later)
+    static int64_t difference(uint64_t a, uint64_t b) { return (int64_t)(b - a); }
+    static int64_t difference(const Timestamp& a, const Timestamp& b) { return difference(a.sample(), b.sample()); }
+
+    // Conversions for printing
+    float toSeconds(int64_t samples) const { return (float)((double)samples / m_sampleRate); }
+    int64_t toMicroseconds(int64_t samples) const;
+
+    // Writes a microsecond count as decimal digits (newlib-nano printf has no 64-bit conversions).
+    // Returns text, which holds "" if size is too small.
+    static const char* formatMicroseconds(int64_t us, char* text, size_t size);
+
+    float getSampleRate() const { return m_sampleRate; }
+
+private:
+    float m_sampleRate;
+    uint64_t m_blockStart;      // callback only
+
+    // Count published to the main loop as two halves, read back with a retry on a carry
+    volatile uint32_t m_nowLow;
+    volatile uint32_t m_nowHigh;
+};
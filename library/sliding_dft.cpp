@@ -0,0 +1,84 @@
+#include "sliding_dft.h"
+#include "goertzel_detector.h"
+#include <cmath>
+
+// Define M_PI if not available in the C++ standard library
+#ifndef M_PI
+#define M_PI 3.14159265358979323846f
+#endif
+
+SlidingDFT::SlidingDFT(float sampleRate, size_t windowSize, float target_freq, float tolerance)
+    : m_threshold(0.0f), m_magnitude(0.0f), m_isAbove(false),
+      m_history(windowSize, 0.0f), m_historyPos(0), m_eventWrite(0), m_eventRead(0)
+{
+    size_t lower_bin = 0;
+    size_t upper_bin = 0;
+    GoertzelDetector::bandBins(windowSize, sampleRate, target_freq, tolerance, lower_bin, upper_bin);
+
+    const size_t num_bins = upper_bin - lower_bin + 3;
+    m_rotation.resize(num_bins);
+    m_bins.assign(num_bins, {0.0f, 0.0f});
+    for (size_t i = 0; i < num_bins; ++i)
+    {
+        // Signed bin index; bin -1 is valid (conjugate of bin 1 for real input)
+        const float bin = (float)lower_bin - 1.0f + (float)i;
+        m_rotation[i] = kDamping * std::polar(1.0f, (float)(2.0 * M_PI * bin / windowSize));
+    }
+    m_dampingN = powf(kDamping, (float)windowSize);
+}
+
+bool SlidingDFT::process(float sample, const SampleClock::Timestamp &time)
+{
+    // X_k <- r * e^(2*pi*i*k/N) * (X_k + x[n] - r^N * x[n - N])
+    const float delta = sample - m_dampingN * m_history[m_historyPos];
+    m_history[m_historyPos] = sample;
+    if (++m_historyPos >= m_history.size())
+    {
+        m_historyPos = 0;
+    }
+
+    const size_t num_bins = m_bins.size();
+    for (size_t i = 0; i < num_bins; ++i)
+    {
+        const std::complex<float> v = m_bins[i] + delta;
+        const std::complex<float> r = m_rotation[i];
+        m_bins[i] = std::complex<float>(r.real() * v.real() - r.imag() * v.imag(),
+                                        r.real() * v.imag() + r.imag() * v.real());
+    }
+
+    // Hann window in the frequency domain: 0.5 * X[k] - 0.25 * (X[k - 1] + X[k + 1])
+    float magnitude = 0.0f;
+    for (size_t i = 1; i + 1 < num_bins; ++i)
+    {
+        magnitude += std::abs(0.5f * m_bins[i] - 0.25f * (m_bins[i - 1] + m_bins[i + 1]));
+    }
+    m_magnitude = magnitude;
+
+    const bool above = magnitude >= m_threshold;
+    const bool rising = above && !m_isAbove;
+    m_isAbove = above;
+
+    if (rising)
+    {
+        // Drop the event if the main loop has fallen a full queue behind
+        const size_t next = (m_eventWrite + 1) % kEventCapacity;
+        if (next != m_eventRead)
+        {
+            m_events[m_eventWrite].time = time;
+            m_events[m_eventWrite].level = magnitude;
+            m_eventWrite = next;
+        }
+    }
+    return rising;
+}
+
+bool SlidingDFT::popEvent(CrossingEvent &event)
+{
+    if (m_eventRead == m_eventWrite)
+    {
+        return false;
+    }
+    event = m_events[m_eventRead];
+    m_eventRead = (m_eventRead + 1) % kEventCapacity;
+    return true;
+}
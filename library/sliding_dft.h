@@ -0,0 +1,62 @@
+#pragma once
+
+#include "sample_clock.h"
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Per-sample band magnitude tracker (damped sliding DFT).
+// Tracks the Hann-windowed DFT bins covering target_freq * (1 +/- tolerance) over the
+// last windowSize samples, updated on every sample at a fixed cost of O(bins).
+// The magnitude has the same scale as FFTLibrary::getFrequencyMagnitude for the same
+// window size, so existing thresholds carry over. Rising threshold crossings are queued
+// as events tagged with the SampleClock timestamp of the sample that crossed.
+//
+// process() is meant for the audio callback; popEvent() for the main loop (single producer,
+// single consumer).
+class SlidingDFT
+{
+public:
+    struct CrossingEvent
+    {
+        SampleClock::Timestamp time;  // sample whose update crossed the threshold
+        float level;                  // band magnitude at that sample
+    };
+
+    SlidingDFT(float sampleRate, size_t windowSize, float target_freq, float tolerance);
+
+    // Band magnitude at or above which a rising crossing is reported
+    void setThreshold(float threshold) { m_threshold = threshold; }
+
+    // Push one sample taken at time. Returns true if this sample produced a rising threshold crossing.
+    bool process(float sample, const SampleClock::Timestamp& time);
+
+    // Oldest pending crossing event; returns false if none
+    bool popEvent(CrossingEvent& event);
+
+    float getMagnitude() const { return m_magnitude; }
+    bool isAbove() const { return m_isAbove; }
+
+private:
+    // Damping keeps float round-off from accumulating in the recursion
+    static constexpr float kDamping = 0.99999f;
+    static constexpr size_t kEventCapacity = 16;
+
+    float m_threshold;
+    float m_magnitude;
+    bool m_isAbove;
+
+    // Bins lower_bin - 1 .. upper_bin + 1 (the outer two are only used for the Hann combination)
+    std::vector<std::complex<float>> m_rotation;  // kDamping * e^(+2*pi*i*k/N)
+    std::vector<std::complex<float>> m_bins;
+    float m_dampingN;                             // kDamping^N, applied to the sample leaving the window
+
+    // Last windowSize samples
+    std::vector<float> m_history;
+    size_t m_historyPos;
+
+    CrossingEvent m_events[kEventCapacity];
+    volatile size_t m_eventWrite;
+    volatile size_t m_eventRead;
+};
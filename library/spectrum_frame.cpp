@@ -0,0 +1,146 @@
+#include "spectrum_frame.h"
+#include "fft_library.h"
+#include "goertzel_detector.h"
+#include <algorithm>
+#include <cmath>
+
+SpectrumFrame::SpectrumFrame() : m_size(0), m_sampleRate(0.0f), m_scale(1.0f)
+{
+}
+
+std::complex<float> *SpectrumFrame::prepare(size_t N, float sampleRate, size_t slots)
+{
+    m_size = N;
+    m_sampleRate = sampleRate;
+    if (m_bins.size() < slots)
+    {
+        m_bins.resize(slots);
+    }
+    if (m_magnitudes.size() != N / 2 + 1)
+    {
+        m_magnitudes.resize(N / 2 + 1);
+        m_scratch.resize(N / 2 + 1);
+    }
+    return m_bins.data();
+}
+
+void SpectrumFrame::finish(float scale)
+{
+    m_scale = scale;
+    for (size_t k = 0; k <= m_size / 2; ++k)
+    {
+        m_magnitudes[k] = std::sqrt(std::norm(m_bins[k]));
+    }
+}
+
+float SpectrumFrame::getFrequencyMagnitude(float target_freq, float tolerance) const
+{
+    if (!isValid())
+    {
+        return 0.0f;
+    }
+
+    size_t lower_bin = 0;
+    size_t upper_bin = 0;
+    GoertzelDetector::bandBins(m_size, m_sampleRate, target_freq, tolerance, lower_bin, upper_bin);
+
+    // Same summation order as FFTLibrary::sumBandMagnitude, then the same scale
+    float total_magnitude = 0.0f;
+    for (size_t bin = lower_bin; bin <= upper_bin; ++bin)
+    {
+        total_magnitude += m_magnitudes[bin];
+    }
+    return total_magnitude * m_scale;
+}
+
+void SpectrumFrame::getFrequencyMagnitudes(const float *target_freqs, size_t num_targets, float tolerance,
+                                           float *magnitudes) const
+{
+    for (size_t i = 0; i < num_targets; ++i)
+    {
+        magnitudes[i] = getFrequencyMagnitude(target_freqs[i], tolerance);
+    }
+}
+
+float SpectrumFrame::detectPitch() const
+{
+    if (!isValid())
+    {
+        return 0.0f;
+    }
+    return FFTLibrary::findInterpolatedFrequency(m_bins.data(), m_size, m_sampleRate);
+}
+
+bool SpectrumFrame::binRange(float min_freq, float max_freq, size_t &first, size_t &last) const
+{
+    if (m_size < 4)
+    {
+        return false;
+    }
+    const float spacing = getBinSpacing();
+    const float lower = ceilf(min_freq / spacing);
+    const float upper = floorf(max_freq / spacing);
+    first = lower < 1.0f ? 1 : (size_t)lower;
+    last = upper > (float)(m_size / 2 - 1) ? m_size / 2 - 1 : (size_t)upper;
+    return upper >= 1.0f && first <= last;
+}
+
+size_t SpectrumFrame::findPeaks(Peak *peaks, size_t max_peaks, float min_freq, float max_freq) const
+{
+    size_t first = 0;
+    size_t last = 0;
+    if (!isValid() || max_peaks == 0 || !binRange(min_freq, max_freq, first, last))
+    {
+        return 0;
+    }
+
+    size_t count = 0;
+    for (size_t k = first; k <= last; ++k)
+    {
+        const float mag0 = m_magnitudes[k - 1];
+        const float mag1 = m_magnitudes[k];
+        const float mag2 = m_magnitudes[k + 1];
+        if (!(mag1 > mag0 && mag1 >= mag2))
+        {
+            continue;
+        }
+
+        // Keep the list sorted, strongest first; drop the weakest when full
+        const float magnitude = mag1 * m_scale;
+        if (count == max_peaks && magnitude <= peaks[count - 1].magnitude)
+        {
+            continue;
+        }
+        size_t pos = count < max_peaks ? count++ : max_peaks - 1;
+        while (pos > 0 && peaks[pos - 1].magnitude < magnitude)
+        {
+            peaks[pos] = peaks[pos - 1];
+            --pos;
+        }
+
+        // Parabolic interpolation, as in FFTLibrary::findInterpolatedFrequency
+        float peak_shift = 0.5f * (mag0 - mag2) / (mag0 - 2.0f * mag1 + mag2);
+        if (std::isnan(peak_shift))
+        {
+            peak_shift = 0.0f;
+        }
+        peaks[pos].frequency = ((float)k + peak_shift) * getBinSpacing();
+        peaks[pos].magnitude = magnitude;
+    }
+    return count;
+}
+
+float SpectrumFrame::getNoiseFloor(float min_freq, float max_freq) const
+{
+    size_t first = 0;
+    size_t last = 0;
+    if (!isValid() || !binRange(min_freq, max_freq, first, last))
+    {
+        return 0.0f;
+    }
+
+    const size_t count = last - first + 1;
+    std::copy(m_magnitudes.begin() + first, m_magnitudes.begin() + last + 1, m_scratch.begin());
+    std::nth_element(m_scratch.begin(), m_scratch.begin() + count / 2, m_scratch.begin() + count);
+    return m_scratch[count / 2] * m_scale;
+}
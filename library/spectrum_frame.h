@@ -0,0 +1,71 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+class FFTLibrary;
+
+// One windowed transform of a buffer, kept for repeated queries.
+// Filled by FFTLibrary::computeFrame(); band magnitudes for any number of targets, the
+// interpolated peak, the strongest K peaks and the noise floor then cost no further FFTs.
+// Band magnitudes and detectPitch() give exactly what FFTLibrary::getFrequencyMagnitude
+// (FFT backend) and FFTLibrary::detectPitch return for the same buffer and settings.
+//
+// Storage is sized on the first frame and reused while the frame size stays the same.
+class SpectrumFrame
+{
+public:
+    struct Peak
+    {
+        float frequency; // parabolic-interpolated
+        float magnitude; // peak bin magnitude, same scale as the band magnitudes
+    };
+
+    SpectrumFrame();
+
+    bool isValid() const { return m_size > 0; }
+    size_t getSize() const { return m_size; }
+    float getSampleRate() const { return m_sampleRate; }
+    float getBinSpacing() const { return m_sampleRate / m_size; }
+
+    // Scaled magnitude of bin k (0 .. N/2)
+    float getMagnitude(size_t bin) const { return m_magnitudes[bin] * m_scale; }
+
+    // Complex bins 0 .. N/2 of the windowed transform (unscaled), e.g. for cross-spectra
+    const std::complex<float>* getBins() const { return m_bins.data(); }
+
+    // Band magnitude within target_freq * (1 +/- tolerance)
+    float getFrequencyMagnitude(float target_freq, float tolerance = 0.05f) const;
+
+    // Band magnitudes for num_targets targets sharing one tolerance
+    void getFrequencyMagnitudes(const float* target_freqs, size_t num_targets, float tolerance, float* magnitudes) const;
+
+    // Interpolated frequency of the strongest bin
+    float detectPitch() const;
+
+    // Up to max_peaks local maxima in [min_freq, max_freq], strongest first; returns the count found
+    size_t findPeaks(Peak* peaks, size_t max_peaks, float min_freq = 0.0f, float max_freq = 1e9f) const;
+
+    // Median bin magnitude in [min_freq, max_freq]; robust to a few tonal peaks
+    float getNoiseFloor(float min_freq = 0.0f, float max_freq = 1e9f) const;
+
+private:
+    friend class FFTLibrary;
+
+    // Size the storage for an N-point frame with `slots` workspace elements
+    std::complex<float>* prepare(size_t N, float sampleRate, size_t slots);
+
+    // Derive the bin magnitudes after the transform
+    void finish(float scale);
+
+    // Bins covering [min_freq, max_freq], clamped to 1 .. N/2 - 1; false if empty
+    bool binRange(float min_freq, float max_freq, size_t& first, size_t& last) const;
+
+    size_t m_size;
+    float m_sampleRate;
+    float m_scale;
+    std::vector<std::complex<float>> m_bins;   // transform workspace; bins 0 .. N/2 are valid
+    std::vector<float> m_magnitudes;           // |X[k]|, unscaled, k = 0 .. N/2
+    mutable std::vector<float> m_scratch;      // median selection
+};
@@ -0,0 +1,62 @@
+#include "streaming_stft.h"
+#include <cstring>
+
+StreamingSTFT::StreamingSTFT(size_t channels, size_t frameSize, size_t hopSize, size_t backlogFrames)
+    : m_channels(channels), m_frameSize(frameSize), m_hopSize(hopSize > 0 ? hopSize : 1), m_capacity(1),
+      m_written(0), m_nextFrameEnd(frameSize), m_frameEnd(0), m_droppedFrames(0)
+{
+    // Room for one frame, the backlog, and one hop of margin for the copy in readFrame()
+    const size_t required = frameSize + (backlogFrames + 1) * m_hopSize;
+    while (m_capacity < required)
+    {
+        m_capacity <<= 1;
+    }
+    m_mask = m_capacity - 1;
+    m_history.assign(m_channels * m_capacity, 0.0f);
+}
+
+void StreamingSTFT::push(const float *samples)
+{
+    const uint32_t written = m_written;
+    const size_t pos = written & m_mask;
+    for (size_t c = 0; c < m_channels; ++c)
+    {
+        m_history[c * m_capacity + pos] = samples[c];
+    }
+    m_written = written + 1;
+}
+
+bool StreamingSTFT::readFrame(float *const *frames)
+{
+    // The push count wraps; only its distance from the next frame end matters
+    const uint32_t written = m_written;
+    const int32_t ahead = (int32_t)(written - (uint32_t)m_nextFrameEnd);
+    if (ahead < 0)
+    {
+        return false;
+    }
+
+    // Too far behind: the oldest pending frames are about to be overwritten,
+    // so jump to the newest complete frame
+    const uint32_t lag = (uint32_t)ahead;
+    if (lag > m_capacity - m_frameSize - m_hopSize)
+    {
+        const uint32_t skipped = lag / (uint32_t)m_hopSize;
+        m_nextFrameEnd += (uint64_t)skipped * m_hopSize;
+        m_droppedFrames += skipped;
+    }
+
+    // Copy out in at most two pieces around the wrap point
+    const size_t start = (size_t)(m_nextFrameEnd - m_frameSize) & m_mask;
+    const size_t first = (m_capacity - start) < m_frameSize ? (m_capacity - start) : m_frameSize;
+    for (size_t c = 0; c < m_channels; ++c)
+    {
+        const float *history = m_history.data() + c * m_capacity;
+        memcpy(frames[c], history + start, first * sizeof(float));
+        memcpy(frames[c] + first, history, (m_frameSize - first) * sizeof(float));
+    }
+
+    m_frameEnd = m_nextFrameEnd;
+    m_nextFrameEnd += m_hopSize;
+    return true;
+}
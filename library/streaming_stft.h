@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Overlapped framing for a streaming STFT.
+// The audio callback pushes every sample into a per-channel circular history; a new
+// frame of frameSize samples completes every hopSize samples, so consecutive frames
+// overlap by frameSize - hopSize and no input is skipped while the main loop analyses
+// the previous frame. readFrame() linearises the next frame (oldest sample first) into
+// caller buffers that can go straight to FFTLibrary.
+//
+// push() is meant for the audio callback; readFrame() for the main loop (single producer,
+// single consumer). If the main loop falls more than backlogFrames hops behind, the
+// oldest frames are dropped and counted rather than read while being overwritten.
+//
+// Frames are located by a 64-bit count of pushed samples. When every callback sample is pushed
+// from the first block on, that count is the SampleClock sample index of the same sample.
+class StreamingSTFT
+{
+public:
+    StreamingSTFT(size_t channels, size_t frameSize, size_t hopSize, size_t backlogFrames = 4);
+
+    // Push one sample per channel (samples[channel])
+    void push(const float* samples);
+
+    // Copy the next frame into frames[channel][0 .. frameSize). Returns false if no new frame is complete.
+    bool readFrame(float* const* frames);
+
+    // Sample index one past the last sample of the frame returned by readFrame()
+    uint64_t getFrameEndSample() const { return m_frameEnd; }
+    uint64_t getFrameStartSample() const { return m_frameEnd - m_frameSize; }
+
+    // Frames skipped because the reader fell behind
+    uint32_t getDroppedFrames() const { return m_droppedFrames; }
+
+    size_t getFrameSize() const { return m_frameSize; }
+    size_t getHopSize() const { return m_hopSize; }
+
+private:
+    size_t m_channels;
+    size_t m_frameSize;
+    size_t m_hopSize;
+    size_t m_capacity;  // per channel, power of two
+    size_t m_mask;
+
+    std::vector<float> m_history;  // channel-planar, m_capacity samples per channel
+    volatile uint32_t m_written;   // total samples pushed per channel, modulo 2^32
+
+    // Reader side, extended to 64 bits (the reader is never 2^31 samples behind)
+    uint64_t m_nextFrameEnd;
+    uint64_t m_frameEnd;
+    uint32_t m_droppedFrames;
+};
@@ -0,0 +1,561 @@
+#include "tdoa_localizer.h"
+#include <cmath>
+
+// Define M_PI if not available in the C++ standard library
+#ifndef M_PI
+#define M_PI 3.14159265358979323846f
+#endif
+
+TdoaLocalizer::TdoaLocalizer(size_t numHydrophones, float soundSpeed)
+    : m_numHydrophones(numHydrophones > kMaxHydrophones ? kMaxHydrophones : numHydrophones),
+      m_soundSpeed(soundSpeed > 0.0f ? soundSpeed : GccPhat::kSoundSpeedWater), m_timingAccuracy(0.0f),
+      m_belowPlane(true), m_initialRange(10.0f), m_maxRange(100.0f), m_numParameters(0), m_dimensions(3), m_planeZ(0.0),
+      m_azimuth(0.0), m_elevation(0.0), m_rmsResidual(0.0), m_iterations(0)
+{
+    for (size_t i = 0; i < kMaxHydrophones; ++i)
+    {
+        m_hydrophones[i][0] = m_hydrophones[i][1] = m_hydrophones[i][2] = 0.0;
+        m_residuals[i] = 0.0;
+    }
+    m_position[0] = m_position[1] = m_position[2] = 0.0;
+    for (size_t r = 0; r < kMaxParameters; ++r)
+    {
+        for (size_t c = 0; c < kMaxParameters; ++c)
+        {
+            m_covariance[r][c] = 0.0;
+        }
+    }
+    m_angleCovariance[0][0] = m_angleCovariance[0][1] = m_angleCovariance[1][0] = m_angleCovariance[1][1] = 0.0;
+}
+
+void TdoaLocalizer::setHydrophone(size_t index, float x, float y, float z)
+{
+    if (index < kMaxHydrophones)
+    {
+        m_hydrophones[index][0] = x;
+        m_hydrophones[index][1] = y;
+        m_hydrophones[index][2] = z;
+    }
+}
+
+bool TdoaLocalizer::isPlanar() const
+{
+    for (size_t i = 1; i < m_numHydrophones; ++i)
+    {
+        if (fabs(m_hydrophones[i][2] - m_hydrophones[0][2]) > 1e-6)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TdoaLocalizer::solveBearing(const float *delays)
+{
+    const size_t n = m_numHydrophones;
+    const bool planar = isPlanar();
+    const size_t unknowns = planar ? 2 : 3;
+    if (n < 3 || n - 1 < unknowns)
+    {
+        return false;
+    }
+
+    // Closed form: (p_i - p_0) . s = -delay_i for the slowness vector s = u / c, by least squares
+    double normal[kMaxParameters][kMaxParameters] = {};
+    double rhs[kMaxParameters] = {};
+    for (size_t i = 1; i < n; ++i)
+    {
+        double row[3];
+        for (size_t k = 0; k < 3; ++k)
+        {
+            row[k] = m_hydrophones[i][k] - m_hydrophones[0][k];
+        }
+        for (size_t r = 0; r < unknowns; ++r)
+        {
+            for (size_t c = 0; c < unknowns; ++c)
+            {
+                normal[r][c] += row[r] * row[c];
+            }
+            rhs[r] -= row[r] * delays[i];
+        }
+    }
+    if (!solveLinear(normal, rhs, unknowns))
+    {
+        return false;
+    }
+
+    m_azimuth = atan2(rhs[1], rhs[0]);
+    if (planar)
+    {
+        // Only the in-plane part of the slowness is measured; its length fixes |cos(elevation)|
+        const double inPlane = m_soundSpeed * sqrt(rhs[0] * rhs[0] + rhs[1] * rhs[1]);
+        const double elevation = acos(inPlane > 1.0 ? 1.0 : inPlane);
+        m_elevation = m_belowPlane ? -elevation : elevation;
+    }
+    else
+    {
+        m_elevation = atan2(rhs[2], sqrt(rhs[0] * rhs[0] + rhs[1] * rhs[1]));
+    }
+
+    m_numParameters = 2;
+    if (!refine(delays, true))
+    {
+        return false;
+    }
+    if (planar)
+    {
+        m_elevation = m_belowPlane ? -fabs(m_elevation) : fabs(m_elevation);
+    }
+    m_angleCovariance[0][0] = m_covariance[0][0];
+    m_angleCovariance[0][1] = m_covariance[0][1];
+    m_angleCovariance[1][0] = m_covariance[1][0];
+    m_angleCovariance[1][1] = m_covariance[1][1];
+    return true;
+}
+
+bool TdoaLocalizer::solvePosition(const float *delays, size_t dimensions, float planeZ)
+{
+    const size_t n = m_numHydrophones;
+    m_dimensions = dimensions == 2 ? 2 : 3;
+    m_planeZ = planeZ;
+    if (n < 3 || n - 1 < m_dimensions)
+    {
+        return false;
+    }
+
+    // Closed form: with r_i = r_0 + c * delay_i, differencing |x - p_i|^2 against |x - p_0|^2 gives
+    // 2 (p_i - p_0) . x + 2 c delay_i r_0 = |p_i|^2 - |p_0|^2 - (c delay_i)^2, linear in (x, r_0)
+    const double c = m_soundSpeed;
+    const size_t unknowns = m_dimensions + 1;
+    bool closedForm = n - 1 >= unknowns;
+    if (closedForm)
+    {
+        double normal[kMaxParameters][kMaxParameters] = {};
+        double rhs[kMaxParameters] = {};
+        const double *p0 = m_hydrophones[0];
+        for (size_t i = 1; i < n; ++i)
+        {
+            const double *p = m_hydrophones[i];
+            const double range = c * delays[i];
+            double row[kMaxParameters];
+            double value = (p[0] * p[0] + p[1] * p[1] + p[2] * p[2]) - (p0[0] * p0[0] + p0[1] * p0[1] + p0[2] * p0[2]) -
+                           range * range;
+            for (size_t k = 0; k < m_dimensions; ++k)
+            {
+                row[k] = 2.0 * (p[k] - p0[k]);
+            }
+            if (m_dimensions == 2)
+            {
+                value -= 2.0 * (p[2] - p0[2]) * m_planeZ;
+            }
+            row[m_dimensions] = 2.0 * range;
+            for (size_t r = 0; r < unknowns; ++r)
+            {
+                for (size_t col = 0; col < unknowns; ++col)
+                {
+                    normal[r][col] += row[r] * row[col];
+                }
+                rhs[r] += row[r] * value;
+            }
+        }
+        closedForm = solveLinear(normal, rhs, unknowns);
+        if (closedForm)
+        {
+            m_position[0] = rhs[0];
+            m_position[1] = rhs[1];
+            m_position[2] = m_dimensions == 3 ? rhs[2] : m_planeZ;
+        }
+    }
+    if (!closedForm)
+    {
+        // Too few delays for the linear solution: start along the plane-wave bearing
+        if (!solveBearing(delays))
+        {
+            return false;
+        }
+        const double horizontal = m_dimensions == 3 ? m_initialRange * cos(m_elevation) : m_initialRange;
+        m_position[0] = m_hydrophones[0][0] + horizontal * cos(m_azimuth);
+        m_position[1] = m_hydrophones[0][1] + horizontal * sin(m_azimuth);
+        m_position[2] = m_dimensions == 3 ? m_hydrophones[0][2] + m_initialRange * sin(m_elevation) : m_planeZ;
+    }
+
+    m_numParameters = m_dimensions;
+    if (!refine(delays, false))
+    {
+        return false;
+    }
+
+    // Direction of the position from the array origin, with its covariance carried over
+    const double x = m_position[0];
+    const double y = m_position[1];
+    const double z = m_position[2];
+    const double horizontal2 = x * x + y * y;
+    const double range2 = horizontal2 + z * z;
+    const double horizontal = sqrt(horizontal2);
+    m_azimuth = atan2(y, x);
+    m_elevation = atan2(z, horizontal);
+    if (horizontal2 <= 0.0 || range2 <= 0.0)
+    {
+        return true;
+    }
+    double gradient[2][3] = {{-y / horizontal2, x / horizontal2, 0.0},
+                             {-z * x / (horizontal * range2), -z * y / (horizontal * range2), horizontal / range2}};
+    for (size_t a = 0; a < 2; ++a)
+    {
+        for (size_t b = 0; b < 2; ++b)
+        {
+            double sum = 0.0;
+            for (size_t r = 0; r < m_dimensions; ++r)
+            {
+                for (size_t col = 0; col < m_dimensions; ++col)
+                {
+                    sum += gradient[a][r] * m_covariance[r][col] * gradient[b][col];
+                }
+            }
+            m_angleCovariance[a][b] = sum;
+        }
+    }
+    return true;
+}
+
+// Plane wave from direction u(azimuth, elevation): delay_i = -(p_i - p_0) . u / c
+void TdoaLocalizer::bearingModel(double *model, double jacobian[][kMaxParameters]) const
+{
+    const double ca = cos(m_azimuth);
+    const double sa = sin(m_azimuth);
+    const double ce = cos(m_elevation);
+    const double se = sin(m_elevation);
+    const double u[3] = {ce * ca, ce * sa, se};
+    const double dAzimuth[3] = {-ce * sa, ce * ca, 0.0};
+    const double dElevation[3] = {-se * ca, -se * sa, ce};
+    for (size_t i = 1; i < m_numHydrophones; ++i)
+    {
+        double dot = 0.0;
+        double dotAzimuth = 0.0;
+        double dotElevation = 0.0;
+        for (size_t k = 0; k < 3; ++k)
+        {
+            const double d = m_hydrophones[i][k] - m_hydrophones[0][k];
+            dot += d * u[k];
+            dotAzimuth += d * dAzimuth[k];
+            dotElevation += d * dElevation[k];
+        }
+        model[i] = -dot / m_soundSpeed;
+        jacobian[i][0] = -dotAzimuth / m_soundSpeed;
+        jacobian[i][1] = -dotElevation / m_soundSpeed;
+    }
+}
+
+// Point source at x: delay_i = (|x - p_i| - |x - p_0|) / c
+void TdoaLocalizer::positionModel(double *model, double jacobian[][kMaxParameters]) const
+{
+    double toReference[3];
+    double reference = 0.0;
+    for (size_t k = 0; k < 3; ++k)
+    {
+        toReference[k] = m_position[k] - m_hydrophones[0][k];
+        reference += toReference[k] * toReference[k];
+    }
+    reference = sqrt(reference);
+
+    for (size_t i = 1; i < m_numHydrophones; ++i)
+    {
+        double toHydrophone[3];
+        double range = 0.0;
+        for (size_t k = 0; k < 3; ++k)
+        {
+            toHydrophone[k] = m_position[k] - m_hydrophones[i][k];
+            range += toHydrophone[k] * toHydrophone[k];
+        }
+        range = sqrt(range);
+        model[i] = (range - reference) / m_soundSpeed;
+        for (size_t k = 0; k < m_dimensions; ++k)
+        {
+            const double unit = range > 0.0 ? toHydrophone[k] / range : 0.0;
+            const double unitReference = reference > 0.0 ? toReference[k] / reference : 0.0;
+            jacobian[i][k] = (unit - unitReference) / m_soundSpeed;
+        }
+    }
+}
+
+bool TdoaLocalizer::refine(const float *delays, bool bearing)
+{
+    const size_t n = m_numHydrophones;
+    const size_t p = m_numParameters;
+    double model[kMaxHydrophones] = {};
+    double jacobian[kMaxHydrophones][kMaxParameters] = {};
+
+    m_iterations = 0;
+    bool converged = false;
+    for (size_t iteration = 0; iteration < kMaxIterations; ++iteration)
+    {
+        bearing ? bearingModel(model, jacobian) : positionModel(model, jacobian);
+
+        double normal[kMaxParameters][kMaxParameters] = {};
+        double step[kMaxParameters] = {};
+        double trace = 0.0;
+        double sumSquares = 0.0;
+        for (size_t i = 1; i < n; ++i)
+        {
+            const double residual = delays[i] - model[i];
+            sumSquares += residual * residual;
+            for (size_t r = 0; r < p; ++r)
+            {
+                for (size_t c = 0; c < p; ++c)
+                {
+                    normal[r][c] += jacobian[i][r] * jacobian[i][c];
+                }
+                step[r] += jacobian[i][r] * residual;
+            }
+        }
+        for (size_t r = 0; r < p; ++r)
+        {
+            trace += normal[r][r];
+        }
+
+        // A touch of damping keeps directions the array cannot see (e.g. elevation in its plane) solvable
+        for (size_t r = 0; r < p; ++r)
+        {
+            normal[r][r] += 1e-9 * trace / p + 1e-30;
+        }
+        if (!solveLinear(normal, step, p))
+        {
+            return false;
+        }
+
+        double largest = 0.0;
+        for (size_t r = 0; r < p; ++r)
+        {
+            if (!std::isfinite(step[r]))
+            {
+                return false;
+            }
+            largest = fabs(step[r]) > largest ? fabs(step[r]) : largest;
+        }
+
+        // Halve the step until the fit improves (a full step can overshoot far from the solution)
+        double saved[3];
+        for (size_t k = 0; k < p; ++k)
+        {
+            saved[k] = bearing ? (k == 0 ? m_azimuth : m_elevation) : m_position[k];
+        }
+        double scale = 1.0;
+        bool improved = false;
+        for (size_t halving = 0; halving < kMaxHalvings; ++halving)
+        {
+            applyStep(saved, step, scale, bearing);
+            improved = sumOfSquares(delays, bearing) <= sumSquares;
+            if (improved)
+            {
+                break;
+            }
+            scale *= 0.5;
+        }
+        m_iterations = iteration + 1;
+        if (!improved)
+        {
+            // No descent left along the step: at the minimum to within rounding
+            applyStep(saved, step, 0.0, bearing);
+            converged = true;
+            break;
+        }
+        if (largest * scale < kStepTolerance)
+        {
+            converged = true;
+            break;
+        }
+    }
+    m_azimuth = atan2(sin(m_azimuth), cos(m_azimuth));
+
+    // A position that keeps moving, or runs off to where the array only sees a bearing, is no fit
+    if (!bearing)
+    {
+        double range = 0.0;
+        for (size_t k = 0; k < 3; ++k)
+        {
+            range += (m_position[k] - m_hydrophones[0][k]) * (m_position[k] - m_hydrophones[0][k]);
+        }
+        if (!converged || !(sqrt(range) <= m_maxRange))
+        {
+            return false;
+        }
+    }
+
+    // Residuals, covariance scale and (J^T J)^-1 at the solution
+    bearing ? bearingModel(model, jacobian) : positionModel(model, jacobian);
+    double sumSquares = 0.0;
+    m_residuals[0] = 0.0;
+    for (size_t i = 1; i < n; ++i)
+    {
+        m_residuals[i] = delays[i] - model[i];
+        sumSquares += m_residuals[i] * m_residuals[i];
+    }
+    m_rmsResidual = sqrt(sumSquares / (n - 1));
+    double variance = (double)m_timingAccuracy * m_timingAccuracy;
+    if (n - 1 > p && sumSquares / (n - 1 - p) > variance)
+    {
+        variance = sumSquares / (n - 1 - p);
+    }
+
+    double normal[kMaxParameters][kMaxParameters] = {};
+    for (size_t i = 1; i < n; ++i)
+    {
+        for (size_t r = 0; r < p; ++r)
+        {
+            for (size_t c = 0; c < p; ++c)
+            {
+                normal[r][c] += jacobian[i][r] * jacobian[i][c];
+            }
+        }
+    }
+    // Invert over the parameters the array constrains; the rest (e.g. elevation of a source in the
+    // plane of a planar array) are reported as unbounded without spoiling the others
+    size_t observed[kMaxParameters];
+    size_t numObserved = 0;
+    double largest = 0.0;
+    for (size_t r = 0; r < p; ++r)
+    {
+        largest = normal[r][r] > largest ? normal[r][r] : largest;
+    }
+    for (size_t r = 0; r < p; ++r)
+    {
+        if (normal[r][r] > 1e-12 * largest)
+        {
+            observed[numObserved++] = r;
+        }
+        for (size_t c = 0; c < p; ++c)
+        {
+            m_covariance[r][c] = r == c ? HUGE_VAL : 0.0;
+        }
+    }
+    for (size_t column = 0; column < numObserved; ++column)
+    {
+        double a[kMaxParameters][kMaxParameters];
+        double e[kMaxParameters] = {};
+        for (size_t r = 0; r < numObserved; ++r)
+        {
+            for (size_t c = 0; c < numObserved; ++c)
+            {
+                a[r][c] = normal[observed[r]][observed[c]];
+            }
+        }
+        e[column] = 1.0;
+        if (!solveLinear(a, e, numObserved))
+        {
+            continue;
+        }
+        for (size_t r = 0; r < numObserved; ++r)
+        {
+            m_covariance[observed[r]][observed[column]] = variance * e[r];
+        }
+    }
+    return true;
+}
+
+void TdoaLocalizer::applyStep(const double *start, const double *step, double scale, bool bearing)
+{
+    if (bearing)
+    {
+        m_azimuth = start[0] + scale * step[0];
+        m_elevation = start[1] + scale * step[1];
+        m_elevation = m_elevation > M_PI / 2 ? M_PI / 2 : (m_elevation < -M_PI / 2 ? -M_PI / 2 : m_elevation);
+    }
+    else
+    {
+        for (size_t k = 0; k < m_numParameters; ++k)
+        {
+            m_position[k] = start[k] + scale * step[k];
+        }
+    }
+}
+
+double TdoaLocalizer::sumOfSquares(const float *delays, bool bearing) const
+{
+    double model[kMaxHydrophones] = {};
+    double jacobian[kMaxHydrophones][kMaxParameters] = {};
+    bearing ? bearingModel(model, jacobian) : positionModel(model, jacobian);
+    double sum = 0.0;
+    for (size_t i = 1; i < m_numHydrophones; ++i)
+    {
+        sum += (delays[i] - model[i]) * (delays[i] - model[i]);
+    }
+    return sum;
+}
+
+bool TdoaLocalizer::solveLinear(double a[kMaxParameters][kMaxParameters], double *b, size_t n)
+{
+    double scale = 0.0;
+    for (size_t r = 0; r < n; ++r)
+    {
+        for (size_t c = 0; c < n; ++c)
+        {
+            scale = fabs(a[r][c]) > scale ? fabs(a[r][c]) : scale;
+        }
+    }
+    if (scale <= 0.0)
+    {
+        return false;
+    }
+
+    for (size_t k = 0; k < n; ++k)
+    {
+        size_t pivot = k;
+        for (size_t r = k + 1; r < n; ++r)
+        {
+            if (fabs(a[r][k]) > fabs(a[pivot][k]))
+            {
+                pivot = r;
+            }
+        }
+        if (fabs(a[pivot][k]) <= 1e-12 * scale)
+        {
+            return false;
+        }
+        if (pivot != k)
+        {
+            for (size_t c = 0; c < n; ++c)
+            {
+                const double t = a[k][c];
+                a[k][c] = a[pivot][c];
+                a[pivot][c] = t;
+            }
+            const double t = b[k];
+            b[k] = b[pivot];
+            b[pivot] = t;
+        }
+        for (size_t r = k + 1; r < n; ++r)
+        {
+            const double factor = a[r][k] / a[k][k];
+            for (size_t c = k; c < n; ++c)
+            {
+                a[r][c] -= factor * a[k][c];
+            }
+            b[r] -= factor * b[k];
+        }
+    }
+    for (size_t k = n; k-- > 0;)
+    {
+        double sum = b[k];
+        for (size_t c = k + 1; c < n; ++c)
+        {
+            sum -= a[k][c] * b[c];
+        }
+        b[k] = sum / a[k][k];
+    }
+    return true;
+}
+
+float TdoaLocalizer::getAzimuthStd() const
+{
+    return (float)sqrt(m_angleCovariance[0][0] > 0.0 ? m_angleCovariance[0][0] : 0.0);
+}
+
+float TdoaLocalizer::getElevationStd() const
+{
+    return (float)sqrt(m_angleCovariance[1][1] > 0.0 ? m_angleCovariance[1][1] : 0.0);
+}
+
+float TdoaLocalizer::getCovariance(size_t row, size_t column) const
+{
+    return row < m_numParameters && column < m_numParameters ? (float)m_covariance[row][column] : 0.0f;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "gcc_phat.h"
+#include <cstddef>
+
+// Source direction or position from the arrival-time differences across a hydrophone array.
+// Delays are arrival at hydrophone i minus arrival at hydrophone 0, in seconds.
+//
+// solveBearing() assumes a distant source (plane wave): the delays are linear in the slowness
+// vector u / c, whose least-squares solution gives the closed-form direction, which Gauss-Newton
+// then refines over azimuth and elevation with c fixed. When all hydrophones lie in the z = 0
+// plane the sign of the elevation is not observable; setBelowPlane() chooses it.
+//
+// solvePosition() fits a source position in 3D, or in 2D on the plane z = planeZ (e.g. a pinger
+// at a known depth). The closed form is the linearised range-difference solution (unknowns: the
+// position and the range to hydrophone 0), which needs one more delay than unknowns; with fewer,
+// Gauss-Newton starts from the bearing at setInitialRange(). Either way the result is refined by
+// Gauss-Newton on the exact range differences. Range is only observable within a few apertures
+// of the array; a fit that does not converge or ends beyond setMaxRange() fails. With exactly as
+// many delays as unknowns there can be two exact solutions, and the one reached is not necessarily
+// the source: more hydrophones, or the 2D fit at a known depth, resolve it.
+//
+// After a solve, the residuals (measured minus model delays) and the parameter covariance are
+// available. The covariance is sigma^2 * (J^T J)^-1 with sigma the larger of the configured timing
+// accuracy and the RMS residual (when the fit has spare measurements), so its square roots are a
+// confidence for each parameter. Angles are in radians: azimuth counterclockwise from +x towards +y,
+// elevation up from the x-y plane.
+//
+// All storage is fixed-size; a solve does no allocation and takes a few microseconds to tens of
+// microseconds on the Cortex-M7 (double precision throughout).
+class TdoaLocalizer
+{
+public:
+    static constexpr size_t kMaxHydrophones = 8;
+
+    TdoaLocalizer(size_t numHydrophones, float soundSpeed = GccPhat::kSoundSpeedWater);
+
+    // Hydrophone position in the array frame (metres)
+    void setHydrophone(size_t index, float x, float y, float z);
+    void setSoundSpeed(float soundSpeed) { m_soundSpeed = soundSpeed > 0.0f ? soundSpeed : m_soundSpeed; }
+
+    // Standard deviation of each delay (seconds); the floor for the covariance scale
+    void setTimingAccuracy(float seconds) { m_timingAccuracy = seconds > 0.0f ? seconds : 0.0f; }
+
+    // Planar arrays: report the source below (true, the default) or above the array plane
+    void setBelowPlane(bool below) { m_belowPlane = below; }
+
+    // Starting range (metres) for solvePosition() when the closed form is underdetermined
+    void setInitialRange(float range) { m_initialRange = range > 0.0f ? range : m_initialRange; }
+
+    // Range from hydrophone 0 (metres) beyond which solvePosition() fails
+    void setMaxRange(float range) { m_maxRange = range > 0.0f ? range : m_maxRange; }
+
+    // delays[i]: arrival at hydrophone i minus arrival at hydrophone 0 (s); delays[0] is ignored.
+    // Return false for fewer than three hydrophones, a degenerate geometry or a diverged fit.
+    bool solveBearing(const float* delays);
+    bool solvePosition(const float* delays, size_t dimensions, float planeZ = 0.0f);
+
+    // Bearing from the last solve (solvePosition() sets it to the direction of the position)
+    float getAzimuth() const { return (float)m_azimuth; }
+    float getElevation() const { return (float)m_elevation; }
+    float getAzimuthStd() const;
+    float getElevationStd() const;
+
+    // Position from the last solvePosition() (metres)
+    float getX() const { return (float)m_position[0]; }
+    float getY() const { return (float)m_position[1]; }
+    float getZ() const { return (float)m_position[2]; }
+
+    // Covariance of the fitted parameters: (azimuth, elevation) after solveBearing(), the position
+    // coordinates after solvePosition()
+    float getCovariance(size_t row, size_t column) const;
+    size_t getNumParameters() const { return m_numParameters; }
+
+    // Residual of delay i (s) and their RMS over hydrophones 1 .. n-1
+    float getResidual(size_t index) const { return index < m_numHydrophones ? (float)m_residuals[index] : 0.0f; }
+    float getRmsResidual() const { return (float)m_rmsResidual; }
+    size_t getIterations() const { return m_iterations; }
+
+    size_t getNumHydrophones() const { return m_numHydrophones; }
+
+private:
+    static constexpr size_t kMaxParameters = 4;     // position and range in the closed form
+    static constexpr size_t kMaxIterations = 20;
+    static constexpr size_t kMaxHalvings = 8;       // step halvings per iteration
+    static constexpr double kStepTolerance = 1e-7;  // radians or metres
+
+    // Solve the n x n system a * x = b in place (Gaussian elimination with partial pivoting)
+    static bool solveLinear(double a[kMaxParameters][kMaxParameters], double* b, size_t n);
+
+    // Model delays and their Jacobian for the current parameters
+    void bearingModel(double* model, double jacobian[][kMaxParameters]) const;
+    void positionModel(double* model, double jacobian[][kMaxParameters]) const;
+
+    // Gauss-Newton on the current parameters; fills residuals and covariance
+    bool refine(const float* delays, bool bearing);
+    void applyStep(const double* start, const double* step, double scale, bool bearing);
+    double sumOfSquares(const float* delays, bool bearing) const;
+
+    bool isPlanar() const;
+
+    size_t m_numHydrophones;
+    float m_soundSpeed;
+    float m_timingAccuracy;
+    bool m_belowPlane;
+    float m_initialRange;
+    float m_maxRange;
+    double m_hydrophones[kMaxHydrophones][3];
+
+    // Fit state
+    size_t m_numParameters;
+    size_t m_dimensions;
+    double m_planeZ;
+    double m_azimuth;
+    double m_elevation;
+    double m_position[3];
+    double m_residuals[kMaxHydrophones];
+    double m_rmsResidual;
+    double m_covariance[kMaxParameters][kMaxParameters];
+    double m_angleCovariance[2][2];   // azimuth, elevation
+    size_t m_iterations;
+};
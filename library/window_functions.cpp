@@ -0,0 +1,103 @@
+#include "window_functions.h"
+#include <cmath>
+
+// Define M_PI if not available in the C++ standard library
+#ifndef M_PI
+#define M_PI 3.14159265358979323846f
+#endif
+
+// Zeroth-order modified Bessel function of the first kind (power series)
+static double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    const double quarter_x2 = 0.25 * x * x;
+    for (int k = 1; k < 50; ++k)
+    {
+        term *= quarter_x2 / ((double)k * k);
+        sum += term;
+        if (term < sum * 1e-12)
+        {
+            break;
+        }
+    }
+    return sum;
+}
+
+// Window coefficient for sample i of a size-point window
+float WindowCache::value(WindowType type, size_t i, size_t size, float beta)
+{
+    if (size < 2)
+    {
+        return 1.0f;
+    }
+
+    switch (type)
+    {
+    case WindowType::BlackmanHarris:
+    {
+        const double x = 2.0 * M_PI * i / (size - 1);
+        return (float)(0.35875 - 0.48829 * cos(x) + 0.14128 * cos(2.0 * x) - 0.01168 * cos(3.0 * x));
+    }
+    case WindowType::FlatTop:
+    {
+        const double x = 2.0 * M_PI * i / (size - 1);
+        return (float)(0.21557895 - 0.41663158 * cos(x) + 0.277263158 * cos(2.0 * x) - 0.083578947 * cos(3.0 * x) +
+                       0.006947368 * cos(4.0 * x));
+    }
+    case WindowType::Kaiser:
+    {
+        const double r = 2.0 * i / (size - 1) - 1.0;
+        return (float)(besselI0(beta * sqrt(1.0 - r * r)) / besselI0(beta));
+    }
+    case WindowType::Rectangular:
+        return 1.0f;
+    case WindowType::Hann:
+    default:
+        // Same expression as FFTLibrary::applyHanningWindow
+        return 0.5f * (1.0f - cosf((float)(2.0 * M_PI * i / (size - 1))));
+    }
+}
+
+WindowCache &WindowCache::shared()
+{
+    static WindowCache cache;
+    return cache;
+}
+
+const WindowTable *WindowCache::get(WindowType type, size_t size, float beta)
+{
+    for (size_t t = 0; t < m_numTables; ++t)
+    {
+        const WindowTable &table = m_tables[t];
+        if (table.type == type && table.coefficients.size() == size && (type != WindowType::Kaiser || table.beta == beta))
+        {
+            return &table;
+        }
+    }
+    if (m_numTables >= kMaxTables)
+    {
+        return nullptr;
+    }
+
+    WindowTable &table = m_tables[m_numTables];
+    table.type = type;
+    table.beta = beta;
+    table.coefficients.resize(size);
+
+    double sum = 0.0;
+    double sum_sq = 0.0;
+    for (size_t i = 0; i < size; ++i)
+    {
+        const float w = value(type, i, size, beta);
+        table.coefficients[i] = w;
+        sum += w;
+        sum_sq += (double)w * w;
+    }
+    table.sum = (float)sum;
+    table.coherentGain = size > 0 ? (float)(sum / size) : 0.0f;
+    table.enbw = sum > 0.0 ? (float)(size * sum_sq / (sum * sum)) : 0.0f;
+
+    ++m_numTables;
+    return &table;
+}
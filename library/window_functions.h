@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Analysis windows (symmetric, N - 1 denominator like FFTLibrary::applyHanningWindow)
+enum class WindowType
+{
+    Hann,
+    BlackmanHarris, // 4-term, -92 dB sidelobes
+    FlatTop,        // 5-term, < 0.01 dB scalloping loss; best for amplitude readings
+    Kaiser,         // adjustable via beta
+    Rectangular,    // no taper; the matched template for a gated tone burst
+};
+
+// Precomputed window coefficients with their calibration constants
+struct WindowTable
+{
+    WindowType type;
+    float beta;                      // Kaiser only
+    std::vector<float> coefficients;
+    float sum;                       // sum of w[n]; an on-bin sine of amplitude A gives |X[k]| = A * sum / 2
+    float coherentGain;              // sum / N
+    float enbw;                      // equivalent noise bandwidth in bins: N * sum(w^2) / sum(w)^2
+};
+
+// Builds each (type, size, beta) window once and keeps it for later calls.
+// FFTLibrary and GoertzelDetector all use the one shared() cache, so every instance with the same
+// window and size reads the same table. Holds at most kMaxTables windows and never evicts; tables
+// never move, so a returned pointer stays valid for the cache's lifetime. Tables are built when
+// their users are constructed or configured, not in the audio callback.
+class WindowCache
+{
+public:
+    static constexpr size_t kMaxTables = 16;
+
+    WindowCache() : m_numTables(0) {}
+
+    // The cache shared by the library classes (built on first use, so safe from static constructors)
+    static WindowCache& shared();
+
+    // Returns nullptr for a new combination once the cache is full
+    const WindowTable* get(WindowType type, size_t size, float beta = 8.6f);
+
+    static float value(WindowType type, size_t i, size_t size, float beta);
+
+private:
+    WindowTable m_tables[kMaxTables];
+    size_t m_numTables;
+};
@@ -0,0 +1,229 @@
+#include "zoom_fft.h"
+#include "window_functions.h"
+#include <cmath>
+
+// Define M_PI if not available in the C++ standard library
+#ifndef M_PI
+#define M_PI 3.14159265358979323846f
+#endif
+
+ZoomFFT::ZoomFFT(float sampleRate, float centerFreq, float span, float resolution)
+    : m_sampleRate(sampleRate), m_centerFreq(centerFreq), m_span(span), m_outputRate(sampleRate), m_decimation(1),
+      m_inputSize(0), m_outputSize(0), m_fftSize(0), m_magnitudeScale(1.0f), m_fft(sampleRate)
+{
+    // Halve the rate while the decimated band still leaves a 25% guard above the span,
+    // which keeps each halfband's transition band clear of the span
+    while (m_stages.size() < kMaxStages && m_outputRate * 0.5f >= 1.25f * span)
+    {
+        const float inputRate = m_outputRate;
+        m_outputRate *= 0.5f;
+        m_decimation *= 2;
+
+        // Kaiser length estimate for the transition from span/2 to inputRate/2 - span/2
+        const float passEdge = 0.5f * span / inputRate;
+        const float transition = 0.5f - 2.0f * passEdge;
+        const float order = (kStopbandDb - 8.0f) / (2.285f * 2.0f * (float)M_PI * transition);
+        size_t length = 3;
+        while ((float)(length - 1) < order)
+        {
+            length += 4;
+        }
+
+        // Windowed-sinc halfband, normalised to unity gain at DC
+        const float beta = 0.1102f * (kStopbandDb - 8.7f);
+        const size_t centre = (length - 1) / 2;
+        HalfbandStage stage;
+        stage.length = length;
+        stage.outputSize = 0;
+        float sum = 0.0f;
+        for (size_t d = 1; d <= centre; d += 2)
+        {
+            const float sinc = (float)(sin(M_PI * d / 2.0) / (M_PI * d / 2.0));
+            const float tap = 0.5f * sinc * WindowCache::value(WindowType::Kaiser, centre + d, length, beta);
+            stage.taps.push_back(tap);
+            sum += 2.0f * tap;
+        }
+        for (size_t i = 0; i < stage.taps.size(); ++i)
+        {
+            stage.taps[i] *= 0.5f / sum;
+        }
+        m_stages.push_back(stage);
+    }
+
+    // Decimated samples needed for the requested resolution, zero padded to a power of two
+    m_outputSize = (size_t)ceilf(m_outputRate / (resolution > 0.0f ? resolution : 1.0f));
+    if (m_outputSize < 4)
+    {
+        m_outputSize = 4;
+    }
+    m_fftSize = 1;
+    while (m_fftSize < m_outputSize)
+    {
+        m_fftSize <<= 1;
+    }
+
+    // Work back through the stages to the input length (valid filter outputs only, no start-up transient)
+    size_t length = m_outputSize;
+    for (size_t s = m_stages.size(); s-- > 0;)
+    {
+        m_stages[s].outputSize = length;
+        length = 2 * (length - 1) + m_stages[s].length;
+    }
+    m_inputSize = length;
+
+    m_mixer.resize(m_inputSize);
+    for (size_t n = 0; n < m_inputSize; ++n)
+    {
+        const double phase = -2.0 * M_PI * fmod((double)centerFreq * n / sampleRate, 1.0);
+        m_mixer[n] = std::complex<float>((float)cos(phase), (float)sin(phase));
+    }
+
+    m_window.resize(m_outputSize);
+    for (size_t i = 0; i < m_outputSize; ++i)
+    {
+        m_window[i] = WindowCache::value(WindowType::Hann, i, m_outputSize, 0.0f);
+    }
+
+    m_work[0].resize(m_inputSize);
+    m_work[1].resize(m_inputSize);
+    m_spectrum.resize(m_fftSize);
+    m_fft = FFTLibrary(m_outputRate, m_fftSize);
+
+    // The decimated signal has 1/decimation the samples (and window gain) of the full-rate input
+    m_magnitudeScale = (float)m_decimation;
+}
+
+float ZoomFFT::getBinFrequency(size_t k) const
+{
+    const long offset = k < m_fftSize / 2 ? (long)k : (long)k - (long)m_fftSize;
+    return m_centerFreq + offset * getBinSpacing();
+}
+
+float ZoomFFT::binOffset(float frequency) const
+{
+    return (frequency - m_centerFreq) / getBinSpacing();
+}
+
+float ZoomFFT::binMagnitude(long offset) const
+{
+    const size_t k = offset >= 0 ? (size_t)offset : (size_t)(offset + (long)m_fftSize);
+    return std::abs(m_spectrum[k]) * m_magnitudeScale;
+}
+
+bool ZoomFFT::analyze(const float *buffer, size_t buffer_size)
+{
+    if (buffer == nullptr || buffer_size < m_inputSize)
+    {
+        return false;
+    }
+    const float *input = buffer + (buffer_size - m_inputSize);
+
+    // Mix the band centre down to DC
+    std::complex<float> *current = m_work[0].data();
+    std::complex<float> *next = m_work[1].data();
+    for (size_t n = 0; n < m_inputSize; ++n)
+    {
+        current[n] = input[n] * m_mixer[n];
+    }
+
+    // Halfband cascade; each output uses input samples [2m, 2m + length)
+    for (size_t s = 0; s < m_stages.size(); ++s)
+    {
+        const HalfbandStage &stage = m_stages[s];
+        const size_t centre = (stage.length - 1) / 2;
+        const size_t tapCount = stage.taps.size();
+        for (size_t m = 0; m < stage.outputSize; ++m)
+        {
+            const std::complex<float> *x = current + 2 * m + centre;
+            float re = 0.5f * x[0].real();
+            float im = 0.5f * x[0].imag();
+            for (size_t i = 0; i < tapCount; ++i)
+            {
+                const size_t d = 2 * i + 1;
+                re += stage.taps[i] * (x[-(long)d].real() + x[d].real());
+                im += stage.taps[i] * (x[-(long)d].imag() + x[d].imag());
+            }
+            next[m] = std::complex<float>(re, im);
+        }
+        std::swap(current, next);
+    }
+
+    // Window, zero pad and transform
+    for (size_t i = 0; i < m_outputSize; ++i)
+    {
+        m_spectrum[i] = current[i] * m_window[i];
+    }
+    for (size_t i = m_outputSize; i < m_fftSize; ++i)
+    {
+        m_spectrum[i] = std::complex<float>(0.0f, 0.0f);
+    }
+    m_fft.fft(m_spectrum);
+    return true;
+}
+
+float ZoomFFT::getFrequencyMagnitude(float target_freq, float tolerance) const
+{
+    // Only the bins inside the decimated band are meaningful
+    const long limit = (long)m_fftSize / 2 - 1;
+    long lower = (long)ceilf(binOffset(target_freq * (1.0f - tolerance)));
+    long upper = (long)floorf(binOffset(target_freq * (1.0f + tolerance)));
+    if (lower > upper)
+    {
+        lower = upper = lroundf(binOffset(target_freq));
+    }
+    lower = lower < -limit ? -limit : lower;
+    upper = upper > limit ? limit : upper;
+
+    float total = 0.0f;
+    for (long offset = lower; offset <= upper; ++offset)
+    {
+        total += binMagnitude(offset);
+    }
+    return total;
+}
+
+float ZoomFFT::getFrequencyMagnitude(const float *buffer, size_t buffer_size, float target_freq, float tolerance)
+{
+    if (!analyze(buffer, buffer_size))
+    {
+        return 0.0f;
+    }
+    return getFrequencyMagnitude(target_freq, tolerance);
+}
+
+float ZoomFFT::detectPeak(float *magnitude) const
+{
+    // Search the span only; the edges of the decimated band are in the filter transition
+    long limit = (long)floorf(0.5f * m_span / getBinSpacing());
+    if (limit > (long)m_fftSize / 2 - 2)
+    {
+        limit = (long)m_fftSize / 2 - 2;
+    }
+
+    long peak = 0;
+    float peak_mag = -1.0f;
+    for (long offset = -limit; offset <= limit; ++offset)
+    {
+        const float mag = binMagnitude(offset);
+        if (mag > peak_mag)
+        {
+            peak_mag = mag;
+            peak = offset;
+        }
+    }
+
+    if (magnitude != nullptr)
+    {
+        *magnitude = peak_mag;
+    }
+
+    // Parabolic interpolation, as in FFTLibrary::findInterpolatedFrequency
+    const float mag0 = binMagnitude(peak - 1);
+    const float mag2 = binMagnitude(peak + 1);
+    float peak_shift = 0.5f * (mag0 - mag2) / (mag0 - 2.0f * peak_mag + mag2);
+    if (std::isnan(peak_shift))
+    {
+        peak_shift = 0.0f;
+    }
+    return m_centerFreq + ((float)peak + peak_shift) * getBinSpacing();
+}
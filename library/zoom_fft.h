@@ -0,0 +1,81 @@
+#pragma once
+
+#include "fft_library.h"
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// Zoom FFT around one band: mix the band centre down to DC, decimate with a cascade of
+// halfband FIR stages, then run a short complex FFT. The bins cover
+// centerFreq +/- outputRate/2 with the requested resolution, using far fewer FFT points
+// than a full-rate transform with the same bin spacing.
+//
+// Configure once with centre, span and resolution; all tables and buffers are built in the
+// constructor and analyze() does no heap allocation. Magnitudes are scaled by the decimation,
+// so an on-bin tone peaks at the level FFTLibrary gives for a full-rate FFT over the same
+// span of input (decimation * decimated samples).
+class ZoomFFT
+{
+public:
+    ZoomFFT(float sampleRate, float centerFreq, float span, float resolution);
+
+    // Number of input samples used per analysis (the most recent ones in the buffer)
+    size_t getInputSize() const { return m_inputSize; }
+
+    size_t getDecimation() const { return m_decimation; }
+    size_t getBinCount() const { return m_fftSize; }
+    float getBinSpacing() const { return m_outputRate / m_fftSize; }
+
+    // Absolute frequency of bin k (natural FFT order, negative offsets in the upper half)
+    float getBinFrequency(size_t k) const;
+
+    // Transform the last getInputSize() samples of buffer; returns false if the buffer is too short
+    bool analyze(const float* buffer, size_t buffer_size);
+
+    // Zoomed spectrum from the last analyze(), natural FFT order
+    const std::vector<std::complex<float>>& getSpectrum() const { return m_spectrum; }
+
+    // Band magnitude over target_freq * (1 +/- tolerance) from the last analyze();
+    // uses the nearest bin if the band is narrower than one bin
+    float getFrequencyMagnitude(float target_freq, float tolerance) const;
+
+    // analyze() followed by getFrequencyMagnitude(); returns 0 if the buffer is too short
+    float getFrequencyMagnitude(const float* buffer, size_t buffer_size, float target_freq, float tolerance = 0.05f);
+
+    // Interpolated peak frequency within the span from the last analyze(); optionally its magnitude
+    float detectPeak(float* magnitude = nullptr) const;
+
+private:
+    // Halfband lowpass followed by decimation by 2. Only the centre tap (0.5) and the
+    // odd-offset taps are non-zero, so just the odd-offset half is stored.
+    struct HalfbandStage
+    {
+        std::vector<float> taps; // taps[i] applies to offsets +/-(2i + 1) from the centre
+        size_t length;           // full filter length (4k + 3)
+        size_t outputSize;
+    };
+
+    static constexpr float kStopbandDb = 60.0f;
+    static constexpr size_t kMaxStages = 8;
+
+    // Signed bin offset from the centre for frequency f (not clamped)
+    float binOffset(float frequency) const;
+    float binMagnitude(long offset) const;
+
+    float m_sampleRate;
+    float m_centerFreq;
+    float m_span;
+    float m_outputRate;
+    size_t m_decimation;
+    size_t m_inputSize;
+    size_t m_outputSize;     // decimated samples that are windowed into the FFT
+    size_t m_fftSize;        // power of two >= m_outputSize (zero padded)
+    float m_magnitudeScale;
+
+    std::vector<HalfbandStage> m_stages;
+    std::vector<std::complex<float>> m_mixer;     // e^(-2*pi*i*centerFreq*n/fs), n < m_inputSize
+    std::vector<float> m_window;                  // Hann over m_outputSize samples
+    std::vector<std::complex<float>> m_work[2];   // ping-pong stage buffers
+    std::vector<std::complex<float>> m_spectrum;
+    FFTLibrary m_fft;
+};
@@ -53,7 +53,11 @@ int main(void)
     hw.SetAudioBlockSize(FFT_SIZE);
 
     // D. Initialize FFT
-    fft = new FFTLibrary(hw.AudioSampleRate());
+    fft = new FFTLibrary(hw.AudioSampleRate(), FFT_SIZE);
+    if (!fft->isValid())
+    {
+        hw.PrintLine("Error: FFT window tables did not fit in the window cache");
+    }
 
     hw.PrintLine("Starting Audio...");
     hw.StartAudio(AudioCallback);
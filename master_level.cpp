@@ -2,7 +2,9 @@
 #include "daisy_seed.h"
 #include "daisysp.h"
 #include "library/fft_library.h"
+#include "library/streaming_stft.h"
 #include "library/serial_library.h"
+#include "library/zoom_fft.h"
 
 using namespace daisy;
 using namespace daisysp;
@@ -35,6 +37,7 @@ const float hydrophone_1_max = 4.0f;
 // FFT
 constexpr size_t kFftSize = 64;   // Higher = better frequency resolution
 constexpr size_t kBlockSize = 64; // Block size for audio processing
+constexpr size_t kFftHop = kFftSize / 4; // New spectrum every hop (frames overlap by kFftSize - kFftHop)
 
 // RMS
 const float multiplier = 100; // Amplification of signal (per sample)
@@ -43,6 +46,16 @@ const float multiplier = 100; // Amplification of signal (per sample)
 const float targetFrequency = 25000.0f; // Target frequency to detect
 const float frequencyTolerance = 0.01f; // Tolerance for frequency detection
 
+// Narrowband level: a zoom FFT around targetFrequency resolves the +/-frequencyTolerance band in several
+// bins (a kFftSize frame puts it inside one 1.5 kHz bin), so less noise reaches the level, at ~10 ms latency
+const bool useZoomFFT = true;
+const float zoomSpan = 4000.0f;          // Hz around targetFrequency covered by the zoomed bins
+const float zoomResolution = 125.0f;     // Zoomed bin spacing (Hz)
+constexpr size_t kZoomFrameSize = 1024;  // Input frame; at least the zoom FFT's input size (1015 samples here)
+constexpr size_t kZoomHop = 256;         // New zoomed level every hop
+const float hydrophone_0_zoom_max = 176.0f; // Normalization on the zoom scale (a tone reads ~44x the kFftSize level; manually calibrate)
+const float hydrophone_1_zoom_max = 176.0f;
+
 // Printing
 constexpr int kPrintIntervalMs = 1; // Print interval
 
@@ -56,10 +69,18 @@ FFTLibrary fftLibrary(96000.f);
 // FFT buffers for both microphones (MASTER)
 static float DSY_SDRAM_BSS fft_input_buffer_0[kFftSize];
 static float DSY_SDRAM_BSS fft_input_buffer_1[kFftSize];
-static size_t buffer_write_pos_0 = 0;
-static size_t buffer_write_pos_1 = 0;
-static bool fft_ready_for_processing_0 = false;
-static bool fft_ready_for_processing_1 = false;
+static const float* const fft_input_buffers[2] = {fft_input_buffer_0, fft_input_buffer_1};
+static float* const fft_frame_buffers[2] = {fft_input_buffer_0, fft_input_buffer_1};
+
+// Overlapped framing: the callback feeds every sample, a frame completes every kFftHop samples
+StreamingSTFT stft(2, kFftSize, kFftHop);
+
+// Zoom FFT band analysis on longer frames (rebuilt with the actual sample rate in main)
+static float DSY_SDRAM_BSS zoom_buffer_0[kZoomFrameSize];
+static float DSY_SDRAM_BSS zoom_buffer_1[kZoomFrameSize];
+static float* const zoom_frame_buffers[2] = {zoom_buffer_0, zoom_buffer_1};
+StreamingSTFT zoomFrames(2, kZoomFrameSize, kZoomHop);
+ZoomFFT zoom(96000.f, targetFrequency, zoomSpan, zoomResolution);
 
 // Frequency window (derived)
 const float lowerFreq = targetFrequency * (1.0f - frequencyTolerance);
@@ -92,29 +113,15 @@ void MyCallback(AudioHandle::InputBuffer in, AudioHandle::OutputBuffer out, size
         float processedSample_0 = sample_0 * multiplier;
         float processedSample_1 = sample_1 * multiplier;
 
-        // Fill the FFT buffers if ready for more data
-        if (!fft_ready_for_processing_0)
+        // Feed the overlapped STFT history (never paused while the main loop processes a frame)
+        const float processedSamples[2] = {processedSample_0, processedSample_1};
+        if (useZoomFFT)
         {
-            fft_input_buffer_0[buffer_write_pos_0] = processedSample_0;
-            buffer_write_pos_0++;
-
-            if (buffer_write_pos_0 >= kFftSize)
-            {
-                buffer_write_pos_0 = 0;
-                fft_ready_for_processing_0 = true;
-            }
+            zoomFrames.push(processedSamples);
         }
-
-        if (!fft_ready_for_processing_1)
+        else
         {
-            fft_input_buffer_1[buffer_write_pos_1] = processedSample_1;
-            buffer_write_pos_1++;
-
-            if (buffer_write_pos_1 >= kFftSize)
-            {
-                buffer_write_pos_1 = 0;
-                fft_ready_for_processing_1 = true;
-            }
+            stft.push(processedSamples);
         }
     }
 }
@@ -127,7 +134,11 @@ int main(void)
     hw.SetAudioBlockSize(kBlockSize);
 
     // Initialize the FFT library with the actual sample rate
-    fftLibrary = FFTLibrary(hw.AudioSampleRate());
+    fftLibrary = FFTLibrary(hw.AudioSampleRate(), kFftSize);
+
+    // The +/-frequencyTolerance band spans only a few bins, so evaluate just those bins (Goertzel)
+    fftLibrary.setMagnitudeBackend(FFTLibrary::MagnitudeBackend::Goertzel);
+    zoom = ZoomFFT(hw.AudioSampleRate(), targetFrequency, zoomSpan, zoomResolution);
 
     // Initialize serial
     SerialLibrary serial(hw);
@@ -137,6 +148,10 @@ int main(void)
     hw.StartAudio(MyCallback);
 
     hw.PrintLine("TDOA Frequency Detection Ready");
+    if (!fftLibrary.isValid())
+    {
+        hw.PrintLine("Error: FFT window tables did not fit in the window cache");
+    }
     hw.PrintLine("Continuous monitoring: printing levels every %d ms", kPrintIntervalMs);
 
     // Get timestamp
@@ -151,32 +166,38 @@ int main(void)
 
     while (1)
     {
-        // Update latest magnitudes when FFT buffers are ready
-        if (fft_ready_for_processing_0)
+        // Update latest magnitudes when a new overlapped frame is ready (every kFftHop samples)
+        // Both channels share the frame timing, so process them together in one batched call
+        if (!useZoomFFT && stft.readFrame(fft_frame_buffers))
         {
-            detectedFrequencyLevel_0 = fftLibrary.getFrequencyMagnitude(fft_input_buffer_0, kFftSize, targetFrequency, frequencyTolerance);
-            fft_ready_for_processing_0 = false;
+            float levels[2];
+            fftLibrary.getFrequencyMagnitudes(fft_input_buffers, 2, kFftSize, targetFrequency, frequencyTolerance, levels);
+            detectedFrequencyLevel_0 = levels[0];
+            detectedFrequencyLevel_1 = levels[1];
         }
 
-        if (fft_ready_for_processing_1)
+        // Zoomed band level from the newest zoom.getInputSize() samples of each frame (every kZoomHop samples)
+        if (useZoomFFT && zoomFrames.readFrame(zoom_frame_buffers))
         {
-            detectedFrequencyLevel_1 = fftLibrary.getFrequencyMagnitude(fft_input_buffer_1, kFftSize, targetFrequency, frequencyTolerance);
-            fft_ready_for_processing_1 = false;
+            detectedFrequencyLevel_0 = zoom.getFrequencyMagnitude(zoom_buffer_0, kZoomFrameSize, targetFrequency, frequencyTolerance);
+            detectedFrequencyLevel_1 = zoom.getFrequencyMagnitude(zoom_buffer_1, kZoomFrameSize, targetFrequency, frequencyTolerance);
         }
 
         // clip the detected frequency levels
-        if (detectedFrequencyLevel_0 > hydrophone_0_max)
+        const float level_0_max = useZoomFFT ? hydrophone_0_zoom_max : hydrophone_0_max;
+        const float level_1_max = useZoomFFT ? hydrophone_1_zoom_max : hydrophone_1_max;
+        if (detectedFrequencyLevel_0 > level_0_max)
         {
-            detectedFrequencyLevel_0 = hydrophone_0_max;
+            detectedFrequencyLevel_0 = level_0_max;
         }
-        if (detectedFrequencyLevel_1 > hydrophone_1_max)
+        if (detectedFrequencyLevel_1 > level_1_max)
         {
-            detectedFrequencyLevel_1 = hydrophone_1_max;
+            detectedFrequencyLevel_1 = level_1_max;
         }
 
         // Normalize detected frequency levels
-        normalizedDetectedFrequencyLevel_0 = detectedFrequencyLevel_0 / hydrophone_0_max;
-        normalizedDetectedFrequencyLevel_1 = detectedFrequencyLevel_1 / hydrophone_1_max;
+        normalizedDetectedFrequencyLevel_0 = detectedFrequencyLevel_0 / level_0_max;
+        normalizedDetectedFrequencyLevel_1 = detectedFrequencyLevel_1 / level_1_max;
 
         // Read analog values from A0/A1 (from slave)
         normalizedDetectedFrequencyLevel_2 = hw.adc.GetFloat(0);
@@ -1,7 +1,14 @@
 #include "daisy_seed.h"
 #include "daisysp.h"
-#include "library/fft_library.h"
+#include "library/capture_ring.h"
+#include "library/cfar_detector.h"
+#include "library/gcc_phat.h"
+#include "library/matched_filter.h"
+#include "library/sample_clock.h"
+#include "library/sliding_dft.h"
 #include "library/serial_library.h"
+#include "library/streaming_stft.h"
+#include "library/tdoa_localizer.h"
 #include <algorithm>
 
 using namespace daisy;
@@ -37,7 +44,7 @@ const float hydrophone_0_max = 4.0f;
 const float hydrophone_1_max = 4.0f;
 
 // FFT
-constexpr size_t kFftSize = 64;             // Higher = better frequency resolution
+constexpr size_t kFftSize = 64;             // Higher = better frequency resolution (sliding DFT window length)
 constexpr size_t kBlockSize = 64;             // Block size for audio processing
 
 // RMS
@@ -46,27 +53,77 @@ const float multiplier = 100;                 // Amplification of signal (per sa
 // Frequency Detection
 const float targetFrequency = 14080.0f;        // Target frequency to detect
 const float frequencyTolerance = 0.01f;       // Tolerance for frequency detection
-const float baseThreshold = 0.02f;             // Base threshold for frequency detection
+const float baseThreshold = 0.02f;             // Threshold for the slave channels (normalized ADC levels)
+
+// CFAR detection (master channels): crossing thresholds follow the measured noise floor
+const CfarDetector::Mode cfarMode = CfarDetector::Mode::OrderedStatistic;
+const float cfarFalseAlarmProbability = 1e-5f;  // Per audio block (~1500 blocks/s at 96 kHz)
+constexpr size_t kCfarHistoryBlocks = 64;       // Past blocks without a detection in the noise estimate
+const float minimumThreshold = 0.005f;          // Floor for the CFAR threshold (normalized), for near-silence
+
+// Matched filter (master channels): correlation with the pinger's burst, so the whole burst counts towards detection
+const bool useMatchedFilter = true;             // Time master arrivals by matched-filter peaks (false: band-level crossings)
+const float pingDuration = 0.004f;              // Pinger burst length (s), the template length
+constexpr size_t kMatchedFrameSize = 1024;      // Correlation frame (power of two, at least twice the burst)
+const float matchedMinimumThreshold = 0.05f;    // Floor for the matched-filter threshold (burst amplitude after multiplier)
 
 // Ping Detection
 const uint32_t listenTimeMs = 10000;          // Duration of listening for ping (ms)
 const uint32_t offThresholdMs = 1000;         // Threshold for off-time detection (ms)
 const uint32_t withinThresholdUs = 1000000;      // Threshold for within-time detection (us)
 
+// TDOA between the master hydrophones: GCC-PHAT on raw frames around the crossings
+const float hydrophoneSpacing = 0.5f;         // Metres between mic 0 and mic 1; bounds the delay search
+constexpr size_t kTdoaFrameSize = 1024;       // Samples per correlation frame
+const float tdoaWeighting = 0.7f;             // PHAT-beta exponent (1 = pure phase transform)
+const float tdoaMinimumPeak = 0.1f;           // Correlation peak (0 ~ 1) below which the crossing times are kept
+
+// Bearing from all four arrival times (metres; x forward, y left, z up, measured on the vehicle)
+const float hydrophonePositions[4][3] = {{0.25f, 0.25f, 0.0f},     // Mic0: front left (master)
+                                         {-0.25f, 0.25f, 0.0f},    // Mic1: back left (master)
+                                         {0.25f, -0.25f, 0.0f},    // Mic2: front right (slave)
+                                         {-0.25f, -0.25f, 0.0f}};  // Mic3: back right (slave)
+
+// Pre-trigger capture (master channels): the raw samples around the first master arrival are frozen for analysis
+constexpr size_t kCaptureSamples = 9600;      // Per channel and slot (100 ms at 96 kHz); must cover pre + post + detection latency
+constexpr size_t kCaptureSlots = 3;           // One slot being written, the rest hold snapshots for the main loop
+const float capturePreTriggerMs = 20.0f;      // History kept before the trigger
+const float capturePostTriggerMs = 20.0f;     // Samples kept after the trigger
+
 ////////////////////////////// Internal Variables for Master (DO NOT CHANGE) ///////////////////////////////////
 // Hardware
 DaisySeed hw;
 
-// Global FFT library object
-FFTLibrary fftLibrary(96000.f);
-
-// FFT buffers for both microphones (MASTER)
-static float DSY_SDRAM_BSS fft_input_buffer_0[kFftSize];
-static float DSY_SDRAM_BSS fft_input_buffer_1[kFftSize];
-static size_t buffer_write_pos_0 = 0;
-static size_t buffer_write_pos_1 = 0;
-static bool fft_ready_for_processing_0 = false;
-static bool fft_ready_for_processing_1 = false;
+// Sample-index time base for every detection, advanced once per audio block
+SampleClock sampleClock(96000.f);
+
+// Per-sample band trackers for both microphones (MASTER), updated in the audio callback
+SlidingDFT binTracker_0(96000.f, kFftSize, targetFrequency, frequencyTolerance);
+SlidingDFT binTracker_1(96000.f, kFftSize, targetFrequency, frequencyTolerance);
+float sampleRate = 96000.f;
+
+// Noise estimate per microphone from the tracker's own history (it only tracks the band bins)
+CfarDetector cfar_0(cfarMode, cfarFalseAlarmProbability, 0, 0, kCfarHistoryBlocks);
+CfarDetector cfar_1(cfarMode, cfarFalseAlarmProbability, 0, 0, kCfarHistoryBlocks);
+
+// Continuous capture of both master channels (the trackers keep no samples); the TDOA frames come from its snapshots
+static float DSY_SDRAM_BSS capture_storage[CaptureRing::storageSize(2, kCaptureSamples, kCaptureSlots)];
+CaptureRing capture(capture_storage, 2, kCaptureSamples, kCaptureSlots);
+static float DSY_SDRAM_BSS tdoa_buffer_0[kTdoaFrameSize];
+static float DSY_SDRAM_BSS tdoa_buffer_1[kTdoaFrameSize];
+GccPhat tdoa(96000.f, kTdoaFrameSize, GccPhat::maxDelayForSpacing(hydrophoneSpacing));
+
+// Matched filter on overlapped frames (hop = frame - template + 1, set in main), thresholds from the frame maxima
+static float DSY_SDRAM_BSS ping_buffer_0[kMatchedFrameSize];
+static float DSY_SDRAM_BSS ping_buffer_1[kMatchedFrameSize];
+static float* const ping_frame_buffers[2] = {ping_buffer_0, ping_buffer_1};
+MatchedFilter matchedFilter(96000.f, kMatchedFrameSize, 2, targetFrequency, pingDuration);
+StreamingSTFT pingFrames(2, kMatchedFrameSize, kMatchedFrameSize / 2, 2);
+CfarDetector matchedCfar_0(cfarMode, cfarFalseAlarmProbability, 0, 0, kCfarHistoryBlocks);
+CfarDetector matchedCfar_1(cfarMode, cfarFalseAlarmProbability, 0, 0, kCfarHistoryBlocks);
+
+// Least-squares bearing (azimuth from forward towards left, elevation up) with a confidence from the residuals
+TdoaLocalizer localizer(4);
 
 // Frequency window (derived)
 const float lowerFreq = targetFrequency * (1.0f - frequencyTolerance);
@@ -83,9 +140,7 @@ float normalizedDetectedFrequencyLevel_1 = 0.0f;
 float normalizedDetectedFrequencyLevel_2 = 0.0f;
 float normalizedDetectedFrequencyLevel_3 = 0.0f;
 
-// Threshold crossing state and start time (us)
-bool wasAboveThreshold_0 = false;
-bool wasAboveThreshold_1 = false;
+// Threshold crossing state
 bool wasAboveThreshold_2 = false;
 bool wasAboveThreshold_3 = false;
 
@@ -93,6 +148,7 @@ bool wasAboveThreshold_3 = false;
 ////////////////////////////////////////// Setup and Loop //////////////////////////////////////////
 
 void MyCallback(AudioHandle::InputBuffer in, AudioHandle::OutputBuffer out, size_t size) {
+    sampleClock.beginBlock(size);
     for (size_t i = 0; i < size; i++)
     {
         float sample_0 = in[0][i];
@@ -102,31 +158,23 @@ void MyCallback(AudioHandle::InputBuffer in, AudioHandle::OutputBuffer out, size
         float processedSample_0 = sample_0 * multiplier;  
         float processedSample_1 = sample_1 * multiplier;
 
-        // Fill the FFT buffers if ready for more data
-        if (!fft_ready_for_processing_0)
-        {
-            fft_input_buffer_0[buffer_write_pos_0] = processedSample_0;
-            buffer_write_pos_0++;
+        // Update the band magnitude on every sample (threshold crossings are queued with their timestamp)
+        const SampleClock::Timestamp time = sampleClock.stamp(i);
+        binTracker_0.process(processedSample_0, time);
+        binTracker_1.process(processedSample_1, time);
 
-            if (buffer_write_pos_0 >= kFftSize)
-            {
-                buffer_write_pos_0 = 0;
-                fft_ready_for_processing_0 = true;
-            }
-        }
-
-        if (!fft_ready_for_processing_1)
-        {
-            fft_input_buffer_1[buffer_write_pos_1] = processedSample_1;
-            buffer_write_pos_1++;
-
-            if (buffer_write_pos_1 >= kFftSize)
-            {
-                buffer_write_pos_1 = 0;
-                fft_ready_for_processing_1 = true;
-            }
-        }
+        // Keep the raw samples (pushed from the first block, so capture and frame positions are clock samples)
+        const float processedSamples[2] = {processedSample_0, processedSample_1};
+        capture.push(processedSamples);
+        pingFrames.push(processedSamples);
     }
+
+    // Once per block: update the noise estimate and move the crossing thresholds with it.
+    // Blocks with a detection are kept out of the history, so a ping does not raise its own threshold.
+    cfar_0.process(binTracker_0.getMagnitude());
+    cfar_1.process(binTracker_1.getMagnitude());
+    binTracker_0.setThreshold(cfar_0.getThreshold());
+    binTracker_1.setThreshold(cfar_1.getThreshold());
 }
 
 int main(void)
@@ -136,8 +184,32 @@ int main(void)
     hw.SetAudioSampleRate(SaiHandle::Config::SampleRate::SAI_96KHZ);
     hw.SetAudioBlockSize(kBlockSize);
 
-    // Initialize the FFT library with the actual sample rate
-    fftLibrary = FFTLibrary(hw.AudioSampleRate());
+    // Initialize the band trackers with the actual sample rate. Thresholds (raw magnitude units) come from
+    // the CFAR detectors once the audio callback has seen enough blocks; until then nothing triggers.
+    sampleRate = hw.AudioSampleRate();
+    sampleClock = SampleClock(sampleRate);
+    binTracker_0 = SlidingDFT(sampleRate, kFftSize, targetFrequency, frequencyTolerance);
+    binTracker_1 = SlidingDFT(sampleRate, kFftSize, targetFrequency, frequencyTolerance);
+    binTracker_0.setThreshold(cfar_0.getThreshold());
+    binTracker_1.setThreshold(cfar_1.getThreshold());
+    cfar_0.setMinimumThreshold(minimumThreshold * hydrophone_0_max);
+    cfar_1.setMinimumThreshold(minimumThreshold * hydrophone_1_max);
+    tdoa = GccPhat(sampleRate, kTdoaFrameSize, GccPhat::maxDelayForSpacing(hydrophoneSpacing));
+    tdoa.setRefinement(GccPhat::Refinement::Sinc);
+    tdoa.setWeighting(tdoaWeighting);
+    matchedFilter = MatchedFilter(sampleRate, kMatchedFrameSize, 2, targetFrequency, pingDuration);
+    pingFrames = StreamingSTFT(2, kMatchedFrameSize, matchedFilter.getHopSize(), 2);
+    matchedCfar_0.setMinimumThreshold(matchedMinimumThreshold);
+    matchedCfar_1.setMinimumThreshold(matchedMinimumThreshold);
+    matchedFilter.setThreshold(0, matchedCfar_0.getThreshold());
+    matchedFilter.setThreshold(1, matchedCfar_1.getThreshold());
+    capture.setWindow(static_cast<size_t>(capturePreTriggerMs * 1e-3f * sampleRate),
+                      static_cast<size_t>(capturePostTriggerMs * 1e-3f * sampleRate));
+    for (size_t i = 0; i < 4; ++i)
+    {
+        localizer.setHydrophone(i, hydrophonePositions[i][0], hydrophonePositions[i][1], hydrophonePositions[i][2]);
+    }
+    localizer.setTimingAccuracy(1.0f / sampleRate);
 
     // Initialize serial
     SerialLibrary serial(hw);
@@ -158,6 +230,9 @@ int main(void)
         if (serial.CheckCommand("ping"))
         {
             hw.PrintLine("localization for " FLT_FMT3 " Hz starting!! (wait %lu ms)", FLT_VAR3(targetFrequency), listenTimeMs);
+            hw.PrintLine("hydrophone_noise: Mic0 " FLT_FMT3 " / " FLT_FMT3 " Mic1 " FLT_FMT3 " / " FLT_FMT3,
+                         FLT_VAR3(cfar_0.getNoiseLevel()), FLT_VAR3(cfar_0.getThreshold()),
+                         FLT_VAR3(cfar_1.getNoiseLevel()), FLT_VAR3(cfar_1.getThreshold()));
 
             // Variables for ping detection
             int front_counter = 0;
@@ -166,22 +241,29 @@ int main(void)
             uint32_t currentTimeMs = startTimeMs;
             uint32_t mostRecentPingTimeMs = startTimeMs;
             bool canBeMeasured = false;
-            std::uint32_t recievedTimeUs[4] = {0, 0, 0, 0};
+            uint64_t recievedSample[4] = {0, 0, 0, 0};  // SampleClock index of each crossing (0 = not yet)
+            float recievedOffset[4] = {0.0f, 0.0f, 0.0f, 0.0f};  // Sub-sample part of each matched-filter arrival
+            float delay01Samples = 0.0f;                 // Mic1 - Mic0 in samples; sub-sample once GCC-PHAT refines it
+            bool tdoaRefined = false;
+            bool captureTriggered = false;
+            uint64_t captureTriggerSample = 0;
+
+            // Discard crossings and snapshots from before this session started
+            SlidingDFT::CrossingEvent staleCrossing;
+            while (binTracker_0.popEvent(staleCrossing)) {}
+            while (binTracker_1.popEvent(staleCrossing)) {}
+            CaptureRing::Snapshot snapshot;
+            while (capture.acquire(snapshot))
+            {
+                capture.release(snapshot);
+            }
 
             // Localization for 10 seconds
             while (currentTimeMs - startTimeMs <= listenTimeMs)
             {
-                // FFT
-                if (fft_ready_for_processing_0)
-                {
-                    detectedFrequencyLevel_0 = fftLibrary.getFrequencyMagnitude(fft_input_buffer_0, kFftSize, targetFrequency, frequencyTolerance);
-                    fft_ready_for_processing_0 = false;
-                }
-                if (fft_ready_for_processing_1)
-                {
-                    detectedFrequencyLevel_1 = fftLibrary.getFrequencyMagnitude(fft_input_buffer_1, kFftSize, targetFrequency, frequencyTolerance);
-                    fft_ready_for_processing_1 = false;
-                }
+                // Latest band magnitudes from the per-sample trackers
+                detectedFrequencyLevel_0 = binTracker_0.getMagnitude();
+                detectedFrequencyLevel_1 = binTracker_1.getMagnitude();
 
                 // Threshold detection
                 if (detectedFrequencyLevel_0 > hydrophone_0_max)
@@ -196,33 +278,35 @@ int main(void)
                 normalizedDetectedFrequencyLevel_1 = detectedFrequencyLevel_1 / hydrophone_1_max;
                 normalizedDetectedFrequencyLevel_2 = hw.adc.GetFloat(0);
                 normalizedDetectedFrequencyLevel_3 = hw.adc.GetFloat(1);
-                bool isAbove_0 = normalizedDetectedFrequencyLevel_0 >= baseThreshold;
-                bool isAbove_1 = normalizedDetectedFrequencyLevel_1 >= baseThreshold;
                 bool isAbove_2 = normalizedDetectedFrequencyLevel_2 >= baseThreshold;
                 bool isAbove_3 = normalizedDetectedFrequencyLevel_3 >= baseThreshold;
-                if (isAbove_0 && !wasAboveThreshold_0)
+
+                // Master crossings come from the trackers, tagged with the sample that crossed
+                SlidingDFT::CrossingEvent crossing;
+                while (binTracker_0.popEvent(crossing))
                 {
-                    if (canBeMeasured) 
+                    if (canBeMeasured && !useMatchedFilter)
                     {
-                        recievedTimeUs[0] = System::GetUs();
+                        recievedSample[0] = crossing.time.sample();
                     }
                     // hw.PrintLine("Hydrophone 0 recieved");
                     mostRecentPingTimeMs = System::GetNow();
                 }
-                if (isAbove_1 && !wasAboveThreshold_1)
+                while (binTracker_1.popEvent(crossing))
                 {
-                    if (canBeMeasured) 
+                    if (canBeMeasured && !useMatchedFilter)
                     {
-                        recievedTimeUs[1] = System::GetUs();
+                        recievedSample[1] = crossing.time.sample();
                     }
                     //hw.PrintLine("Hydrophone 1 recieved");
                     mostRecentPingTimeMs = System::GetNow();
                 }
+                // The slave levels are polled here, so their crossings get the clock at the poll (block resolution)
                 if (isAbove_2 && !wasAboveThreshold_2)
                 {
                     if (canBeMeasured) 
                     {
-                        recievedTimeUs[2] = System::GetUs();
+                        recievedSample[2] = sampleClock.now();
                     }
                     //hw.PrintLine("Hydrophone 2 recieved");
                     mostRecentPingTimeMs = System::GetNow();
@@ -231,41 +315,139 @@ int main(void)
                 {
                     if (canBeMeasured) 
                     {
-                        recievedTimeUs[3] = System::GetUs();
+                        recievedSample[3] = sampleClock.now();
                     }
                     //hw.PrintLine("Hydrophone 3 recieved");
                     mostRecentPingTimeMs = System::GetNow();
                 }
-                wasAboveThreshold_0 = isAbove_0;
-                wasAboveThreshold_1 = isAbove_1;
                 wasAboveThreshold_2 = isAbove_2;
                 wasAboveThreshold_3 = isAbove_3;
 
-                // Once all the pingers are recieved, we can measure the TDOA
-                if (recievedTimeUs[0] != 0 && recievedTimeUs[1] != 0 && recievedTimeUs[2] != 0 && recievedTimeUs[3] != 0)
+                // Matched-filter peaks mark burst onsets; the first one per channel is the direct path.
+                // Each frame's maximum then updates that channel's noise estimate and threshold.
+                while (pingFrames.readFrame(ping_frame_buffers))
                 {
-                    //hw.PrintLine("Hydrophones received: %lu, %lu, %lu, %lu us", recievedTimeUs[0], recievedTimeUs[1], recievedTimeUs[2], recievedTimeUs[3]);
+                    matchedFilter.process(ping_frame_buffers, pingFrames.getFrameStartSample());
+                    for (size_t i = 0; useMatchedFilter && i < matchedFilter.getNumPeaks(); ++i)
+                    {
+                        const MatchedFilter::Peak& peak = matchedFilter.getPeak(i);
+                        if (canBeMeasured && recievedSample[peak.channel] == 0)
+                        {
+                            recievedSample[peak.channel] = peak.sample;
+                            recievedOffset[peak.channel] = peak.offset;
+                        }
+                        mostRecentPingTimeMs = System::GetNow();
+                    }
+                    matchedCfar_0.process(matchedFilter.getFrameMaximum(0));
+                    matchedCfar_1.process(matchedFilter.getFrameMaximum(1));
+                    matchedFilter.setThreshold(0, matchedCfar_0.getThreshold());
+                    matchedFilter.setThreshold(1, matchedCfar_1.getThreshold());
+                }
+
+                // The first master arrival freezes the raw samples around it (it may already be a little in the past;
+                // the capture keeps going meanwhile)
+                if (!captureTriggered && (recievedSample[0] != 0 || recievedSample[1] != 0))
+                {
+                    captureTriggerSample = recievedSample[0] != 0 ? recievedSample[0] : recievedSample[1];
+                    captureTriggered = capture.trigger(captureTriggerSample);
+                    if (!captureTriggered)
+                    {
+                        // Every slot holds an older snapshot: drop those (nothing waits for them) and retry next pass
+                        while (capture.acquire(snapshot))
+                        {
+                            capture.release(snapshot);
+                        }
+                    }
+                }
+
+                // Once both master arrivals are in and their snapshot is frozen, refine their difference with the
+                // GCC-PHAT delay of the frame that ends half a frame past the later arrival (the arrivals only say
+                // when each detector fired). The tone repeats every period, so only the correlation peak within
+                // half a period of the arrival difference is accepted; without one the difference is kept.
+                if (captureTriggered && !tdoaRefined && recievedSample[0] != 0 && recievedSample[1] != 0 &&
+                    capture.acquire(snapshot))
+                {
+                    const float arrivalDelay = static_cast<float>(SampleClock::difference(recievedSample[0], recievedSample[1])) +
+                                               recievedOffset[1] - recievedOffset[0];
+                    const uint64_t latestCrossing = std::max(recievedSample[0], recievedSample[1]);
+                    const int64_t frameStart = SampleClock::difference(snapshot.firstSample, latestCrossing) -
+                                               (int64_t)(kTdoaFrameSize / 2);
+                    if (snapshot.triggerSample == captureTriggerSample && frameStart >= 0 &&
+                        capture.read(snapshot, 0, (size_t)frameStart, tdoa_buffer_0, kTdoaFrameSize) == kTdoaFrameSize &&
+                        capture.read(snapshot, 1, (size_t)frameStart, tdoa_buffer_1, kTdoaFrameSize) == kTdoaFrameSize &&
+                        tdoa.estimate(tdoa_buffer_0, tdoa_buffer_1, kTdoaFrameSize, arrivalDelay,
+                                      0.5f * sampleRate / targetFrequency) &&
+                        tdoa.getPeak() >= tdoaMinimumPeak)
+                    {
+                        // The sample index only keeps the whole-sample part; the ordering below uses the fraction too
+                        delay01Samples = tdoa.getDelaySamples();
+                        recievedSample[1] = recievedSample[0] + static_cast<int64_t>(lrintf(delay01Samples));
+                    }
+                    else
+                    {
+                        delay01Samples = arrivalDelay;
+                    }
+                    capture.release(snapshot);
+                    tdoaRefined = snapshot.triggerSample == captureTriggerSample;
+                }
+
+                // Once all the pingers are recieved (and the master pair refined), we can measure the TDOA
+                if (recievedSample[0] != 0 && recievedSample[1] != 0 && recievedSample[2] != 0 && recievedSample[3] != 0 &&
+                    tdoaRefined)
+                {
+                    //hw.PrintLine("Hydrophones received (after Mic0): %ld, %ld, %ld us",
+                    //             static_cast<long>(sampleClock.toMicroseconds(SampleClock::difference(recievedSample[0], recievedSample[1]))),
+                    //             static_cast<long>(sampleClock.toMicroseconds(SampleClock::difference(recievedSample[0], recievedSample[2]))),
+                    //             static_cast<long>(sampleClock.toMicroseconds(SampleClock::difference(recievedSample[0], recievedSample[3]))));
                     // Make sure the largest time difference is less than the within threshold
-                    uint32_t latest = recievedTimeUs[0];
-                    uint32_t earliest = recievedTimeUs[0];
+                    uint64_t latest = recievedSample[0];
+                    uint64_t earliest = recievedSample[0];
                     for (int i = 1; i < 4; ++i)
                     {
-                        if (recievedTimeUs[i] > latest)   { latest = recievedTimeUs[i]; }
-                        if (recievedTimeUs[i] < earliest) { earliest = recievedTimeUs[i]; }
+                        if (recievedSample[i] > latest)   { latest = recievedSample[i]; }
+                        if (recievedSample[i] < earliest) { earliest = recievedSample[i]; }
                     }
-                    if (latest - earliest < withinThresholdUs)
+                    if (sampleClock.toMicroseconds(SampleClock::difference(earliest, latest)) < withinThresholdUs)
                     {
                         // hw.PrintLine("Measurement is valid");
+                        // Arrival times after Mic0 (samples) with the matched-filter fractions, and the refined
+                        // sub-sample delay for Mic1
+                        float arrival[4];
+                        for (int i = 0; i < 4; ++i)
+                        {
+                            arrival[i] = static_cast<float>(SampleClock::difference(recievedSample[0], recievedSample[i])) +
+                                         recievedOffset[i] - recievedOffset[0];
+                        }
+                        arrival[1] = delay01Samples;
+
+                        // Bearing from the delays after Mic0 (Mic1's keeps the GCC-PHAT fraction); the slave times are
+                        // polled, so expect a larger spread
+                        float delays[4];
+                        for (int i = 0; i < 4; ++i)
+                        {
+                            delays[i] = arrival[i] / sampleRate;
+                        }
+                        if (localizer.solveBearing(delays))
+                        {
+                            const float degrees = 180.0f / 3.14159265f;
+                            hw.PrintLine("hydrophone_bearing: azimuth " FLT_FMT3 " deg elevation " FLT_FMT3 " deg (+/- " FLT_FMT3
+                                         " / " FLT_FMT3 ") rms " FLT_FMT3 " us",
+                                         FLT_VAR3(localizer.getAzimuth() * degrees), FLT_VAR3(localizer.getElevation() * degrees),
+                                         FLT_VAR3(std::min(localizer.getAzimuthStd() * degrees, 999.0f)),
+                                         FLT_VAR3(std::min(localizer.getElevationStd() * degrees, 999.0f)),
+                                         FLT_VAR3(localizer.getRmsResidual() * 1e6f));
+                        }
+
                         // Find indices of two smallest values using std::min
                         int smallest_idx = 0;
                         for (int i = 1; i < 4; i++) {
-                            if (recievedTimeUs[i] < recievedTimeUs[smallest_idx]) {
+                            if (arrival[i] < arrival[smallest_idx]) {
                                 smallest_idx = i;
                             }
                         }
                         int second_smallest_idx = (smallest_idx == 0) ? 1 : 0;
                         for (int i = 0; i < 4; i++) {
-                            if (i != smallest_idx && recievedTimeUs[i] < recievedTimeUs[second_smallest_idx]) {
+                            if (i != smallest_idx && arrival[i] < arrival[second_smallest_idx]) {
                                 second_smallest_idx = i;
                             }
                         }
@@ -293,10 +475,17 @@ int main(void)
                         }
                     }
                     // Reset the recieved time
-                    recievedTimeUs[0] = 0;
-                    recievedTimeUs[1] = 0;
-                    recievedTimeUs[2] = 0;
-                    recievedTimeUs[3] = 0;
+                    recievedSample[0] = 0;
+                    recievedSample[1] = 0;
+                    recievedSample[2] = 0;
+                    recievedSample[3] = 0;
+                    recievedOffset[0] = 0.0f;
+                    recievedOffset[1] = 0.0f;
+                    recievedOffset[2] = 0.0f;
+                    recievedOffset[3] = 0.0f;
+                    delay01Samples = 0.0f;
+                    tdoaRefined = false;
+                    captureTriggered = false;
                     canBeMeasured = false;
                 }
 
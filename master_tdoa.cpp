@@ -1,6 +1,10 @@
 #include "daisy_seed.h"
 #include "daisysp.h"
+#include "library/cfar_detector.h"
 #include "library/fft_library.h"
+#include "library/gcc_phat.h"
+#include "library/sample_clock.h"
+#include "library/streaming_stft.h"
 #include "library/serial_library.h"
 
 using namespace daisy;
@@ -34,6 +38,7 @@ const float hydrophone_1_max = 12.0f;
 // FFT
 constexpr size_t kFftSize = 1024;             // Higher = better frequency resolution
 constexpr size_t kBlockSize = 64;             // Block size for audio processing
+constexpr size_t kFftHop = kFftSize / 4; // New spectrum every hop (frames overlap by kFftSize - kFftHop)
 
 // RMS
 const float multiplier = 100;                  // Amplification of signal (per sample)
@@ -41,7 +46,21 @@ const float multiplier = 100;                  // Amplification of signal (per s
 // Frequency Detection
 const float targetFrequency = 1760.0f;        // Target frequency to detect
 const float frequencyTolerance = 0.01f;       // Tolerance for frequency detection
-const float baseThreshold = 0.5f;             // Base threshold for frequency detection
+const float baseThreshold = 0.5f;             // Threshold for the slave channels (normalized ADC levels)
+
+// CFAR detection (master channels): threshold adapts to the measured noise floor
+const CfarDetector::Mode cfarMode = CfarDetector::Mode::OrderedStatistic;
+const float cfarFalseAlarmProbability = 1e-4f;  // Per frame (one frame every kFftHop samples)
+constexpr size_t kCfarGuardBins = 2;            // Bins skipped on each side of the band (Hann main lobe)
+constexpr size_t kCfarReferenceBins = 8;        // Noise reference bins on each side of the band
+constexpr size_t kCfarHistoryFrames = 32;       // Past frames without a detection in the noise estimate
+const float minimumThreshold = 0.05f;           // Floor for the CFAR threshold (normalized), for near-silence
+constexpr int kNoisePrintIntervalMs = 1000;     // Noise floor telemetry interval
+
+// TDOA between the two master hydrophones: GCC-PHAT on the frames of the level detection
+const float hydrophoneSpacing = 0.5f;           // Metres between mic 0 and mic 1; bounds the delay search
+const float tdoaWeighting = 0.7f;               // PHAT-beta exponent (1 = pure phase transform)
+const float tdoaMinimumPeak = 0.1f;             // Correlation peak (0 ~ 1) below which no TDOA is printed
 
 ////////////////////////////// Internal Variables for Master (DO NOT CHANGE) ///////////////////////////////////
 // Hardware
@@ -53,10 +72,25 @@ FFTLibrary fftLibrary(96000.f);
 // FFT buffers for both microphones (MASTER)
 static float DSY_SDRAM_BSS fft_input_buffer_0[kFftSize];
 static float DSY_SDRAM_BSS fft_input_buffer_1[kFftSize];
-static size_t buffer_write_pos_0 = 0;
-static size_t buffer_write_pos_1 = 0;
-static bool fft_ready_for_processing_0 = false;
-static bool fft_ready_for_processing_1 = false;
+static float* const fft_frame_buffers[2] = {fft_input_buffer_0, fft_input_buffer_1};
+
+// Overlapped framing: the callback feeds every sample, a frame completes every kFftHop samples
+StreamingSTFT stft(2, kFftSize, kFftHop);
+
+// Sample-index time base, advanced once per audio block; frame positions in stft are its samples
+SampleClock sampleClock(96000.f);
+uint64_t frameEndSample = 0;    // Clock sample one past the frame behind the latest CFAR decisions
+
+// One transform per channel per frame, shared by the level and the CFAR test
+static SpectrumFrame spectrumFrame_0;
+static SpectrumFrame spectrumFrame_1;
+CfarDetector cfar_0(cfarMode, cfarFalseAlarmProbability, kCfarGuardBins, kCfarReferenceBins, kCfarHistoryFrames);
+CfarDetector cfar_1(cfarMode, cfarFalseAlarmProbability, kCfarGuardBins, kCfarReferenceBins, kCfarHistoryFrames);
+uint32_t lastNoisePrintTime = 0;
+
+// Sub-sample delay of mic 1 behind mic 0, estimated once per detection
+GccPhat tdoa(96000.f, kFftSize, GccPhat::maxDelayForSpacing(hydrophoneSpacing));
+bool tdoaReported = false;
 
 // Frequency window (derived)
 const float lowerFreq = targetFrequency * (1.0f - frequencyTolerance);
@@ -73,8 +107,8 @@ float normalizedDetectedFrequencyLevel_1 = 0.0f;
 float normalizedDetectedFrequencyLevel_2 = 0.0f;
 float normalizedDetectedFrequencyLevel_3 = 0.0f;
 
-// Threshold crossing state and start time (us)
-uint32_t startTimeUs = 0;
+// Threshold crossing state and start time (clock samples)
+uint64_t startSample = 0;
 bool wasAboveThreshold_0 = false;
 bool wasAboveThreshold_1 = false;
 bool wasAboveThreshold_2 = false;
@@ -84,6 +118,7 @@ bool wasAboveThreshold_3 = false;
 ////////////////////////////////////////// Setup and Loop //////////////////////////////////////////
 
 void MyCallback(AudioHandle::InputBuffer in, AudioHandle::OutputBuffer out, size_t size) {
+    sampleClock.beginBlock(size);
     for (size_t i = 0; i < size; i++)
     {
         float sample_0 = in[0][i];
@@ -93,30 +128,9 @@ void MyCallback(AudioHandle::InputBuffer in, AudioHandle::OutputBuffer out, size
         float processedSample_0 = sample_0 * multiplier;  
         float processedSample_1 = sample_1 * multiplier;
 
-        // Fill the FFT buffers if ready for more data
-        if (!fft_ready_for_processing_0)
-        {
-            fft_input_buffer_0[buffer_write_pos_0] = processedSample_0;
-            buffer_write_pos_0++;
-
-            if (buffer_write_pos_0 >= kFftSize)
-            {
-                buffer_write_pos_0 = 0;
-                fft_ready_for_processing_0 = true;
-            }
-        }
-
-        if (!fft_ready_for_processing_1)
-        {
-            fft_input_buffer_1[buffer_write_pos_1] = processedSample_1;
-            buffer_write_pos_1++;
-
-            if (buffer_write_pos_1 >= kFftSize)
-            {
-                buffer_write_pos_1 = 0;
-                fft_ready_for_processing_1 = true;
-            }
-        }
+        // Feed the overlapped STFT history (never paused while the main loop processes a frame)
+        const float processedSamples[2] = {processedSample_0, processedSample_1};
+        stft.push(processedSamples);
     }
 }
 
@@ -128,7 +142,17 @@ int main(void)
     hw.SetAudioBlockSize(kBlockSize);
 
     // Initialize the FFT library with the actual sample rate
-    fftLibrary = FFTLibrary(hw.AudioSampleRate());
+    fftLibrary = FFTLibrary(hw.AudioSampleRate(), kFftSize);
+    sampleClock = SampleClock(hw.AudioSampleRate());
+
+    // CFAR thresholds never drop below the configured floor (raw magnitude units)
+    cfar_0.setMinimumThreshold(minimumThreshold * hydrophone_0_max);
+    cfar_1.setMinimumThreshold(minimumThreshold * hydrophone_1_max);
+
+    // The TDOA search covers only the delays the hydrophone spacing allows
+    tdoa = GccPhat(hw.AudioSampleRate(), kFftSize, GccPhat::maxDelayForSpacing(hydrophoneSpacing));
+    tdoa.setRefinement(GccPhat::Refinement::Sinc);
+    tdoa.setWeighting(tdoaWeighting);
 
     // Initialize serial
     SerialLibrary serial(hw);
@@ -138,9 +162,17 @@ int main(void)
     hw.StartAudio(MyCallback);
 
     hw.PrintLine("TDOA Frequency Detection Ready");
+    if (!fftLibrary.isValid())
+    {
+        hw.PrintLine("Error: FFT window tables did not fit in the window cache");
+    }
+    if (0.5f * hw.AudioSampleRate() / targetFrequency < static_cast<float>(tdoa.getMaxLag()))
+    {
+        hw.PrintLine("Warning: hydrophone spacing exceeds half a wavelength, tone TDOA may be off by whole periods");
+    }
 
     // Get timestamp
-    startTimeUs = System::GetUs();
+    startSample = sampleClock.now();
 
     // Initialize ADC on A0 and A1 for slave hydrophones
     AdcChannelConfig adc_cfg[2];
@@ -151,17 +183,37 @@ int main(void)
 
     while (1)
     {
-        // Update latest magnitudes when FFT buffers are ready
-        if (fft_ready_for_processing_0)
-        {
-            detectedFrequencyLevel_0 = fftLibrary.getFrequencyMagnitude(fft_input_buffer_0, kFftSize, targetFrequency, frequencyTolerance);
-            fft_ready_for_processing_0 = false;
-        }
-
-        if (fft_ready_for_processing_1)
+        // Update latest magnitudes and CFAR decisions when a new overlapped frame is ready (every kFftHop samples).
+        // The CFAR needs the bins around the band as well, so each channel gets one full transform.
+        if (stft.readFrame(fft_frame_buffers))
         {
-            detectedFrequencyLevel_1 = fftLibrary.getFrequencyMagnitude(fft_input_buffer_1, kFftSize, targetFrequency, frequencyTolerance);
-            fft_ready_for_processing_1 = false;
+            frameEndSample = stft.getFrameEndSample();
+            fftLibrary.computeFrame(fft_input_buffer_0, kFftSize, spectrumFrame_0);
+            fftLibrary.computeFrame(fft_input_buffer_1, kFftSize, spectrumFrame_1);
+            detectedFrequencyLevel_0 = spectrumFrame_0.getFrequencyMagnitude(targetFrequency, frequencyTolerance);
+            detectedFrequencyLevel_1 = spectrumFrame_1.getFrequencyMagnitude(targetFrequency, frequencyTolerance);
+            cfar_0.process(spectrumFrame_0, targetFrequency, frequencyTolerance);
+            cfar_1.process(spectrumFrame_1, targetFrequency, frequencyTolerance);
+
+            // First frame in which both master channels detect: cross-correlate the same spectra.
+            // Unlike the crossing times below, this is not quantised to the hop or the loop timing.
+            // Both channels detect in the same frame, so there is no finer coarse delay to gate on: a steady
+            // tone is only resolved to a whole period when the spacing is under half a wavelength (see the
+            // startup warning); master_ping gates on its matched-filter arrivals instead.
+            if (cfar_0.isDetected() && cfar_1.isDetected())
+            {
+                if (!tdoaReported && tdoa.estimate(spectrumFrame_0, spectrumFrame_1) &&
+                    tdoa.getPeak() >= tdoaMinimumPeak)
+                {
+                    hw.PrintLine("hydrophone_tdoa: Mic1 - Mic0 " FLT_FMT3 " us (peak " FLT_FMT3 ")",
+                                 FLT_VAR3(tdoa.getDelay() * 1e6f), FLT_VAR3(tdoa.getPeak()));
+                }
+                tdoaReported = true;
+            }
+            else if (!cfar_0.isDetected() && !cfar_1.isDetected())
+            {
+                tdoaReported = false;
+            }
         }
 
         // clip the detected frequency levels
@@ -182,36 +234,51 @@ int main(void)
         normalizedDetectedFrequencyLevel_2 = hw.adc.GetFloat(0);
         normalizedDetectedFrequencyLevel_3 = hw.adc.GetFloat(1);
 
-        // Event-based print on threshold crossing (microseconds since start)
-        bool isAbove_0 = normalizedDetectedFrequencyLevel_0 >= baseThreshold;
-        bool isAbove_1 = normalizedDetectedFrequencyLevel_1 >= baseThreshold;
+        // Event-based print on threshold crossing (microseconds since start). Master crossings are timed by the
+        // end of the frame that detected them (hop resolution); the polled slave levels by the clock at the poll.
+        bool isAbove_0 = cfar_0.isDetected();
+        bool isAbove_1 = cfar_1.isDetected();
         bool isAbove_2 = normalizedDetectedFrequencyLevel_2 >= baseThreshold;
         bool isAbove_3 = normalizedDetectedFrequencyLevel_3 >= baseThreshold;
 
         if (isAbove_0 && !wasAboveThreshold_0)
         {
-            uint32_t t = System::GetUs() - startTimeUs;
-            hw.PrintLine("hydrophone_log: Mic0 reads %lu", static_cast<unsigned long>(t));
+            char t[24];
+            SampleClock::formatMicroseconds(sampleClock.toMicroseconds(SampleClock::difference(startSample, frameEndSample)), t, sizeof(t));
+            hw.PrintLine("hydrophone_log: Mic0 reads %s", t);
         }
         if (isAbove_1 && !wasAboveThreshold_1)
         {
-            uint32_t t = System::GetUs() - startTimeUs;
-            hw.PrintLine("hydrophone_log: Mic1 reads %lu", static_cast<unsigned long>(t));
+            char t[24];
+            SampleClock::formatMicroseconds(sampleClock.toMicroseconds(SampleClock::difference(startSample, frameEndSample)), t, sizeof(t));
+            hw.PrintLine("hydrophone_log: Mic1 reads %s", t);
         }
         if (isAbove_2 && !wasAboveThreshold_2)
         {
-            uint32_t t = System::GetUs() - startTimeUs;
-            hw.PrintLine("hydrophone_log: Mic2 reads %lu", static_cast<unsigned long>(t));
+            char t[24];
+            SampleClock::formatMicroseconds(sampleClock.toMicroseconds(SampleClock::difference(startSample, sampleClock.now())), t, sizeof(t));
+            hw.PrintLine("hydrophone_log: Mic2 reads %s", t);
         }
         if (isAbove_3 && !wasAboveThreshold_3)
         {
-            uint32_t t = System::GetUs() - startTimeUs;
-            hw.PrintLine("hydrophone_log: Mic3 reads %lu", static_cast<unsigned long>(t));
+            char t[24];
+            SampleClock::formatMicroseconds(sampleClock.toMicroseconds(SampleClock::difference(startSample, sampleClock.now())), t, sizeof(t));
+            hw.PrintLine("hydrophone_log: Mic3 reads %s", t);
         }
 
         wasAboveThreshold_0 = isAbove_0;
         wasAboveThreshold_1 = isAbove_1;
         wasAboveThreshold_2 = isAbove_2;
         wasAboveThreshold_3 = isAbove_3;
+
+        // Noise floor telemetry (raw band units) for tuning and run-to-run comparison
+        uint32_t currentTimeMs = System::GetNow();
+        if (currentTimeMs - lastNoisePrintTime >= kNoisePrintIntervalMs)
+        {
+            hw.PrintLine("hydrophone_noise: Mic0 " FLT_FMT3 " / " FLT_FMT3 " Mic1 " FLT_FMT3 " / " FLT_FMT3,
+                         FLT_VAR3(cfar_0.getNoiseLevel()), FLT_VAR3(cfar_0.getThreshold()),
+                         FLT_VAR3(cfar_1.getNoiseLevel()), FLT_VAR3(cfar_1.getThreshold()));
+            lastNoisePrintTime = currentTimeMs;
+        }
     }
 } 
\ No newline at end of file
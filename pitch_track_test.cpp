@@ -1,6 +1,7 @@
 #include "daisy_seed.h"
 #include "daisysp.h"
-#include "library/fft_library.h"
+#include "library/chirp_z.h"
+#include "library/fixed_fft.h"
 #include <string>
 #include <cmath>
 #include <vector>
@@ -27,14 +28,20 @@ const float multiplier = 10000;
 // Pitch tracking
 float detectedPitch = 0.0f;
 
+// Fine pitch search (chirp-Z) over the region of interest, 25 Hz steps instead of ~47 Hz FFT bins
+constexpr float kFinePitchLow = 20000.0f;
+constexpr float kFinePitchHigh = 45000.0f;
+constexpr size_t kFinePitchBins = 1001;
+
 // Sampling rate
 uint32_t total_samples;
 uint32_t cur_sample_rate;
 uint32_t cur_time_ms;
 uint32_t prev_time_ms;
 
-// Global FFT library object
-FFTLibrary fftLibrary(96000.f); // Initialize with default, will be updated
+// Global FFT object (tables are compile-time constants for kFftSize)
+FixedFFT<kFftSize> fftLibrary(96000.f); // Initialize with default, will be updated
+ChirpZTransform finePitch; // built once the sample rate is known
 
 ////////////////////////////////////////// Setup and Loop //////////////////////////////////////////
 
@@ -84,8 +91,9 @@ int main(void)
     hw.SetAudioSampleRate(SaiHandle::Config::SampleRate::SAI_96KHZ);
     hw.SetAudioBlockSize(kBlockSize);
 
-    // Initialize the FFT library with the actual sample rate
-    fftLibrary = FFTLibrary(hw.AudioSampleRate());
+    // Update the FFT with the actual sample rate
+    fftLibrary.setSampleRate(hw.AudioSampleRate());
+    finePitch.init(hw.AudioSampleRate(), kFftSize, kFinePitchLow, kFinePitchHigh, kFinePitchBins);
 
 	// Start program
     hw.StartLog(true);
@@ -100,7 +108,13 @@ int main(void)
         // If the buffer is full, process the FFT.
         if (fft_ready_for_processing)
         {
-            detectedPitch = fftLibrary.detectPitch(fft_input_buffer, kFftSize);
+            detectedPitch = fftLibrary.detectPitch(fft_input_buffer);
+
+            // Refine on the fine grid when the coarse peak is in the region of interest
+            if (detectedPitch >= kFinePitchLow && detectedPitch <= kFinePitchHigh)
+            {
+                detectedPitch = finePitch.detectPitch(fft_input_buffer, kFftSize);
+            }
             fft_ready_for_processing = false;
         }
 
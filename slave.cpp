@@ -1,6 +1,7 @@
 #include "daisy_seed.h"
 #include "daisysp.h"
 #include "library/fft_library.h"
+#include "library/streaming_stft.h"
 #include "library/serial_library.h"
 
 using namespace daisy;
@@ -33,6 +34,7 @@ const float hydrophone_3_max = 4.0f;
 // FFT
 constexpr size_t kFftSize = 64;             // Higher = better frequency resolution
 constexpr size_t kBlockSize = 64;             // Block size for audio processing
+constexpr size_t kFftHop = kFftSize / 4; // New spectrum every hop (frames overlap by kFftSize - kFftHop)
 
 // RMS
 const float multiplier = 100;                  // Amplification of signal (per sample)
@@ -51,10 +53,11 @@ FFTLibrary fftLibrary(96000.f);
 // FFT buffers for both microphones (SLAVE channels 2 and 3)
 static float DSY_SDRAM_BSS fft_input_buffer_2[kFftSize];
 static float DSY_SDRAM_BSS fft_input_buffer_3[kFftSize];
-static size_t buffer_write_pos_2 = 0;
-static size_t buffer_write_pos_3 = 0;
-static bool fft_ready_for_processing_2 = false;
-static bool fft_ready_for_processing_3 = false;
+static const float* const fft_input_buffers[2] = {fft_input_buffer_2, fft_input_buffer_3};
+static float* const fft_frame_buffers[2] = {fft_input_buffer_2, fft_input_buffer_3};
+
+// Overlapped framing: the callback feeds every sample, a frame completes every kFftHop samples
+StreamingSTFT stft(2, kFftSize, kFftHop);
 
 // Frequency window (derived)
 const float lowerFreq = targetFrequency * (1.0f - frequencyTolerance);
@@ -84,30 +87,9 @@ void MyCallback(AudioHandle::InputBuffer in, AudioHandle::OutputBuffer out, size
         float processedSample_2 = sample_2 * multiplier;  
         float processedSample_3 = sample_3 * multiplier;
 
-        // Fill the FFT buffers if ready for more data
-        if (!fft_ready_for_processing_2)
-        {
-            fft_input_buffer_2[buffer_write_pos_2] = processedSample_2;
-            buffer_write_pos_2++;
-
-            if (buffer_write_pos_2 >= kFftSize)
-            {
-                buffer_write_pos_2 = 0;
-                fft_ready_for_processing_2 = true;
-            }
-        }
-
-        if (!fft_ready_for_processing_3)
-        {
-            fft_input_buffer_3[buffer_write_pos_3] = processedSample_3;
-            buffer_write_pos_3++;
-
-            if (buffer_write_pos_3 >= kFftSize)
-            {
-                buffer_write_pos_3 = 0;
-                fft_ready_for_processing_3 = true;
-            }
-        }
+        // Feed the overlapped STFT history (never paused while the main loop processes a frame)
+        const float processedSamples[2] = {processedSample_2, processedSample_3};
+        stft.push(processedSamples);
     }
 }
 
@@ -119,7 +101,10 @@ int main(void)
     hw.SetAudioBlockSize(kBlockSize);
 
     // Initialize the FFT library with the actual sample rate
-    fftLibrary = FFTLibrary(hw.AudioSampleRate());
+    fftLibrary = FFTLibrary(hw.AudioSampleRate(), kFftSize);
+
+    // The +/-frequencyTolerance band spans only a few bins, so evaluate just those bins (Goertzel)
+    fftLibrary.setMagnitudeBackend(FFTLibrary::MagnitudeBackend::Goertzel);
 
     // // Initialize serial
     // SerialLibrary serial(hw);
@@ -143,17 +128,14 @@ int main(void)
 
     while (1)
     {
-        // Update latest magnitudes when FFT buffers are ready
-        if (fft_ready_for_processing_2)
-        {
-            detectedFrequencyLevel_2 = fftLibrary.getFrequencyMagnitude(fft_input_buffer_2, kFftSize, targetFrequency, frequencyTolerance);
-            fft_ready_for_processing_2 = false;
-        }
-
-        if (fft_ready_for_processing_3)
+        // Update latest magnitudes when a new overlapped frame is ready (every kFftHop samples)
+        // Both channels share the frame timing, so process them together in one batched call
+        if (stft.readFrame(fft_frame_buffers))
         {
-            detectedFrequencyLevel_3 = fftLibrary.getFrequencyMagnitude(fft_input_buffer_3, kFftSize, targetFrequency, frequencyTolerance);
-            fft_ready_for_processing_3 = false;
+            float levels[2];
+            fftLibrary.getFrequencyMagnitudes(fft_input_buffers, 2, kFftSize, targetFrequency, frequencyTolerance, levels);
+            detectedFrequencyLevel_2 = levels[0];
+            detectedFrequencyLevel_3 = levels[1];
         }
         
         // clip the detected frequency levels
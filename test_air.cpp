@@ -1,6 +1,7 @@
 #include "daisy_seed.h"
 #include "daisysp.h"
 #include "library/fft_library.h"
+#include "library/sample_clock.h"
 #include "library/serial_library.h"
 #include <string>
 #include <cmath>
@@ -47,10 +48,16 @@ DaisySeed hw;
 // FFT buffers for both microphones
 static float DSY_SDRAM_BSS fft_input_buffer_0[kFftSize];
 static float DSY_SDRAM_BSS fft_input_buffer_1[kFftSize];
+static std::complex<float> DTCM_MEM_SECTION fft_workspace[FFTLibrary::workspaceSize(kFftSize)];
 static size_t buffer_write_pos_0 = 0;
 static size_t buffer_write_pos_1 = 0;
 static bool fft_ready_for_processing_0 = false;
 static bool fft_ready_for_processing_1 = false;
+static SampleClock::Timestamp buffer_end_0 = {0, 0};  // Last sample of each completed buffer
+static SampleClock::Timestamp buffer_end_1 = {0, 0};
+
+// Sample-index time base, advanced once per audio block
+SampleClock sampleClock(96000.f);
 
 // Frequency detection
 float detectedFrequencyLevel_0 = 0.0f;
@@ -63,9 +70,9 @@ bool waiting_for_start = true;
 bool frequency_detected_0 = false;
 bool frequency_detected_1 = false;
 bool first_buffer_after_start = true;
-unsigned long start_time_us = 0;
-unsigned long detection_time_0_us = 0;
-unsigned long detection_time_1_us = 0;
+uint64_t start_sample = 0;
+uint64_t detection_sample_0 = 0;
+uint64_t detection_sample_1 = 0;
 
 // Timing for printing
 uint32_t lastPrintTime = 0;
@@ -76,6 +83,7 @@ FFTLibrary fftLibrary(96000.f);
 ////////////////////////////////////////// Setup and Loop //////////////////////////////////////////
 
 void MyCallback(AudioHandle::InputBuffer in, AudioHandle::OutputBuffer out, size_t size) {
+    sampleClock.beginBlock(size);
     for (size_t i = 0; i < size; i++)
     {
         float sample_0 = in[0][i];
@@ -94,6 +102,7 @@ void MyCallback(AudioHandle::InputBuffer in, AudioHandle::OutputBuffer out, size
             if (buffer_write_pos_0 >= kFftSize)
             {
                 buffer_write_pos_0 = 0;
+                buffer_end_0 = sampleClock.stamp(i);
                 fft_ready_for_processing_0 = true;
             }
         }
@@ -106,6 +115,7 @@ void MyCallback(AudioHandle::InputBuffer in, AudioHandle::OutputBuffer out, size
             if (buffer_write_pos_1 >= kFftSize)
             {
                 buffer_write_pos_1 = 0;
+                buffer_end_1 = sampleClock.stamp(i);
                 fft_ready_for_processing_1 = true;
             }
         }
@@ -120,7 +130,8 @@ int main(void)
     hw.SetAudioBlockSize(kBlockSize);
 
     // Initialize the FFT library with the actual sample rate
-    fftLibrary = FFTLibrary(hw.AudioSampleRate());
+    fftLibrary = FFTLibrary(hw.AudioSampleRate(), kFftSize);
+    sampleClock = SampleClock(hw.AudioSampleRate());
 
     // Initialize serial communication
     SerialLibrary serial(hw);
@@ -130,6 +141,10 @@ int main(void)
     hw.StartAudio(MyCallback);
 
     hw.PrintLine("TDOA Frequency Detection Ready");
+    if (!fftLibrary.isValid())
+    {
+        hw.PrintLine("Error: FFT window tables did not fit in the window cache");
+    }
     hw.PrintLine("Type 'start' to begin detection...");
 
     // Get timestamp
@@ -143,7 +158,7 @@ int main(void)
             if (serial.CheckCommand("start"))
             {
                                  waiting_for_start = false;
-                 start_time_us = System::GetUs();
+                 start_sample = sampleClock.now();
                  frequency_detected_0 = false;
                  frequency_detected_1 = false;
                  first_buffer_after_start = true;
@@ -163,7 +178,9 @@ int main(void)
                  // Wait a moment to ensure we start with fresh data
                  System::Delay(10);
                  
-                 hw.PrintLine("Starting TDOA detection... (start_time: %lu)", start_time_us);
+                 char start_text[24];
+                 SampleClock::formatMicroseconds(sampleClock.toMicroseconds((int64_t)start_sample), start_text, sizeof(start_text));
+                 hw.PrintLine("Starting TDOA detection... (start_time: %s)", start_text);
             }
             else
             {
@@ -174,13 +191,13 @@ int main(void)
                     // Process FFT for both microphones to get current levels
                     if (fft_ready_for_processing_0)
                     {
-                        detectedFrequencyLevel_0 = fftLibrary.getFrequencyMagnitude(fft_input_buffer_0, kFftSize, targetFrequency, frequencyTolerance);
+                        detectedFrequencyLevel_0 = fftLibrary.getFrequencyMagnitude(fft_input_buffer_0, kFftSize, targetFrequency, frequencyTolerance, fft_workspace, FFTLibrary::workspaceSize(kFftSize));
                         fft_ready_for_processing_0 = false;
                     }
                     
                     if (fft_ready_for_processing_1)
                     {
-                        detectedFrequencyLevel_1 = fftLibrary.getFrequencyMagnitude(fft_input_buffer_1, kFftSize, targetFrequency, frequencyTolerance);
+                        detectedFrequencyLevel_1 = fftLibrary.getFrequencyMagnitude(fft_input_buffer_1, kFftSize, targetFrequency, frequencyTolerance, fft_workspace, FFTLibrary::workspaceSize(kFftSize));
                         fft_ready_for_processing_1 = false;
                     }
                     
@@ -202,21 +219,16 @@ int main(void)
                  continue;
             }
              
-            detectedFrequencyLevel_0 = fftLibrary.getFrequencyMagnitude(fft_input_buffer_0, kFftSize, targetFrequency, frequencyTolerance);
+            detectedFrequencyLevel_0 = fftLibrary.getFrequencyMagnitude(fft_input_buffer_0, kFftSize, targetFrequency, frequencyTolerance, fft_workspace, FFTLibrary::workspaceSize(kFftSize));
              
             if (detectedFrequencyLevel_0 > baseThreshold)
             {
                 frequency_detected_0 = true;
-                detection_time_0_us = System::GetUs();
-                // Handle potential timer overflow
-                unsigned long time_diff;
-                if (detection_time_0_us >= start_time_us) {
-                    time_diff = detection_time_0_us - start_time_us;
-                } else {
-                    // Timer overflow occurred
-                    time_diff = (0xFFFFFFFF - start_time_us) + detection_time_0_us + 1;
-                }
-                hw.PrintLine("Frequency detected on mic 0 at %lu μs (level: " FLT_FMT3 ") [start:%lu, detect:%lu]", time_diff, FLT_VAR3(detectedFrequencyLevel_0), start_time_us, detection_time_0_us);
+                // Timed by the last sample of the buffer, not by when the loop got to it
+                detection_sample_0 = buffer_end_0.sample();
+                char time_diff[24];
+                SampleClock::formatMicroseconds(sampleClock.toMicroseconds(SampleClock::difference(start_sample, detection_sample_0)), time_diff, sizeof(time_diff));
+                hw.PrintLine("Frequency detected on mic 0 at %s μs (level: " FLT_FMT3 ")", time_diff, FLT_VAR3(detectedFrequencyLevel_0));
             }
              
             fft_ready_for_processing_0 = false;
@@ -231,21 +243,16 @@ int main(void)
                  continue;
              }
              
-             detectedFrequencyLevel_1 = fftLibrary.getFrequencyMagnitude(fft_input_buffer_1, kFftSize, targetFrequency, frequencyTolerance);
+             detectedFrequencyLevel_1 = fftLibrary.getFrequencyMagnitude(fft_input_buffer_1, kFftSize, targetFrequency, frequencyTolerance, fft_workspace, FFTLibrary::workspaceSize(kFftSize));
              
             if (detectedFrequencyLevel_1 > baseThreshold)
               {
                   frequency_detected_1 = true;
-                  detection_time_1_us = System::GetUs();
-                  // Handle potential timer overflow
-                  unsigned long time_diff;
-                  if (detection_time_1_us >= start_time_us) {
-                      time_diff = detection_time_1_us - start_time_us;
-                  } else {
-                      // Timer overflow occurred
-                      time_diff = (0xFFFFFFFF - start_time_us) + detection_time_1_us + 1;
-                  }
-                  hw.PrintLine("Frequency detected on mic 1 at %lu μs (level: " FLT_FMT3 ") [start:%lu, detect:%lu]", time_diff, FLT_VAR3(detectedFrequencyLevel_1), start_time_us, detection_time_1_us);
+                  // Timed by the last sample of the buffer, not by when the loop got to it
+                  detection_sample_1 = buffer_end_1.sample();
+                  char time_diff[24];
+                  SampleClock::formatMicroseconds(sampleClock.toMicroseconds(SampleClock::difference(start_sample, detection_sample_1)), time_diff, sizeof(time_diff));
+                  hw.PrintLine("Frequency detected on mic 1 at %s μs (level: " FLT_FMT3 ")", time_diff, FLT_VAR3(detectedFrequencyLevel_1));
               }
              
              fft_ready_for_processing_1 = false;
@@ -254,16 +261,12 @@ int main(void)
         // If both microphones detected the frequency, calculate TDOA
         if (frequency_detected_0 && frequency_detected_1)
         {
-            // Calculate TDOA as absolute difference between detection times
-            unsigned long time_diff_us;
-            if (detection_time_1_us >= detection_time_0_us) {
-                time_diff_us = detection_time_1_us - detection_time_0_us;
-            } else {
-                time_diff_us = detection_time_0_us - detection_time_1_us;
-            }
+            // Calculate TDOA as the absolute sample difference between detections, in microseconds
+            int64_t time_diff_samples = SampleClock::difference(detection_sample_0, detection_sample_1);
+            unsigned long time_diff_us = static_cast<unsigned long>(sampleClock.toMicroseconds(time_diff_samples < 0 ? -time_diff_samples : time_diff_samples));
             
             // Determine which microphone detected first
-            if (detection_time_1_us < detection_time_0_us) {
+            if (detection_sample_1 < detection_sample_0) {
                 hw.PrintLine("TDOA: %lu μs (Mic 1 detected first)", time_diff_us);
             } else {
                 hw.PrintLine("TDOA: %lu μs (Mic 0 detected first)", time_diff_us);
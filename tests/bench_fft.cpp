@@ -0,0 +1,75 @@
+// The iterative table-driven FFTLibrary::fft against the recursive radix-2 FFT it replaced
+// (host timings, not Cortex-M7)
+#include "fft_library.h"
+#include "test_common.h"
+#include <vector>
+
+static const int kRepeats = 2000;
+
+// The previous implementation: recursive Cooley-Tukey with two temporary vectors per level
+static void recursiveFFT(std::vector<std::complex<float>>& signal)
+{
+    const size_t N = signal.size();
+    if (N <= 1)
+        return;
+
+    std::vector<std::complex<float>> even(N / 2);
+    std::vector<std::complex<float>> odd(N / 2);
+    for (size_t i = 0; i < N / 2; ++i)
+    {
+        even[i] = signal[2 * i];
+        odd[i] = signal[2 * i + 1];
+    }
+
+    recursiveFFT(even);
+    recursiveFFT(odd);
+
+    for (size_t k = 0; k < N / 2; ++k)
+    {
+        std::complex<float> t = std::polar(1.0f, (float)(-2.0 * M_PI * k / N)) * odd[k];
+        signal[k] = even[k] + t;
+        signal[k + N / 2] = even[k] - t;
+    }
+}
+
+template <typename Function>
+static double microsecondsPerCall(const std::vector<std::complex<float>>& input, Function function)
+{
+    std::vector<std::complex<float>> signal(input.size());
+    volatile float sink = 0.0f;
+    const double start = nowSeconds();
+    for (int r = 0; r < kRepeats; ++r)
+    {
+        signal = input;
+        function(signal);
+        sink = sink + signal[1].real();
+    }
+    return (nowSeconds() - start) * 1e6 / kRepeats;
+}
+
+int main()
+{
+    const size_t sizes[] = {64, 1024, 2048};
+    for (size_t size : sizes)
+    {
+        std::vector<std::complex<float>> input(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            input[i] = std::complex<float>(0.5f * sinf(0.3f * i) + 0.1f * cosf(1.7f * i), 0.0f);
+        }
+
+        // The two produce the same bits (same twiddle expression and butterfly order)
+        std::vector<std::complex<float>> a = input;
+        std::vector<std::complex<float>> b = input;
+        FFTLibrary fft(96000.0f, size);
+        fft.fft(a);
+        recursiveFFT(b);
+        const bool identical = a == b;
+
+        const double recursiveUs = microsecondsPerCall(input, recursiveFFT);
+        const double iterativeUs = microsecondsPerCall(input, [&](std::vector<std::complex<float>>& s) { fft.fft(s); });
+        printf("N=%4zu  recursive %8.2f us  iterative %8.2f us  %.1fx faster%s\n", size, recursiveUs, iterativeUs,
+               recursiveUs / iterativeUs, identical ? "" : "  (outputs differ)");
+    }
+    return 0;
+}
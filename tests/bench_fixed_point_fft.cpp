@@ -0,0 +1,51 @@
+// Band magnitude cost of the float path against Q15 and Q31 (host timings, not Cortex-M7)
+#include "fft_library.h"
+#include "fixed_point_fft.h"
+#include "test_common.h"
+#include <vector>
+
+static const float kSampleRate = 96000.0f;
+static const float kTone = 25000.0f;
+static const int kRepeats = 2000;
+
+template <typename Function>
+static double microsecondsPerCall(Function function)
+{
+    volatile float sink = 0.0f;
+    const double start = nowSeconds();
+    for (int r = 0; r < kRepeats; ++r)
+    {
+        sink = sink + function();
+    }
+    return (nowSeconds() - start) * 1e6 / kRepeats;
+}
+
+int main()
+{
+    const size_t sizes[] = {256, 1024};
+    for (size_t size : sizes)
+    {
+        std::vector<float> input(size);
+        std::vector<int16_t> s15(size);
+        std::vector<int32_t> s31(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            input[i] = 0.5f * sinf(2.0f * (float)M_PI * kTone * i / kSampleRate);
+            s15[i] = FixedPointFFTQ15::fromFloat(input[i]);
+            s31[i] = FixedPointFFTQ31::fromFloat(input[i]);
+        }
+
+        FFTLibrary fft(kSampleRate, size);
+        std::vector<std::complex<float>> workspace(FFTLibrary::workspaceSize(size));
+        FixedPointFFTQ15 q15(kSampleRate, size);
+        FixedPointFFTQ31 q31(kSampleRate, size);
+
+        const double floatUs = microsecondsPerCall([&]() {
+            return fft.getFrequencyMagnitude(input.data(), size, kTone, 0.01f, workspace.data(), workspace.size());
+        });
+        const double q15Us = microsecondsPerCall([&]() { return q15.getFrequencyMagnitude(s15.data(), 1, kTone, 0.01f); });
+        const double q31Us = microsecondsPerCall([&]() { return q31.getFrequencyMagnitude(s31.data(), 1, kTone, 0.01f); });
+        printf("N=%4zu  float (real) %7.2f us  Q15 %7.2f us  Q31 %7.2f us\n", size, floatUs, q15Us, q31Us);
+    }
+    return 0;
+}
@@ -0,0 +1,175 @@
+// Uncoded against rate-1/2 K=7 coded binary FSK frames through FskDemodulator, FskPacketDecoder
+// and ViterbiDecoder over Eb/N0 per information bit: bit error rate over the frame body (length,
+// payload, CRC) and packet error rate (fsk_demodulator's 1000 baud, 44/45 kHz tones at 96 kHz).
+// The coded frames send two code bits per information bit at the same baud and tone amplitude,
+// so each channel bit gets half the energy.
+#include "convolutional_code.h"
+#include "fsk_modem.h"
+#include "fsk_packet.h"
+#include "test_common.h"
+#include <random>
+#include <vector>
+
+static const float kSampleRate = 96000.0f;
+static const float kMarkFreq = 45000.0f;
+static const float kSpaceFreq = 44000.0f;
+static const float kBaudRate = 1000.0f;
+static const float kAmplitude = 0.1f;
+static const size_t kPayload = 16;
+static const size_t kGuardSymbols = 24;   // noise before and after each frame
+static const int kTrials = 200;
+
+struct Result
+{
+    size_t bitErrors;
+    size_t bits;
+    int packets;
+};
+
+// One frame through the channel and the receiver; adds to result
+static void runFrame(bool coded, float sigma, std::mt19937& rng, Result& result)
+{
+    std::uniform_int_distribution<int> byteValue(0, 255);
+    std::normal_distribution<float> noise(0.0f, sigma);
+
+    uint8_t payload[kPayload];
+    for (uint8_t& byte : payload)
+    {
+        byte = (uint8_t)byteValue(rng);
+    }
+    uint8_t frame[256];
+    const size_t frameBytes = FskPacketDecoder::encodeFrame(payload, kPayload, frame, sizeof(frame),
+                                                            FskPacketDecoder::kDefaultSyncWord, 1, coded);
+    const size_t preambleBits = FskPacketDecoder::kPreambleSymbols;
+    const size_t bodyBits = 8 * (1 + kPayload + 2);
+
+    // Continuous-phase binary FSK, MSB first, with noise-only guards
+    const float samplesPerBit = kSampleRate / kBaudRate;
+    const size_t frameBits = 8 * frameBytes;
+    const size_t totalSamples = (size_t)((frameBits + 2 * kGuardSymbols) * samplesPerBit);
+    const size_t frameStart = (size_t)(kGuardSymbols * samplesPerBit);
+
+    FskDemodulator demod(kSampleRate, kMarkFreq, kSpaceFreq, kBaudRate);
+    FskPacketDecoder packets(FskPacketDecoder::kDefaultSyncWord, coded ? 4 : 2, 8, 1);
+    packets.setCoded(coded);
+    std::vector<float> soft;
+    bool received = false;
+    double phase = 0.0;
+    for (size_t n = 0; n < totalSamples; ++n)
+    {
+        float sample = noise(rng);
+        if (n >= frameStart && n < frameStart + (size_t)(frameBits * samplesPerBit))
+        {
+            const size_t bit = (size_t)((n - frameStart) / samplesPerBit);
+            const bool one = (frame[bit / 8] >> (7 - bit % 8)) & 1;
+            phase += 2.0 * M_PI * (one ? kMarkFreq : kSpaceFreq) / kSampleRate;
+            sample += kAmplitude * (float)sin(phase);
+        }
+        demod.process(sample, SampleClock::Timestamp{0, (uint32_t)n});
+        FskDemodulator::Symbol symbol;
+        while (demod.popSymbol(symbol))
+        {
+            soft.push_back(symbol.soft[0]);
+            if (packets.pushSoftBit(symbol.soft[0]))
+            {
+                const FskPacketDecoder::Packet& packet = packets.getPacket();
+                bool match = packet.length == kPayload;
+                for (size_t i = 0; match && i < kPayload; ++i)
+                {
+                    match = packet.payload[i] == payload[i];
+                }
+                received = received || match;
+            }
+        }
+    }
+    result.packets += received ? 1 : 0;
+
+    // Align the received bits on the sync word (the closest match anywhere in the stream)
+    size_t best = 0;
+    size_t bestDistance = 33;
+    for (size_t offset = 0; offset + 32 <= soft.size(); ++offset)
+    {
+        size_t distance = 0;
+        for (size_t b = 0; b < 32; ++b)
+        {
+            const uint8_t sent = (uint8_t)((FskPacketDecoder::kDefaultSyncWord >> (31 - b)) & 1);
+            distance += (soft[offset + b] > 0.0f ? 1 : 0) != sent ? 1 : 0;
+        }
+        if (distance < bestDistance)
+        {
+            bestDistance = distance;
+            best = offset;
+        }
+    }
+    const size_t body = best + 32;
+
+    // The information bits are the uncoded body, whichever way they were sent
+    uint8_t sentBody[8 * (1 + kPayload + 2)];
+    uint8_t plain[256];
+    FskPacketDecoder::encodeFrame(payload, kPayload, plain, sizeof(plain));
+    for (size_t b = 0; b < bodyBits; ++b)
+    {
+        const size_t bit = preambleBits + 32 + b;
+        sentBody[b] = (plain[bit / 8] >> (7 - bit % 8)) & 1;
+    }
+
+    uint8_t decided[8 * (1 + kPayload + 2)];
+    const size_t codedBits = 2 * (bodyBits + ConvolutionalEncoder::kTailBits);
+    if (!coded && body + bodyBits <= soft.size())
+    {
+        for (size_t b = 0; b < bodyBits; ++b)
+        {
+            decided[b] = soft[body + b] > 0.0f ? 1 : 0;
+        }
+    }
+    else if (coded && body + codedBits <= soft.size())
+    {
+        ViterbiDecoder viterbi(bodyBits + ConvolutionalEncoder::kTailBits);
+        for (size_t b = 0; b < codedBits; b += 2)
+        {
+            viterbi.push(soft[body + b], soft[body + b + 1]);
+        }
+        viterbi.traceback(decided, bodyBits, true);
+    }
+    else
+    {
+        // Frame cut short (sync word matched too late): every bit counts as wrong
+        for (size_t b = 0; b < bodyBits; ++b)
+        {
+            decided[b] = (uint8_t)(sentBody[b] ^ 1);
+        }
+    }
+    for (size_t b = 0; b < bodyBits; ++b)
+    {
+        result.bitErrors += decided[b] != sentBody[b] ? 1 : 0;
+    }
+    result.bits += bodyBits;
+}
+
+int main()
+{
+    std::mt19937 rng(18);
+    const float samplesPerBit = kSampleRate / kBaudRate;
+    printf("Eb/N0  uncoded BER (theory)        coded BER   uncoded PER  coded PER   (%d frames, %zu-byte payload)\n",
+           kTrials, kPayload);
+    for (int ebN0Db = 4; ebN0Db <= 12; ++ebN0Db)
+    {
+        // Eb / N0 = A^2 * samplesPerBit / (4 * sigma^2) for a real tone in white noise of variance sigma^2
+        const double ebN0 = pow(10.0, ebN0Db / 10.0);
+        Result results[2] = {{0, 0, 0}, {0, 0, 0}};
+        for (int coded = 0; coded < 2; ++coded)
+        {
+            const double channelEbN0 = coded ? ebN0 / 2.0 : ebN0;
+            const float sigma = (float)sqrt(kAmplitude * kAmplitude * samplesPerBit / (4.0 * channelEbN0));
+            for (int t = 0; t < kTrials; ++t)
+            {
+                runFrame(coded != 0, sigma, rng, results[coded]);
+            }
+        }
+        printf("%3d dB   %.2e (%.2e)    %.2e    %.3f        %.3f\n", ebN0Db,
+               (double)results[0].bitErrors / results[0].bits, 0.5 * exp(-ebN0 / 2.0),
+               (double)results[1].bitErrors / results[1].bits, 1.0 - (double)results[0].packets / kTrials,
+               1.0 - (double)results[1].packets / kTrials);
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+// GccPhat delay accuracy against SNR for master_ping's setup (96 kHz, N = 1024, 0.5 m spacing,
+// beta = 0.7): RMS error in samples over random fractional delays, parabolic / sinc refinement.
+// The 14080 Hz tone ping repeats every 6.8 samples, so it is also run gated on a coarse delay
+// with matched-filter-like error, as master_ping does.
+#include "gcc_phat.h"
+#include "test_common.h"
+#include <random>
+#include <vector>
+
+static const float kSampleRate = 96000.0f;
+static const size_t kFrameSize = 1024;
+static const float kSpacing = 0.5f;
+static const float kWeighting = 0.7f;
+static const float kToneFrequency = 14080.0f;
+static const float kCoarseError = 1.0f;  // samples RMS, roughly the matched-filter arrival difference
+static const int kTrials = 300;
+
+enum class Signal
+{
+    Burst,
+    Chirp,
+    Tone
+};
+
+static const float kPi = (float)M_PI;
+
+// Raised-cosine envelope over [0, length), zero outside
+static float envelope(float t, float length)
+{
+    return t < 0.0f || t >= length ? 0.0f : 0.5f - 0.5f * cosf(2.0f * kPi * t / length);
+}
+
+// Signal value at time t (samples) for a burst starting at sample 256 of the frame
+static float sample(Signal signal, float t, const std::vector<float>& phases)
+{
+    const float start = 256.0f;
+    const float u = t - start;
+    switch (signal)
+    {
+    case Signal::Burst:
+    {
+        // Sum of random-phase tones every 500 Hz from 5 to 40 kHz, 384 samples long
+        float value = 0.0f;
+        for (size_t k = 0; k < phases.size(); ++k)
+        {
+            const float frequency = 5000.0f + 500.0f * (float)k;
+            value += sinf(2.0f * kPi * frequency * u / kSampleRate + phases[k]);
+        }
+        return envelope(u, 384.0f) * value / sqrtf((float)phases.size());
+    }
+    case Signal::Chirp:
+    {
+        // Linear 20-30 kHz sweep over 512 samples
+        const float length = 512.0f;
+        const float seconds = u / kSampleRate;
+        const float rate = 10000.0f / (length / kSampleRate);
+        return envelope(u, length) * sinf(2.0f * kPi * (20000.0f * seconds + 0.5f * rate * seconds * seconds));
+    }
+    case Signal::Tone:
+    default:
+        // 4 ms ping at the master_ping target frequency
+        return envelope(u, 384.0f) * sinf(2.0f * kPi * kToneFrequency * u / kSampleRate + phases[0]);
+    }
+}
+
+struct Result
+{
+    float rms;
+    float failed;  // fraction of trials where estimate() returned false
+};
+
+// gated: search only within half a tone period of a noisy coarse delay (fall back to it on failure)
+static Result run(Signal signal, GccPhat::Refinement refinement, float snrDb, bool gated, std::mt19937& rng)
+{
+    GccPhat tdoa(kSampleRate, kFrameSize, GccPhat::maxDelayForSpacing(kSpacing));
+    tdoa.setRefinement(refinement);
+    tdoa.setWeighting(kWeighting);
+    const float maxDelay = (float)tdoa.getMaxLag() - 8.0f;
+    const float halfPeriod = 0.5f * kSampleRate / kToneFrequency;
+
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    std::normal_distribution<float> gauss(0.0f, 1.0f);
+    std::vector<float> frame_0(kFrameSize);
+    std::vector<float> frame_1(kFrameSize);
+    std::vector<float> phases(71);
+
+    double squared = 0.0;
+    int failures = 0;
+    for (int trial = 0; trial < kTrials; ++trial)
+    {
+        const float delay = maxDelay * (2.0f * uniform(rng) - 1.0f);
+        for (float& phase : phases)
+        {
+            phase = 2.0f * kPi * uniform(rng);
+        }
+
+        // Noise relative to the signal power over the burst (unit-ish amplitude)
+        float power = 0.0f;
+        for (size_t i = 0; i < kFrameSize; ++i)
+        {
+            frame_0[i] = sample(signal, (float)i, phases);
+            frame_1[i] = sample(signal, (float)i - delay, phases);
+            power += frame_0[i] * frame_0[i];
+        }
+        const float noise = sqrtf(power / 384.0f / powf(10.0f, snrDb / 10.0f));
+        for (size_t i = 0; i < kFrameSize; ++i)
+        {
+            frame_0[i] += noise * gauss(rng);
+            frame_1[i] += noise * gauss(rng);
+        }
+
+        float estimate = 0.0f;
+        if (gated)
+        {
+            const float coarse = delay + kCoarseError * gauss(rng);
+            const bool ok = tdoa.estimate(frame_0.data(), frame_1.data(), kFrameSize, coarse, halfPeriod);
+            estimate = ok ? tdoa.getDelaySamples() : coarse;
+            failures += ok ? 0 : 1;
+        }
+        else
+        {
+            const bool ok = tdoa.estimate(frame_0.data(), frame_1.data(), kFrameSize);
+            estimate = ok ? tdoa.getDelaySamples() : 0.0f;
+            failures += ok ? 0 : 1;
+        }
+        squared += (double)(estimate - delay) * (estimate - delay);
+    }
+    return {(float)sqrt(squared / kTrials), (float)failures / kTrials};
+}
+
+int main()
+{
+    std::mt19937 rng(21);
+    const float snrs[] = {30.0f, 20.0f, 10.0f, 0.0f};
+    const struct
+    {
+        Signal signal;
+        bool gated;
+        const char* name;
+    } cases[] = {
+        {Signal::Burst, false, "5-40 kHz burst"},
+        {Signal::Chirp, false, "20-30 kHz chirp"},
+        {Signal::Tone, false, "14080 Hz ping"},
+        {Signal::Tone, true, "14080 Hz ping, gated"},
+    };
+
+    printf("RMS delay error (samples), parabolic / sinc, %d trials, +/-%zu lags\n", kTrials,
+           GccPhat(kSampleRate, kFrameSize, GccPhat::maxDelayForSpacing(kSpacing)).getMaxLag());
+    for (const auto& c : cases)
+    {
+        printf("%-22s", c.name);
+        for (float snr : snrs)
+        {
+            const Result parabolic = run(c.signal, GccPhat::Refinement::Parabolic, snr, c.gated, rng);
+            const Result sinc = run(c.signal, GccPhat::Refinement::Sinc, snr, c.gated, rng);
+            printf("  %2.0f dB %6.3f / %6.3f", snr, parabolic.rms, sinc.rms);
+            if (c.gated)
+            {
+                printf(" (%2.0f%% kept coarse)", 100.0f * sinc.failed);
+            }
+        }
+        printf("\n");
+    }
+    printf("gated: coarse delay with %.1f-sample RMS error, search within half a period (%.2f samples)\n",
+           kCoarseError, 0.5f * kSampleRate / kToneFrequency);
+    return 0;
+}
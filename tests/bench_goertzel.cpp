@@ -0,0 +1,72 @@
+// Band magnitude cost of the FFT backend against the Goertzel backend as the band widens, one
+// channel and the two-channel batched call master_level makes (host timings, not Cortex-M7)
+#include "fft_library.h"
+#include "test_common.h"
+#include <vector>
+
+static const float kSampleRate = 96000.0f;
+static const float kTarget = 25000.0f;
+static const int kRepeats = 2000;
+
+template <typename Function>
+static double microsecondsPerCall(Function function)
+{
+    volatile float sink = 0.0f;
+    const double start = nowSeconds();
+    for (int r = 0; r < kRepeats; ++r)
+    {
+        sink = sink + function();
+    }
+    return (nowSeconds() - start) * 1e6 / kRepeats;
+}
+
+int main()
+{
+    const size_t sizes[] = {64, 1024, 2048};
+    const float tolerances[] = {0.001f, 0.01f, 0.02f, 0.03f, 0.05f};
+    for (size_t size : sizes)
+    {
+        std::vector<float> input_0(size);
+        std::vector<float> input_1(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            input_0[i] = 0.5f * sinf(2.0f * (float)M_PI * kTarget * i / kSampleRate);
+            input_1[i] = 0.25f * sinf(2.0f * (float)M_PI * kTarget * i / kSampleRate + 1.0f);
+        }
+        const float* inputs[2] = {input_0.data(), input_1.data()};
+
+        FFTLibrary fft(kSampleRate, size);
+        FFTLibrary goertzel(kSampleRate, size);
+        goertzel.setMagnitudeBackend(FFTLibrary::MagnitudeBackend::Goertzel);
+        std::vector<std::complex<float>> workspace(2 * FFTLibrary::workspaceSize(size));
+
+        for (float tolerance : tolerances)
+        {
+            size_t lower = 0;
+            size_t upper = 0;
+            GoertzelDetector::bandBins(size, kSampleRate, kTarget, tolerance, lower, upper);
+
+            const double fftUs = microsecondsPerCall([&]() {
+                return fft.getFrequencyMagnitude(input_0.data(), size, kTarget, tolerance, workspace.data(), workspace.size());
+            });
+            const double goertzelUs = microsecondsPerCall([&]() {
+                return goertzel.getFrequencyMagnitude(input_0.data(), size, kTarget, tolerance, workspace.data(),
+                                                      workspace.size());
+            });
+            float levels[2];
+            const double fftPairUs = microsecondsPerCall([&]() {
+                fft.getFrequencyMagnitudes(inputs, 2, size, kTarget, tolerance, levels, workspace.data(), workspace.size());
+                return levels[0];
+            });
+            const double goertzelPairUs = microsecondsPerCall([&]() {
+                goertzel.getFrequencyMagnitudes(inputs, 2, size, kTarget, tolerance, levels, workspace.data(),
+                                                workspace.size());
+                return levels[0];
+            });
+            printf("N=%4zu %2zu bins  1 ch: FFT %7.2f us  Goertzel %7.2f us  2 ch: FFT %7.2f us  Goertzel %7.2f us  (%s)\n",
+                   size, upper - lower + 1, fftUs, goertzelUs, fftPairUs, goertzelPairUs,
+                   goertzelPairUs < fftPairUs ? "Goertzel" : "FFT");
+        }
+    }
+    return 0;
+}
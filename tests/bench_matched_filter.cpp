@@ -0,0 +1,42 @@
+// MatchedFilter cost per hop for master_ping's setup (two channels, 96 kHz, 4 ms burst) against
+// the hop duration, i.e. how many times faster than real time (host timings, not Cortex-M7)
+#include "matched_filter.h"
+#include "test_common.h"
+#include <vector>
+
+static const float kSampleRate = 96000.0f;
+static const float kFrequency = 14080.0f;
+static const float kDuration = 0.004f;
+static const int kRepeats = 2000;
+
+int main()
+{
+    const size_t sizes[] = {1024, 2048};
+    for (size_t size : sizes)
+    {
+        MatchedFilter filter(kSampleRate, size, 2, kFrequency, kDuration);
+        filter.setThreshold(0, 10.0f);
+        filter.setThreshold(1, 10.0f);
+        std::vector<float> frame_0(size);
+        std::vector<float> frame_1(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            frame_0[i] = 0.1f * sinf(2.0f * (float)M_PI * kFrequency * i / kSampleRate);
+            frame_1[i] = 0.1f * cosf(2.0f * (float)M_PI * kFrequency * i / kSampleRate);
+        }
+        const float* frames[2] = {frame_0.data(), frame_1.data()};
+
+        volatile float sink = 0.0f;
+        const double start = nowSeconds();
+        for (int r = 0; r < kRepeats; ++r)
+        {
+            filter.process(frames, (uint64_t)r * filter.getHopSize());
+            sink = sink + filter.getFrameMaximum(0);
+        }
+        const double hopUs = (nowSeconds() - start) * 1e6 / kRepeats;
+        const double realTimeUs = filter.getHopSize() * 1e6 / kSampleRate;
+        printf("N=%4zu  %7.2f us per %zu-sample hop (%.0f us of audio): %.0fx real time\n", size, hopUs,
+               filter.getHopSize(), realTimeUs, realTimeUs / hopUs);
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+// The workspace overloads of FFTLibrary must not touch the heap once the tables are built,
+// for every transform mode, window and magnitude backend.
+#include "fft_library.h"
+#include "test_common.h"
+#include <cstdlib>
+#include <new>
+
+static bool g_counting = false;
+static size_t g_allocations = 0;
+
+void* operator new(size_t size)
+{
+    if (g_counting)
+    {
+        ++g_allocations;
+    }
+    void* p = malloc(size > 0 ? size : 1);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
+
+static const float kSampleRate = 96000.0f;
+static const size_t kSize = 1024;
+static const size_t kChannels = 2;
+
+static void fillTone(float* buffer, size_t size, float frequency, float amplitude)
+{
+    for (size_t i = 0; i < size; ++i)
+    {
+        buffer[i] = amplitude * sinf(2.0f * (float)M_PI * frequency * i / kSampleRate);
+    }
+}
+
+int main()
+{
+    static float buffer_0[kSize];
+    static float buffer_1[kSize];
+    fillTone(buffer_0, kSize, 25000.0f, 0.5f);
+    fillTone(buffer_1, kSize, 25000.0f, 0.25f);
+    const float* buffers[kChannels] = {buffer_0, buffer_1};
+    static std::complex<float> workspace[kChannels * kSize];
+    const size_t workspaceSize = kChannels * kSize;
+
+    const FFTLibrary::TransformMode modes[] = {FFTLibrary::TransformMode::Real, FFTLibrary::TransformMode::Complex};
+    const FFTLibrary::MagnitudeBackend backends[] = {FFTLibrary::MagnitudeBackend::FFT,
+                                                     FFTLibrary::MagnitudeBackend::Goertzel};
+    const WindowType windows[] = {WindowType::Hann, WindowType::BlackmanHarris, WindowType::FlatTop,
+                                  WindowType::Kaiser, WindowType::Rectangular};
+
+    for (FFTLibrary::TransformMode mode : modes)
+    {
+        for (FFTLibrary::MagnitudeBackend backend : backends)
+        {
+            for (WindowType window : windows)
+            {
+                // Configuration may build tables; only the detection calls are counted
+                FFTLibrary fft(kSampleRate, kSize);
+                fft.setTransformMode(mode);
+                fft.setMagnitudeBackend(backend);
+                fft.setWindow(window);
+
+                float magnitudes[kChannels] = {0.0f, 0.0f};
+                float level = 0.0f;
+                float pitch = 0.0f;
+                g_allocations = 0;
+                g_counting = true;
+                for (int repeat = 0; repeat < 10; ++repeat)
+                {
+                    level = fft.getFrequencyMagnitude(buffer_0, kSize, 25000.0f, 0.01f, workspace, workspaceSize);
+                    pitch = fft.detectPitch(buffer_0, kSize, workspace, workspaceSize);
+                    fft.getFrequencyMagnitudes(buffers, kChannels, kSize, 25000.0f, 0.01f, magnitudes, workspace,
+                                               workspaceSize);
+                }
+                g_counting = false;
+
+                CHECK(g_allocations == 0);
+                CHECK(level > 0.0f);
+                CHECK_NEAR(pitch, 25000.0f, kSampleRate / kSize);
+                CHECK_NEAR(magnitudes[0], 2.0f * magnitudes[1], 1e-3f * magnitudes[0]);
+            }
+        }
+    }
+
+    // A workspace that is too small is refused without falling back to the heap
+    FFTLibrary fft(kSampleRate, kSize);
+    g_allocations = 0;
+    g_counting = true;
+    const float refused = fft.getFrequencyMagnitude(buffer_0, kSize, 25000.0f, 0.01f, workspace, 16);
+    g_counting = false;
+    CHECK(refused == 0.0f);
+    CHECK(g_allocations == 0);
+
+    // The counting hook itself works: the vector-based overload allocates its transform
+    g_allocations = 0;
+    g_counting = true;
+    fft.getFrequencyMagnitude(buffer_0, kSize, 25000.0f, 0.01f);
+    g_counting = false;
+    CHECK(g_allocations > 0);
+
+    return finish("test_allocations");
+}
@@ -0,0 +1,109 @@
+// CaptureRing as master_ping drives it: the pre/post-trigger window around a past trigger, a late
+// trigger that finds part of its history gone, triggers refused while every slot holds a snapshot,
+// and release() making room again. Each pushed sample holds its own index, so reads show positions.
+#include "capture_ring.h"
+#include "test_common.h"
+#include <vector>
+
+static const size_t kChannels = 2;
+static const size_t kCapacity = 64;
+static const size_t kSlots = 3;
+static const size_t kPreTrigger = 16;
+static const size_t kPostTrigger = 16;
+
+static uint64_t g_written = 0;
+
+// Push count samples: channel 0 holds the sample index, channel 1 its negative
+static void pushSamples(CaptureRing& ring, size_t count)
+{
+    for (size_t i = 0; i < count; ++i, ++g_written)
+    {
+        const float samples[kChannels] = {(float)g_written, -(float)g_written};
+        ring.push(samples);
+    }
+}
+
+// Whether the snapshot holds the consecutive indices from its first sample on (negated on channel 1)
+static bool holdsIndices(const CaptureRing& ring, const CaptureRing::Snapshot& snapshot)
+{
+    std::vector<float> data(snapshot.length);
+    std::vector<float> negated(snapshot.length);
+    if (ring.read(snapshot, 0, 0, data.data(), snapshot.length) != snapshot.length ||
+        ring.read(snapshot, 1, 0, negated.data(), snapshot.length) != snapshot.length)
+    {
+        return false;
+    }
+    bool consecutive = true;
+    for (size_t i = 0; i < snapshot.length; ++i)
+    {
+        consecutive = consecutive && data[i] == (float)(snapshot.firstSample + i) && negated[i] == -data[i];
+    }
+    return consecutive;
+}
+
+int main()
+{
+    std::vector<float> storage(CaptureRing::storageSize(kChannels, kCapacity, kSlots));
+    CaptureRing ring(storage.data(), kChannels, kCapacity, kSlots);
+    ring.setWindow(kPreTrigger, kPostTrigger);
+    CaptureRing::Snapshot snapshot;
+
+    // A trigger already in the past (the slot has wrapped) freezes [trigger - pre, trigger + post)
+    pushSamples(ring, 100);
+    CHECK(ring.trigger(80));
+    CHECK(!ring.trigger(90));  // one request at a time
+    CHECK(!ring.acquire(snapshot));
+    pushSamples(ring, 1);
+    CHECK(ring.acquire(snapshot));
+    CHECK(snapshot.triggerSample == 80);
+    CHECK(snapshot.firstSample == 80 - kPreTrigger);
+    CHECK(snapshot.length == kPreTrigger + kPostTrigger);
+    CHECK(holdsIndices(ring, snapshot));
+
+    // Reads stop at the end of the snapshot and reject unknown channels
+    float tail[8];
+    CHECK(ring.read(snapshot, 0, snapshot.length - 3, tail, 8) == 3);
+    CHECK(tail[2] == (float)(snapshot.firstSample + snapshot.length - 1));
+    CHECK(ring.read(snapshot, 0, snapshot.length, tail, 8) == 0);
+    CHECK(ring.read(snapshot, kChannels, 0, tail, 8) == 0);
+
+    // The post-trigger part is waited for; a trigger older than the fresh slot keeps what is left
+    pushSamples(ring, 20);  // the new slot starts at sample 101
+    CHECK(ring.trigger(110));
+    pushSamples(ring, 15);
+    CaptureRing::Snapshot late;
+    CHECK(ring.acquire(late) && late.triggerSample == 80);  // only the first one so far
+    pushSamples(ring, 1);
+    CHECK(ring.acquire(late) && late.triggerSample == 80);  // acquire() returns the oldest
+
+    // Every other slot now holds a snapshot: the trigger is refused up front instead of lost
+    pushSamples(ring, 10);
+    CHECK(!ring.trigger(g_written - 1));
+    pushSamples(ring, kCapacity);
+    CHECK(!ring.trigger(g_written - 1));
+
+    // Releasing the oldest hands over the late one and makes room for the next trigger
+    ring.release(snapshot);
+    CHECK(ring.acquire(late));
+    CHECK(late.triggerSample == 110);
+    CHECK(late.firstSample == 101);
+    CHECK(late.length == 110 + kPostTrigger - 101);
+    CHECK(holdsIndices(ring, late));
+
+    const uint64_t next = g_written - 4;
+    CHECK(ring.trigger(next));
+    pushSamples(ring, kPostTrigger);
+    ring.release(late);
+    CHECK(ring.acquire(snapshot));
+    CHECK(snapshot.triggerSample == next);
+    CHECK(snapshot.firstSample == next - kPreTrigger);
+    CHECK(snapshot.length == kPreTrigger + kPostTrigger);
+    CHECK(holdsIndices(ring, snapshot));
+
+    // Releasing twice is harmless
+    ring.release(snapshot);
+    ring.release(snapshot);
+    CHECK(!ring.acquire(snapshot));
+
+    return finish("test_capture_ring");
+}
@@ -0,0 +1,108 @@
+// CfarDetector on a history-only band level (as master_ping uses it): false-alarm rate on
+// steady noise, short bursts detected without raising the threshold, and recovery after a
+// step in the noise floor.
+#include "cfar_detector.h"
+#include "test_common.h"
+#include <random>
+
+static const size_t kHistory = 64;
+static const float kFalseAlarm = 1e-3f;
+
+// Band magnitude of complex Gaussian noise with mean power `power` (square-law cells are exponential)
+static float noiseLevel(std::mt19937& rng, float power)
+{
+    std::exponential_distribution<float> exponential(1.0f);
+    return sqrtf(power * exponential(rng));
+}
+
+int main()
+{
+    const CfarDetector::Mode modes[] = {CfarDetector::Mode::CellAveraging, CfarDetector::Mode::OrderedStatistic};
+    for (CfarDetector::Mode mode : modes)
+    {
+        std::mt19937 rng(11);
+        CfarDetector cfar(mode, kFalseAlarm, 0, 0, kHistory);
+
+        // Nothing is declared while the history fills
+        bool early = false;
+        for (size_t i = 0; i < 3; ++i)
+        {
+            early = early || cfar.process(noiseLevel(rng, 1.0f));
+        }
+        CHECK(!early);
+
+        // Steady noise: false alarms near the configured rate
+        size_t alarms = 0;
+        const size_t trials = 200000;
+        for (size_t i = 0; i < trials; ++i)
+        {
+            alarms += cfar.process(noiseLevel(rng, 1.0f)) ? 1 : 0;
+        }
+        const float rate = (float)alarms / trials;
+        printf("  %s: false-alarm rate %.2e (configured %.0e)\n",
+               mode == CfarDetector::Mode::CellAveraging ? "CA" : "OS", rate, kFalseAlarm);
+        CHECK(rate < 3.0f * kFalseAlarm);
+        CHECK(rate > 0.1f * kFalseAlarm);
+
+        // A burst shorter than the lockout is detected throughout and leaves the threshold alone
+        size_t burstDetections = cfar.process(30.0f) ? 1 : 0;
+        const float threshold = cfar.getThreshold();
+        for (size_t i = 1; i < kHistory / 2; ++i)
+        {
+            burstDetections += cfar.process(30.0f) ? 1 : 0;
+        }
+        CHECK(burstDetections == kHistory / 2);
+        CHECK(cfar.getThreshold() == threshold);
+        for (size_t i = 0; i < kHistory; ++i)
+        {
+            cfar.process(noiseLevel(rng, 1.0f));
+        }
+
+        // The noise floor steps up 20 dB: detected at first, then the threshold follows it and the
+        // detector returns to its false-alarm rate instead of staying detected for good
+        size_t followed = 0;
+        for (size_t i = 0; i < 4 * kHistory && followed == 0; ++i)
+        {
+            cfar.process(noiseLevel(rng, 100.0f));
+            if (cfar.getThreshold() > 10.0f)
+            {
+                followed = i + 1;
+            }
+        }
+        printf("  %s: threshold above the new noise level %zu tests after a 20 dB step\n",
+               mode == CfarDetector::Mode::CellAveraging ? "CA" : "OS", followed);
+        CHECK(followed > kHistory);
+        CHECK(followed < 3 * kHistory);
+
+        alarms = 0;
+        for (size_t i = 0; i < 4 * kHistory; ++i)
+        {
+            cfar.process(noiseLevel(rng, 100.0f));
+        }
+        for (size_t i = 0; i < trials; ++i)
+        {
+            alarms += cfar.process(noiseLevel(rng, 100.0f)) ? 1 : 0;
+        }
+        CHECK((float)alarms / trials < 3.0f * kFalseAlarm);
+        CHECK(cfar.getNoiseLevel() > 5.0f);
+
+        // Bursts are still detected on the new floor
+        CHECK(cfar.process(300.0f));
+
+        // With the lockout disabled, the old behaviour: stuck at detected after the step
+        CfarDetector stuck(mode, kFalseAlarm, 0, 0, kHistory);
+        stuck.setLockoutLimit(0);
+        for (size_t i = 0; i < 4 * kHistory; ++i)
+        {
+            stuck.process(noiseLevel(rng, 1.0f));
+        }
+        size_t stuckDetections = 0;
+        for (size_t i = 0; i < 4 * kHistory; ++i)
+        {
+            stuckDetections += stuck.process(noiseLevel(rng, 100.0f) + 20.0f) ? 1 : 0;
+        }
+        CHECK(stuckDetections == 4 * kHistory);
+    }
+
+    return finish("test_cfar_detector");
+}
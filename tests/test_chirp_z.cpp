@@ -0,0 +1,49 @@
+// ChirpZTransform: a default-constructed transform refuses to run until init(), init() matches
+// the full constructor, and the fine bins agree with FFTLibrary's bins at the same frequencies.
+#include "chirp_z.h"
+#include "test_common.h"
+#include <algorithm>
+#include <vector>
+
+static const float kSampleRate = 96000.0f;
+static const size_t kSize = 2048;
+
+int main()
+{
+    std::vector<float> tone(kSize);
+    for (size_t i = 0; i < kSize; ++i)
+    {
+        tone[i] = 0.5f * sinf(2.0f * (float)M_PI * 25012.5f * i / kSampleRate);
+    }
+
+    ChirpZTransform deferred;
+    CHECK(!deferred.transform(tone.data(), kSize));
+    CHECK(deferred.getBinCount() == 0);
+
+    // 25 Hz steps over 20-45 kHz, as pitch_track_test uses it
+    deferred.init(kSampleRate, kSize, 20000.0f, 45000.0f, 1001);
+    ChirpZTransform constructed(kSampleRate, kSize, 20000.0f, 45000.0f, 1001);
+    CHECK(deferred.transform(tone.data(), kSize));
+    CHECK(constructed.transform(tone.data(), kSize));
+    CHECK(deferred.getSpectrum() == constructed.getSpectrum());
+    CHECK_NEAR(deferred.detectPitch(), 25012.5f, 2.0f);
+
+    // On the FFT grid (bin spacing 46.875 Hz) the bins equal the FFT's
+    const float spacing = kSampleRate / kSize;
+    deferred.init(kSampleRate, kSize, 500 * spacing, 599 * spacing, 100);
+    CHECK(deferred.transform(tone.data(), kSize));
+    FFTLibrary fft(kSampleRate, kSize);
+    SpectrumFrame frame;
+    CHECK(fft.computeFrame(tone.data(), kSize, frame));
+    float worst = 0.0f;
+    float largest = 0.0f;
+    for (size_t k = 0; k < 100; ++k)
+    {
+        worst = std::max(worst, std::abs(deferred.getSpectrum()[k] - frame.getBins()[500 + k]));
+        largest = std::max(largest, std::abs(frame.getBins()[500 + k]));
+    }
+    printf("  chirp-Z against FFT bins: largest difference %.1e of the peak\n", worst / largest);
+    CHECK(worst < 1e-3f * largest);
+
+    return finish("test_chirp_z");
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+// Minimal helpers for the host tests: a failed CHECK is reported and the test carries on;
+// finish() prints the tally and gives the exit code.
+static int g_checks = 0;
+static int g_failures = 0;
+
+#define CHECK(condition)                                                          \
+    do                                                                            \
+    {                                                                             \
+        ++g_checks;                                                               \
+        if (!(condition))                                                         \
+        {                                                                         \
+            ++g_failures;                                                         \
+            printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition);  \
+        }                                                                         \
+    } while (0)
+
+#define CHECK_NEAR(value, expected, tolerance)                                                        \
+    do                                                                                                \
+    {                                                                                                 \
+        ++g_checks;                                                                                   \
+        const double actual_ = (value);                                                               \
+        const double expected_ = (expected);                                                          \
+        if (!(std::fabs(actual_ - expected_) <= (tolerance)))                                         \
+        {                                                                                             \
+            ++g_failures;                                                                             \
+            printf("%s:%d: CHECK_NEAR failed: %s = %g, expected %g +/- %g\n", __FILE__, __LINE__, #value, \
+                   actual_, expected_, (double)(tolerance));                                         \
+        }                                                                                             \
+    } while (0)
+
+static inline int finish(const char* name)
+{
+    printf("%s: %d checks, %d failed\n", name, g_checks, g_failures);
+    return g_failures == 0 ? 0 : 1;
+}
+
+// Wall-clock seconds for the benchmarks
+static inline double nowSeconds()
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,171 @@
+// ConvolutionalEncoder and ViterbiDecoder: encode/decode round trip, correction of every pattern
+// within half the free distance (10) and a wrong decision at distance 4 from another codeword,
+// tail termination, and coded frames through FskPacketDecoder.
+#include "convolutional_code.h"
+#include "fsk_packet.h"
+#include "test_common.h"
+#include <random>
+#include <vector>
+
+static const size_t kDataBits = 120;
+static const size_t kSteps = kDataBits + ConvolutionalEncoder::kTailBits;
+
+// Encode data plus the zero tail into +/-1 code values
+static std::vector<float> encode(const std::vector<uint8_t>& data)
+{
+    ConvolutionalEncoder encoder;
+    std::vector<float> code;
+    for (size_t i = 0; i < kSteps; ++i)
+    {
+        const uint8_t pair = encoder.encode(i < data.size() ? data[i] : 0);
+        code.push_back((pair >> 1) & 1 ? 1.0f : -1.0f);
+        code.push_back(pair & 1 ? 1.0f : -1.0f);
+    }
+    return code;
+}
+
+static std::vector<uint8_t> decode(const std::vector<float>& code, bool terminated, size_t steps = kSteps)
+{
+    ViterbiDecoder viterbi(kSteps);
+    for (size_t i = 0; i + 1 < 2 * steps; i += 2)
+    {
+        viterbi.push(code[i], code[i + 1]);
+    }
+    std::vector<uint8_t> bits(kDataBits, 2);
+    viterbi.traceback(bits.data(), kDataBits, terminated);
+    return bits;
+}
+
+int main()
+{
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> coin(0, 1);
+
+    // Impulse response: a single 1 leaves state 0 and returns after K - 1 zeros with weight 10,
+    // the free distance of the 171/133 code
+    ConvolutionalEncoder impulse;
+    size_t weight = 0;
+    for (size_t i = 0; i < ConvolutionalEncoder::kConstraintLength; ++i)
+    {
+        const uint8_t pair = impulse.encode(i == 0 ? 1 : 0);
+        weight += ((pair >> 1) & 1) + (pair & 1);
+    }
+    CHECK(weight == 10);
+
+    // Round trip without errors
+    std::vector<uint8_t> data(kDataBits);
+    for (uint8_t& bit : data)
+    {
+        bit = (uint8_t)coin(rng);
+    }
+    std::vector<float> code = encode(data);
+    CHECK(code.size() == 2 * kSteps);
+    CHECK(decode(code, true) == data);
+    CHECK(decode(code, false) == data);
+
+    // Any 4 hard errors are corrected (every other codeword is at least 10 away)
+    int corrected = 0;
+    const int patterns = 2000;
+    std::uniform_int_distribution<size_t> position(0, code.size() - 1);
+    for (int p = 0; p < patterns; ++p)
+    {
+        std::vector<float> received = code;
+        for (int e = 0; e < 4;)
+        {
+            const size_t i = position(rng);
+            if (received[i] == code[i])
+            {
+                received[i] = -received[i];
+                ++e;
+            }
+        }
+        corrected += decode(received, true) == data ? 1 : 0;
+    }
+    CHECK(corrected == patterns);
+
+    // Six errors on the impulse response's ones turn the all-zero codeword into one 4 away from
+    // the impulse codeword, so the decoder must choose the impulse: the distance is exactly 10
+    std::vector<uint8_t> zeros(kDataBits, 0);
+    std::vector<uint8_t> single = zeros;
+    single[40] = 1;
+    const std::vector<float> zeroCode = encode(zeros);
+    const std::vector<float> singleCode = encode(single);
+    std::vector<float> received = zeroCode;
+    size_t flipped = 0;
+    for (size_t i = 0; i < received.size() && flipped < 6; ++i)
+    {
+        if (singleCode[i] != zeroCode[i])
+        {
+            received[i] = singleCode[i];
+            ++flipped;
+        }
+    }
+    CHECK(flipped == 6);
+    CHECK(decode(received, true) == single);
+
+    // Tail termination: errors near the end of the data are corrected only when the trellis is
+    // known to end in state 0
+    std::vector<float> tailErrors = code;
+    const size_t last = 2 * (kDataBits - 1);
+    tailErrors[last] = -tailErrors[last];
+    tailErrors[last + 1] = -tailErrors[last + 1];
+    tailErrors[last + 3] = -tailErrors[last + 3];
+    CHECK(decode(tailErrors, true) == data);
+    CHECK(decode(tailErrors, false) != data);
+
+    // After the tail the encoder is back in state 0: it continues like a fresh one
+    ConvolutionalEncoder flushed;
+    for (size_t i = 0; i < kSteps; ++i)
+    {
+        flushed.encode(i < kDataBits ? data[i] : 0);
+    }
+    ConvolutionalEncoder fresh;
+    CHECK(flushed.encode(1) == fresh.encode(1));
+
+    // A frame that is not complete yet: the provisional traceback still gives the early bits
+    const std::vector<uint8_t> partial = decode(code, false, kDataBits / 2 + 20);
+    bool early = true;
+    for (size_t i = 0; i < kDataBits / 2; ++i)
+    {
+        early = early && partial[i] == data[i];
+    }
+    CHECK(early);
+
+    // Coded frames through the packet decoder, clean and with hard errors spread over the body
+    uint8_t payload[24];
+    for (uint8_t& byte : payload)
+    {
+        byte = (uint8_t)(coin(rng) * 255);
+    }
+    uint8_t frame[128];
+    const size_t frameBytes = FskPacketDecoder::encodeFrame(payload, sizeof(payload), frame, sizeof(frame),
+                                                            FskPacketDecoder::kDefaultSyncWord, 1, true);
+    CHECK(frameBytes > 0);
+    const size_t bodyStart = 8 * (FskPacketDecoder::kPreambleSymbols / 8 + 4);
+    for (int errors = 0; errors <= 8; errors += 8)
+    {
+        FskPacketDecoder packets;
+        packets.setCoded(true);
+        bool received = false;
+        for (size_t bit = 0; bit < 8 * frameBytes; ++bit)
+        {
+            uint8_t value = (frame[bit / 8] >> (7 - bit % 8)) & 1;
+            // Every 40th code bit of the body wrong (well apart, so the code corrects each)
+            if (errors > 0 && bit >= bodyStart && (bit - bodyStart) % 40 == 7)
+            {
+                value ^= 1;
+            }
+            received = packets.pushBit(value) || received;
+        }
+        CHECK(received);
+        CHECK(packets.getPacket().length == sizeof(payload));
+        bool match = true;
+        for (size_t i = 0; i < sizeof(payload); ++i)
+        {
+            match = match && packets.getPacket().payload[i] == payload[i];
+        }
+        CHECK(match);
+    }
+
+    return finish("test_convolutional_code");
+}
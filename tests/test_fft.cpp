@@ -0,0 +1,124 @@
+// FFTLibrary against a naive double-precision DFT: the complex transform at every power-of-two
+// size (twiddles and bit reversal, including sizes below the prepared tables), and the real and
+// complex transform modes with and without a window (the packed-real split).
+#include "fft_library.h"
+#include "test_common.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static const float kSampleRate = 96000.0f;
+
+static std::vector<std::complex<double>> naiveDft(const std::vector<std::complex<double>>& input)
+{
+    const size_t N = input.size();
+    std::vector<std::complex<double>> output(N);
+    for (size_t k = 0; k < N; ++k)
+    {
+        std::complex<double> sum(0.0, 0.0);
+        for (size_t n = 0; n < N; ++n)
+        {
+            sum += input[n] * std::polar(1.0, -2.0 * M_PI * (double)((k * n) % N) / N);
+        }
+        output[k] = sum;
+    }
+    return output;
+}
+
+// Largest bin error relative to the largest bin
+template <typename Bins>
+static double relativeError(const Bins& bins, const std::vector<std::complex<double>>& expected, size_t count)
+{
+    double error = 0.0;
+    double largest = 0.0;
+    for (size_t k = 0; k < count; ++k)
+    {
+        const std::complex<double> value(bins[k].real(), bins[k].imag());
+        error = std::max(error, std::abs(value - expected[k]));
+        largest = std::max(largest, std::abs(expected[k]));
+    }
+    return error / largest;
+}
+
+int main()
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+
+    // Complex transform, with tables prepared for a larger size and for exactly this size
+    FFTLibrary large(kSampleRate, 2048);
+    double worst = 0.0;
+    for (size_t N = 2; N <= 2048; N *= 2)
+    {
+        std::vector<std::complex<float>> signal(N);
+        std::vector<std::complex<double>> reference(N);
+        for (size_t n = 0; n < N; ++n)
+        {
+            signal[n] = std::complex<float>(uniform(rng), uniform(rng));
+            reference[n] = std::complex<double>(signal[n].real(), signal[n].imag());
+        }
+        const std::vector<std::complex<double>> expected = naiveDft(reference);
+
+        std::vector<std::complex<float>> strided = signal;
+        large.fft(strided);
+        FFTLibrary exact(kSampleRate, N);
+        exact.fft(signal);
+        CHECK(relativeError(strided, expected, N) < 1e-5);
+        CHECK(relativeError(signal, expected, N) < 1e-5);
+        worst = std::max(worst, relativeError(signal, expected, N));
+    }
+    printf("  complex FFT, N = 2 .. 2048: largest error %.1e of the largest bin\n", worst);
+
+    // Real input through computeFrame: bins 0 .. N/2 for both transform modes and two windows
+    const FFTLibrary::TransformMode modes[] = {FFTLibrary::TransformMode::Real, FFTLibrary::TransformMode::Complex};
+    const WindowType windows[] = {WindowType::Rectangular, WindowType::Hann};
+    for (size_t N : {4, 8, 64, 1024})
+    {
+        std::vector<float> input(N);
+        for (float& value : input)
+        {
+            value = uniform(rng);
+        }
+        for (WindowType window : windows)
+        {
+            std::vector<std::complex<double>> windowed(N);
+            for (size_t n = 0; n < N; ++n)
+            {
+                windowed[n] = input[n] * (double)WindowCache::value(window, n, N, 8.6f);
+            }
+            const std::vector<std::complex<double>> expected = naiveDft(windowed);
+
+            for (FFTLibrary::TransformMode mode : modes)
+            {
+                FFTLibrary fft(kSampleRate, N);
+                fft.setTransformMode(mode);
+                fft.setWindow(window);
+                SpectrumFrame frame;
+                CHECK(fft.computeFrame(input.data(), N, frame));
+                const double error = relativeError(frame.getBins(), expected, N / 2 + 1);
+                if (error >= 1e-5)
+                {
+                    printf("  N = %zu, %s mode: error %.1e\n", N, mode == FFTLibrary::TransformMode::Real ? "real" : "complex",
+                           error);
+                }
+                CHECK(error < 1e-5);
+            }
+        }
+    }
+
+    // The real and complex modes agree on the level and pitch of a tone
+    std::vector<float> tone(1024);
+    for (size_t i = 0; i < tone.size(); ++i)
+    {
+        tone[i] = 0.5f * sinf(2.0f * (float)M_PI * 25300.0f * i / kSampleRate);
+    }
+    FFTLibrary real(kSampleRate, 1024);
+    FFTLibrary complex(kSampleRate, 1024);
+    complex.setTransformMode(FFTLibrary::TransformMode::Complex);
+    const float realLevel = real.getFrequencyMagnitude(tone.data(), tone.size(), 25300.0f, 0.01f);
+    CHECK_NEAR(realLevel, complex.getFrequencyMagnitude(tone.data(), tone.size(), 25300.0f, 0.01f), 1e-4 * realLevel);
+    CHECK_NEAR(real.detectPitch(tone.data(), tone.size()), 25300.0f, 0.2f * kSampleRate / 1024);
+    CHECK_NEAR(real.detectPitch(tone.data(), tone.size()), complex.detectPitch(tone.data(), tone.size()), 0.01f);
+
+    return finish("test_fft");
+}
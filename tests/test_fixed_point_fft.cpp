@@ -0,0 +1,110 @@
+// Q15/Q31 band magnitudes against the float FFTLibrary path on the same input
+#include "fft_library.h"
+#include "fixed_point_fft.h"
+#include "test_common.h"
+#include <vector>
+
+static const float kSampleRate = 96000.0f;
+static const size_t kSize = 1024;
+static const float kTone = 25000.0f;
+static const float kTolerance = 0.01f;
+
+// Float reference on the quantised input, so only the transform arithmetic is compared
+template <typename T>
+static float floatReference(FFTLibrary& fft, const std::vector<T>& samples, size_t stride, float fullScale)
+{
+    std::vector<float> input(kSize);
+    for (size_t i = 0; i < kSize; ++i)
+    {
+        input[i] = samples[i * stride] / fullScale;
+    }
+    return fft.getFrequencyMagnitude(input.data(), kSize, kTone, kTolerance);
+}
+
+template <typename T>
+static std::vector<T> tone(float amplitude, size_t stride)
+{
+    std::vector<T> samples(kSize * stride, 0);
+    for (size_t i = 0; i < kSize; ++i)
+    {
+        samples[i * stride] = FixedPointFFT<T>::fromFloat(amplitude * sinf(2.0f * (float)M_PI * kTone * i / kSampleRate));
+    }
+    return samples;
+}
+
+int main()
+{
+    FFTLibrary fft(kSampleRate, kSize);
+    FixedPointFFTQ15 q15(kSampleRate, kSize);
+    FixedPointFFTQ31 q31(kSampleRate, kSize);
+
+    // Q15 tracks the float path over the useful range and degrades gracefully near its noise floor
+    const float levelsDb[] = {0.0f, -6.0f, -20.0f, -46.0f, -66.0f};
+    for (float levelDb : levelsDb)
+    {
+        const float amplitude = 0.999f * powf(10.0f, levelDb / 20.0f);
+        const std::vector<int16_t> s15 = tone<int16_t>(amplitude, 1);
+        const std::vector<int32_t> s31 = tone<int32_t>(amplitude, 1);
+        const float reference15 = floatReference(fft, s15, 1, 32768.0f);
+        const float reference31 = floatReference(fft, s31, 1, 2147483648.0f);
+        const float error15 = fabsf(q15.getFrequencyMagnitude(s15.data(), 1, kTone, kTolerance) / reference15 - 1.0f);
+        const float error31 = fabsf(q31.getFrequencyMagnitude(s31.data(), 1, kTone, kTolerance) / reference31 - 1.0f);
+        printf("  %6.1f dBFS: Q15 error %.4f%%, Q31 error %.6f%%\n", levelDb, 100.0f * error15, 100.0f * error31);
+        CHECK(error15 < (levelDb >= -46.0f ? 1e-3f : 5e-2f));
+        CHECK(error31 < 1e-6f);
+    }
+
+    // Strided input (one channel of an interleaved buffer) gives the same result as contiguous
+    const std::vector<int16_t> contiguous = tone<int16_t>(0.5f, 1);
+    const std::vector<int16_t> interleaved = tone<int16_t>(0.5f, 2);
+    CHECK(q15.getFrequencyMagnitude(contiguous.data(), 1, kTone, kTolerance) ==
+          q15.getFrequencyMagnitude(interleaved.data(), 2, kTone, kTolerance));
+
+    // Full-scale worst cases: the block exponent keeps every stage in range
+    std::vector<int16_t> dc(kSize, 32767);
+    std::vector<int16_t> square(kSize);
+    std::vector<int16_t> nyquist(kSize);
+    for (size_t i = 0; i < kSize; ++i)
+    {
+        square[i] = (i / 8) % 2 ? -32768 : 32767;
+        nyquist[i] = i % 2 ? -32768 : 32767;
+    }
+    const std::vector<int16_t>* worst[] = {&dc, &square, &nyquist};
+    const float worstTargets[] = {100.0f, kSampleRate / 16.0f, 47500.0f};
+    for (size_t w = 0; w < 3; ++w)
+    {
+        std::vector<float> input(kSize);
+        for (size_t i = 0; i < kSize; ++i)
+        {
+            input[i] = (*worst[w])[i] / 32768.0f;
+        }
+        const float reference = fft.getFrequencyMagnitude(input.data(), kSize, worstTargets[w], kTolerance);
+        const float fixed = q15.getFrequencyMagnitude(worst[w]->data(), 1, worstTargets[w], kTolerance);
+        CHECK(std::isfinite(fixed));
+        CHECK_NEAR(fixed, reference, 1e-3f * reference + 1e-3f);
+    }
+
+    // Band energy times 4^exponent is the squared bin magnitudes of the float transform, in Q31 units
+    const std::vector<int32_t> s31 = tone<int32_t>(0.5f, 1);
+    std::vector<float> input(kSize);
+    for (size_t i = 0; i < kSize; ++i)
+    {
+        input[i] = s31[i] / 2147483648.0f;
+    }
+    SpectrumFrame frame;
+    CHECK(fft.computeFrame(input.data(), kSize, frame));
+    size_t lower_bin = 0;
+    size_t upper_bin = 0;
+    GoertzelDetector::bandBins(kSize, kSampleRate, kTone, kTolerance, lower_bin, upper_bin);
+    double expected = 0.0;
+    for (size_t bin = lower_bin; bin <= upper_bin; ++bin)
+    {
+        const double magnitude = frame.getMagnitude(bin) * 2147483648.0;
+        expected += magnitude * magnitude;
+    }
+    int exponent = 0;
+    const uint64_t energy = q31.getBandEnergy(s31.data(), 1, kTone, kTolerance, exponent);
+    CHECK_NEAR(energy * pow(4.0, exponent) / expected, 1.0, 1e-4);
+
+    return finish("test_fixed_point_fft");
+}
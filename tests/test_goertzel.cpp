@@ -0,0 +1,75 @@
+// The Goertzel backend against the FFT bins it replaces: GoertzelDetector and the FFTLibrary
+// backend give the FFT band magnitude for every window, band width and channel count.
+#include "fft_library.h"
+#include "test_common.h"
+#include <random>
+#include <vector>
+
+static const float kSampleRate = 96000.0f;
+
+int main()
+{
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<float> uniform(-1.0f, 1.0f);
+    const WindowType windows[] = {WindowType::Hann, WindowType::BlackmanHarris, WindowType::FlatTop,
+                                  WindowType::Kaiser, WindowType::Rectangular};
+    const float targets[] = {1000.0f, 14080.0f, 25000.0f, 40000.0f};
+    const float tolerances[] = {0.0f, 0.01f, 0.05f};
+
+    for (size_t N : {64, 1024})
+    {
+        std::vector<float> input_0(N);
+        std::vector<float> input_1(N);
+        for (size_t i = 0; i < N; ++i)
+        {
+            input_0[i] = 0.5f * sinf(2.0f * (float)M_PI * 25000.0f * i / kSampleRate) + 0.1f * uniform(rng);
+            input_1[i] = 0.1f * uniform(rng);
+        }
+        const float* inputs[2] = {input_0.data(), input_1.data()};
+
+        for (WindowType window : windows)
+        {
+            FFTLibrary fft(kSampleRate, N);
+            fft.setWindow(window);
+            FFTLibrary goertzel(kSampleRate, N);
+            goertzel.setWindow(window);
+            goertzel.setMagnitudeBackend(FFTLibrary::MagnitudeBackend::Goertzel);
+            GoertzelDetector detector(kSampleRate);
+            detector.setWindow(window);
+
+            // The FFT bins themselves, unscaled, for the detector (which does not apply the window scale)
+            SpectrumFrame frame;
+            CHECK(fft.computeFrame(input_0.data(), N, frame));
+
+            for (float target : targets)
+            {
+                for (float tolerance : tolerances)
+                {
+                    const float expected = fft.getFrequencyMagnitude(input_0.data(), N, target, tolerance);
+                    const float level = goertzel.getFrequencyMagnitude(input_0.data(), N, target, tolerance);
+                    CHECK_NEAR(level, expected, 1e-4f * (expected + 1.0f));
+
+                    size_t lower = 0;
+                    size_t upper = 0;
+                    GoertzelDetector::bandBins(N, kSampleRate, target, tolerance, lower, upper);
+                    float bins = 0.0f;
+                    for (size_t k = lower; k <= upper; ++k)
+                    {
+                        bins += std::abs(frame.getBins()[k]);
+                    }
+                    CHECK_NEAR(detector.getFrequencyMagnitude(input_0.data(), N, target, tolerance), bins,
+                               1e-4f * (bins + 1.0f));
+
+                    float fftLevels[2];
+                    float goertzelLevels[2];
+                    fft.getFrequencyMagnitudes(inputs, 2, N, target, tolerance, fftLevels);
+                    goertzel.getFrequencyMagnitudes(inputs, 2, N, target, tolerance, goertzelLevels);
+                    CHECK_NEAR(goertzelLevels[0], fftLevels[0], 1e-4f * (fftLevels[0] + 1.0f));
+                    CHECK_NEAR(goertzelLevels[1], fftLevels[1], 1e-4f * (fftLevels[1] + 1.0f));
+                }
+            }
+        }
+    }
+
+    return finish("test_goertzel");
+}
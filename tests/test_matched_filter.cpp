@@ -0,0 +1,145 @@
+// MatchedFilter against a direct time-domain correlation with the same template, and a burst fed
+// through StreamingSTFT as master_ping does: found once, at its start sample and amplitude, with
+// the same result for two frame sizes.
+#include "matched_filter.h"
+#include "streaming_stft.h"
+#include "test_common.h"
+#include <algorithm>
+#include <complex>
+#include <random>
+#include <vector>
+
+static const float kSampleRate = 96000.0f;
+static const float kFrequency = 14080.0f;
+static const float kDuration = 0.004f;
+
+// |sum_m x[n + m] * conj(t[m])| scaled so a steady tone reads its amplitude
+static float directEnvelope(const float* x, size_t n, WindowType window, size_t length)
+{
+    std::complex<double> sum(0.0, 0.0);
+    double windowSum = 0.0;
+    const double step = 2.0 * M_PI * kFrequency / kSampleRate;
+    for (size_t m = 0; m < length; ++m)
+    {
+        const double w = WindowCache::value(window, m, length, 8.6f);
+        sum += (double)x[n + m] * std::polar(w, -step * m);
+        windowSum += w;
+    }
+    return (float)(2.0 * std::abs(sum) / windowSum);
+}
+
+static void addBurst(std::vector<float>& signal, size_t start, size_t length, float amplitude)
+{
+    for (size_t m = 0; m < length && start + m < signal.size(); ++m)
+    {
+        signal[start + m] += amplitude * sinf(2.0f * (float)M_PI * kFrequency * m / kSampleRate + 0.3f);
+    }
+}
+
+// Streams the signal through framing and the filter; returns the number of peaks, the first in peak
+static size_t streamPeaks(const std::vector<float>& signal, size_t frameSize, float threshold,
+                          MatchedFilter::Peak& peak)
+{
+    MatchedFilter filter(kSampleRate, frameSize, 2, kFrequency, kDuration);
+    filter.setThreshold(0, threshold);
+    filter.setThreshold(1, threshold);
+    StreamingSTFT frames(2, frameSize, filter.getHopSize(), 2);
+    std::vector<float> frame_0(frameSize);
+    std::vector<float> frame_1(frameSize);
+    float* const buffers[2] = {frame_0.data(), frame_1.data()};
+
+    size_t peaks = 0;
+    for (float value : signal)
+    {
+        const float samples[2] = {value, 0.5f * value};
+        frames.push(samples);
+        if (frames.readFrame(buffers))
+        {
+            filter.process(buffers, frames.getFrameStartSample());
+            for (size_t i = 0; i < filter.getNumPeaks(); ++i)
+            {
+                if (filter.getPeak(i).channel == 0)
+                {
+                    if (peaks == 0)
+                    {
+                        peak = filter.getPeak(i);
+                    }
+                    ++peaks;
+                }
+                else
+                {
+                    CHECK_NEAR(filter.getPeak(i).level, 0.5f * peak.level, 1e-3f);
+                }
+            }
+        }
+    }
+    return peaks;
+}
+
+int main()
+{
+    std::mt19937 rng(5);
+    std::normal_distribution<float> gaussian(0.0f, 0.1f);
+    const size_t frameSize = 1024;
+
+    // One frame of noise with a burst: the envelope equals the direct correlation
+    const WindowType windows[] = {WindowType::Rectangular, WindowType::Hann};
+    for (WindowType window : windows)
+    {
+        MatchedFilter filter(kSampleRate, frameSize, 2, kFrequency, kDuration, window);
+        std::vector<float> frame_0(frameSize);
+        std::vector<float> frame_1(frameSize);
+        for (size_t i = 0; i < frameSize; ++i)
+        {
+            frame_0[i] = gaussian(rng);
+            frame_1[i] = gaussian(rng);
+        }
+        std::vector<float> burst(frameSize, 0.0f);
+        addBurst(burst, 200, filter.getTemplateLength(), 1.0f);
+        for (size_t i = 0; i < frameSize; ++i)
+        {
+            frame_0[i] += burst[i];
+        }
+        const float* frames[2] = {frame_0.data(), frame_1.data()};
+        filter.process(frames, 0);
+
+        float worst = 0.0f;
+        for (size_t c = 0; c < 2; ++c)
+        {
+            const float* x = c == 0 ? frame_0.data() : frame_1.data();
+            for (size_t n = 0; n < filter.getHopSize(); ++n)
+            {
+                const float error = fabsf(filter.getEnvelope(c)[n] - directEnvelope(x, n, window, filter.getTemplateLength()));
+                worst = std::max(worst, error);
+            }
+        }
+        printf("  %s template: largest envelope error %.1e against the direct correlation\n",
+               window == WindowType::Rectangular ? "rectangular" : "Hann", worst);
+        CHECK(worst < (window == WindowType::Rectangular ? 1e-5f : 1e-3f));
+        CHECK_NEAR(filter.getEnvelope(0)[200], 1.0f, 0.05f);
+    }
+
+    // A streamed burst in noise: one peak at its start and amplitude, the same for both frame sizes
+    std::vector<float> signal(20000);
+    for (float& value : signal)
+    {
+        value = gaussian(rng);
+    }
+    const size_t start = 7777;
+    addBurst(signal, start, (size_t)(kDuration * kSampleRate), 0.5f);
+
+    MatchedFilter::Peak peak1024 = {};
+    MatchedFilter::Peak peak2048 = {};
+    const size_t peaks1024 = streamPeaks(signal, 1024, 0.25f, peak1024);
+    const size_t peaks2048 = streamPeaks(signal, 2048, 0.25f, peak2048);
+    printf("  burst at %zu: peak at %llu%+.2f, level %.3f\n", start, (unsigned long long)peak1024.sample,
+           peak1024.offset, peak1024.level);
+    CHECK(peaks1024 == 1);
+    CHECK(peaks2048 == 1);
+    CHECK_NEAR((double)peak1024.sample + peak1024.offset, (double)start, 2.0);
+    CHECK_NEAR(peak1024.level, 0.5f, 0.05f);
+    CHECK(peak1024.sample == peak2048.sample);
+    CHECK_NEAR(peak1024.level, peak2048.level, 1e-4f);
+
+    return finish("test_matched_filter");
+}
@@ -0,0 +1,208 @@
+// TdoaLocalizer on synthetic geometry: exact delays recover the bearing and the position, noisy
+// delays scatter the bearing as the reported standard deviation predicts, the 2D fit at a known
+// depth places the source, and a planar array reports the elevation on the configured side.
+#include "tdoa_localizer.h"
+#include "test_common.h"
+#include <algorithm>
+#include <random>
+
+static const double kSoundSpeed = GccPhat::kSoundSpeedWater;
+static const double kDegrees = 180.0 / M_PI;
+static const float kSampleRate = 96000.0f;
+
+// master_ping's planar 0.5 m square
+static const double kSquare[4][3] = {{0.25, 0.25, 0.0}, {-0.25, 0.25, 0.0}, {0.25, -0.25, 0.0}, {-0.25, -0.25, 0.0}};
+
+// A volume array: the square plus hydrophones above and below it
+static const double kVolume[6][3] = {{0.25, 0.25, 0.0},  {-0.25, 0.25, 0.0}, {0.25, -0.25, 0.0},
+                                     {-0.25, -0.25, 0.0}, {0.0, 0.0, 0.4},    {0.1, -0.1, -0.4}};
+
+template <size_t N>
+static void place(TdoaLocalizer& localizer, const double (&array)[N][3])
+{
+    for (size_t i = 0; i < N; ++i)
+    {
+        localizer.setHydrophone(i, (float)array[i][0], (float)array[i][1], (float)array[i][2]);
+    }
+}
+
+// Plane-wave delays after hydrophone 0 for a source in direction (azimuth, elevation)
+template <size_t N>
+static void bearingDelays(const double (&array)[N][3], double azimuth, double elevation, float* delays)
+{
+    const double u[3] = {cos(elevation) * cos(azimuth), cos(elevation) * sin(azimuth), sin(elevation)};
+    for (size_t i = 0; i < N; ++i)
+    {
+        double projection = 0.0;
+        for (size_t d = 0; d < 3; ++d)
+        {
+            projection += (array[i][d] - array[0][d]) * u[d];
+        }
+        delays[i] = (float)(-projection / kSoundSpeed);
+    }
+}
+
+// Spherical-wave delays after hydrophone 0 for a source at position
+template <size_t N>
+static void positionDelays(const double (&array)[N][3], const double* position, float* delays)
+{
+    double range[N];
+    for (size_t i = 0; i < N; ++i)
+    {
+        double sum = 0.0;
+        for (size_t d = 0; d < 3; ++d)
+        {
+            sum += (position[d] - array[i][d]) * (position[d] - array[i][d]);
+        }
+        range[i] = sqrt(sum);
+    }
+    for (size_t i = 0; i < N; ++i)
+    {
+        delays[i] = (float)((range[i] - range[0]) / kSoundSpeed);
+    }
+}
+
+// Azimuth difference wrapped to [-pi, pi)
+static double angleError(double a, double b)
+{
+    return remainder(a - b, 2.0 * M_PI);
+}
+
+int main()
+{
+    float delays[TdoaLocalizer::kMaxHydrophones];
+
+    // Noise-free bearing on the volume array, all around and above and below
+    {
+        TdoaLocalizer localizer(6);
+        place(localizer, kVolume);
+        double worst = 0.0;
+        for (int a = -170; a <= 180; a += 25)
+        {
+            for (int e = -70; e <= 70; e += 35)
+            {
+                bearingDelays(kVolume, a / kDegrees, e / kDegrees, delays);
+                CHECK(localizer.solveBearing(delays));
+                worst = std::max(worst, fabs(angleError(localizer.getAzimuth(), a / kDegrees)));
+                worst = std::max(worst, fabs(localizer.getElevation() - e / kDegrees));
+            }
+        }
+        printf("  bearing, exact delays: largest angle error %.1e deg\n", worst * kDegrees);
+        CHECK(worst * kDegrees < 0.01);
+    }
+
+    // Noise-free position on the volume array
+    {
+        TdoaLocalizer localizer(6);
+        place(localizer, kVolume);
+        const double sources[][3] = {{3.0, -2.0, -1.5}, {-1.0, 4.0, 2.0}, {0.5, 0.5, -6.0}};
+        double worst = 0.0;
+        for (const double* source : sources)
+        {
+            positionDelays(kVolume, source, delays);
+            CHECK(localizer.solvePosition(delays, 3));
+            worst = std::max(worst, fabs(localizer.getX() - source[0]));
+            worst = std::max(worst, fabs(localizer.getY() - source[1]));
+            worst = std::max(worst, fabs(localizer.getZ() - source[2]));
+        }
+        printf("  position, exact delays: largest coordinate error %.1e m\n", worst);
+        CHECK(worst < 0.01);
+    }
+
+    // Noisy bearing on master_ping's square: the scatter matches the reported standard deviation
+    {
+        TdoaLocalizer localizer(4);
+        place(localizer, kSquare);
+        const float sigma = 1.0f / kSampleRate;
+        localizer.setTimingAccuracy(sigma);
+        const double azimuth = 40.0 / kDegrees;
+        const double elevation = -35.0 / kDegrees;
+        float exact[4];
+        bearingDelays(kSquare, azimuth, elevation, exact);
+
+        std::mt19937 rng(3);
+        std::normal_distribution<float> noise(0.0f, sigma);
+        const int trials = 4000;
+        double azimuthSquares = 0.0;
+        double elevationSquares = 0.0;
+        int solved = 0;
+        for (int t = 0; t < trials; ++t)
+        {
+            for (size_t i = 1; i < 4; ++i)
+            {
+                delays[i] = exact[i] + noise(rng);
+            }
+            delays[0] = 0.0f;
+            if (localizer.solveBearing(delays))
+            {
+                azimuthSquares += pow(angleError(localizer.getAzimuth(), azimuth), 2);
+                elevationSquares += pow(localizer.getElevation() - elevation, 2);
+                ++solved;
+            }
+        }
+        // The prediction at the true delays (the timing accuracy sets the scale there)
+        CHECK(localizer.solveBearing(exact));
+        const double azimuthStd = localizer.getAzimuthStd();
+        const double elevationStd = localizer.getElevationStd();
+
+        const double azimuthScatter = sqrt(azimuthSquares / solved);
+        const double elevationScatter = sqrt(elevationSquares / solved);
+        printf("  bearing, 1-sample timing noise: azimuth %.2f deg (predicted %.2f), elevation %.2f deg "
+               "(predicted %.2f), %d of %d solved\n",
+               azimuthScatter * kDegrees, azimuthStd * kDegrees, elevationScatter * kDegrees, elevationStd * kDegrees,
+               solved, trials);
+        CHECK(solved > trials * 99 / 100);
+        CHECK(azimuthScatter > 0.8 * azimuthStd && azimuthScatter < 1.25 * azimuthStd);
+        CHECK(elevationScatter > 0.8 * elevationStd && elevationScatter < 1.25 * elevationStd);
+    }
+
+    // 2D fit at a known depth on the planar square
+    {
+        TdoaLocalizer localizer(4);
+        place(localizer, kSquare);
+        const double source[3] = {4.0, -3.0, -2.5};
+        positionDelays(kSquare, source, delays);
+        CHECK(localizer.solvePosition(delays, 2, (float)source[2]));
+        printf("  2D fit at %.1f m depth: (%.3f, %.3f, %.3f) m for (%.1f, %.1f, %.1f)\n", source[2], localizer.getX(),
+               localizer.getY(), localizer.getZ(), source[0], source[1], source[2]);
+        CHECK_NEAR(localizer.getX(), source[0], 0.05);
+        CHECK_NEAR(localizer.getY(), source[1], 0.05);
+        CHECK(localizer.getZ() == (float)source[2]);
+        CHECK(localizer.getNumParameters() == 2);
+    }
+
+    // Planar elevation sign: the same delays read below or above the plane as configured
+    {
+        TdoaLocalizer localizer(4);
+        place(localizer, kSquare);
+        const double azimuth = -120.0 / kDegrees;
+        const double elevation = -25.0 / kDegrees;
+        bearingDelays(kSquare, azimuth, elevation, delays);
+
+        CHECK(localizer.solveBearing(delays));
+        CHECK_NEAR(angleError(localizer.getAzimuth(), azimuth), 0.0, 1e-3);
+        CHECK_NEAR(localizer.getElevation(), elevation, 1e-3);
+
+        localizer.setBelowPlane(false);
+        CHECK(localizer.solveBearing(delays));
+        CHECK_NEAR(angleError(localizer.getAzimuth(), azimuth), 0.0, 1e-3);
+        CHECK_NEAR(localizer.getElevation(), -elevation, 1e-3);
+    }
+
+    // Too few hydrophones, and a source beyond the maximum range, are refused
+    {
+        TdoaLocalizer pair(2);
+        CHECK(!pair.solveBearing(delays));
+
+        TdoaLocalizer localizer(6);
+        place(localizer, kVolume);
+        localizer.setMaxRange(5.0f);
+        const double source[3] = {8.0, 6.0, -3.0};
+        positionDelays(kVolume, source, delays);
+        CHECK(!localizer.solvePosition(delays, 3));
+        localizer.setMaxRange(100.0f);
+        CHECK(localizer.solvePosition(delays, 3));
+    }
+
+    return finish("test_tdoa_localizer");
+}
@@ -0,0 +1,55 @@
+// WindowCache is shared: equal windows across FFTLibrary and GoertzelDetector instances are one
+// table, and a full cache shows up in FFTLibrary::isValid() at setup instead of as a level on
+// another scale.
+#include "fft_library.h"
+#include "test_common.h"
+#include <vector>
+
+static const float kSampleRate = 96000.0f;
+
+int main()
+{
+    // Two libraries and a Goertzel detector with the same window and size share one table
+    FFTLibrary first(kSampleRate, 1024);
+    FFTLibrary second(kSampleRate, 1024);
+    first.setMagnitudeBackend(FFTLibrary::MagnitudeBackend::Goertzel);
+    GoertzelDetector goertzel(kSampleRate);
+    CHECK(goertzel.prepare(1024));
+    CHECK(first.getWindowTable(1024) == second.getWindowTable(1024));
+    CHECK(first.getWindowTable(1024) == WindowCache::shared().get(WindowType::Hann, 1024));
+    CHECK(first.isValid() && second.isValid());
+
+    // A calibrated level to compare against once the cache is full
+    std::vector<float> tone(1024);
+    for (size_t i = 0; i < tone.size(); ++i)
+    {
+        tone[i] = 0.5f * sinf(2.0f * (float)M_PI * 25000.0f * i / kSampleRate);
+    }
+    const float level = second.getFrequencyMagnitude(tone.data(), tone.size(), 25000.0f, 0.01f);
+    CHECK(level > 0.0f);
+
+    // Fill the cache with other sizes
+    size_t built = 1;
+    for (size_t size = 16; built < WindowCache::kMaxTables; size += 16)
+    {
+        if (size != 1024 && WindowCache::shared().get(WindowType::Hann, size) != nullptr)
+        {
+            ++built;
+        }
+    }
+    CHECK(WindowCache::shared().get(WindowType::Hann, 4096) == nullptr);
+
+    // Existing tables keep working; a library that needs a new one reports it at setup
+    FFTLibrary third(kSampleRate, 1024);
+    CHECK(third.isValid());
+    CHECK(third.getFrequencyMagnitude(tone.data(), tone.size(), 25000.0f, 0.01f) == level);
+    third.setWindow(WindowType::BlackmanHarris);
+    CHECK(!third.isValid());
+    CHECK(third.getFrequencyMagnitude(tone.data(), tone.size(), 25000.0f, 0.01f) == 0.0f);
+
+    FFTLibrary fourth(kSampleRate, 2048);
+    CHECK(!fourth.isValid());
+    CHECK(second.isValid());
+
+    return finish("test_window_cache");
+}